@@ -0,0 +1,628 @@
+/**
+ * @file loopbackServer.hpp
+ * @brief A minimal HTTP/1.1 server on 127.0.0.1 for the benchmarks and tests
+ * @author moehoshio
+ * @copyright Copyright (c) 2025 Hoshi
+ * @license MIT OR Apache-2.0
+ * @note Serves generated content from memory, with keep-alive, HEAD and single byte ranges. Not a general purpose server.
+ */
+
+#pragma once
+
+#include <neko/schema/types.hpp>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// C++ STL
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+namespace neko::network::bench {
+
+    /**
+     * @class LoopbackServer
+     * @brief Listens on an ephemeral port of 127.0.0.1 and answers on a thread per connection.
+     * @note Routes:
+     *       - GET /small: a 64 byte body, for request latency
+     *       - GET, HEAD /object: objectSize bytes with an ETag, Accept-Ranges and Range support, for downloads
+     *       - GET /nohead: like /object, but HEAD is answered with 405, for the range probe fallback
+     *       - GET, HEAD /straggler: like /object, but a response starting at byte 0 trickles at 80KB/s, for work stealing
+     *       - GET /bytes/<n>: n bytes, for response sizes
+     *       - GET /slow/<ms>: "response <i>" after ms milliseconds, i counting the requests served, for coalescing
+     *       - GET /first-slow/<ms>: like /slow, but only the first request on it waits, and only until its client
+     *         hangs up (counted by abandoned()), for hedging
+     *       - GET /status/<code>: an empty response with that status, 429 and 503 with Retry-After: 1, for retries
+     *       - GET /cached/<s>: a small body with Cache-Control: max-age=s and an ETag; If-None-Match with the ETag
+     *         gets a 304 with two Link fields and X-Revalidated, for the response cache
+     *       - GET /echo: the header fields of the request as the body, for request headers
+     *       - GET /gzip: gzipBody, sent with Content-Encoding: gzip if the request accepts it, for response decoding
+     *       - POST and PUT on any of them read and drop the request body first, by Content-Length or chunked,
+     *         answering Expect: 100-continue
+     * @note Bodies repeat a 1MB pattern, so a large object needs no memory of its own.
+     *       Past one buffer per connection, answering a request allocates nothing, so allocation counts show the client.
+     */
+    class LoopbackServer {
+    public:
+        explicit LoopbackServer(neko::uint64 objectSize) : objectSize(objectSize), pattern(patternSize) {
+            for (std::size_t i = 0; i < patternSize; ++i) {
+                pattern[i] = static_cast<char>((i * 31 + 7) & 0xff);
+            }
+#if defined(_WIN32)
+            WSADATA data;
+            WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+            listener = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if (listener == invalidSocket)
+                throw std::runtime_error("LoopbackServer: socket failed");
+            int reuse = 1;
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&reuse), sizeof(reuse));
+
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = 0;
+            socklen_t length = sizeof(address);
+            if (::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+                ::listen(listener, 128) != 0 ||
+                ::getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length) != 0) {
+                closeSocket(listener);
+                throw std::runtime_error("LoopbackServer: cannot listen on 127.0.0.1");
+            }
+            listenPort = ntohs(address.sin_port);
+            acceptThread = std::thread([this] { acceptLoop(); });
+        }
+
+        ~LoopbackServer() {
+            stopping.store(true);
+            shutdownSocket(listener);
+            closeSocket(listener);
+            acceptThread.join();
+
+            std::vector<std::thread> threads;
+            {
+                std::lock_guard<std::mutex> lock(clientsMutex);
+                for (Socket client : clients) {
+                    shutdownSocket(client);
+                }
+                threads.swap(clientThreads);
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+#if defined(_WIN32)
+            WSACleanup();
+#endif
+        }
+
+        // The decoded body of /gzip
+        static constexpr std::string_view gzipBody = "A body sent gzip encoded to clients that accept it.";
+
+        LoopbackServer(const LoopbackServer &) = delete;
+        LoopbackServer &operator=(const LoopbackServer &) = delete;
+
+        std::string url(std::string_view path) const {
+            return "http://127.0.0.1:" + std::to_string(listenPort) + std::string(path);
+        }
+
+        neko::uint64 getObjectSize() const {
+            return objectSize;
+        }
+
+        // Connections accepted so far, fewer than requests when connections are reused
+        neko::uint64 connections() const {
+            return accepted.load(std::memory_order_relaxed);
+        }
+
+        // Requests answered so far, on any route
+        neko::uint64 requests() const {
+            return served.load(std::memory_order_relaxed);
+        }
+
+        // Body bytes sent so far, to tell how much of an object a download fetched
+        neko::uint64 bodyBytes() const {
+            return bodySent.load(std::memory_order_relaxed);
+        }
+
+        // Responses of /first-slow that were not sent because the client hung up while waiting
+        neko::uint64 abandoned() const {
+            return abandonedResponses.load(std::memory_order_relaxed);
+        }
+
+        // Request body bytes received so far, to tell how much of an upload arrived
+        neko::uint64 requestBodyBytes() const {
+            return bodyReceived.load(std::memory_order_relaxed);
+        }
+
+    private:
+#if defined(_WIN32)
+        using Socket = SOCKET;
+        using socklen_t = int;
+        static constexpr Socket invalidSocket = INVALID_SOCKET;
+        static void closeSocket(Socket socket) { ::closesocket(socket); }
+        static void shutdownSocket(Socket socket) { ::shutdown(socket, SD_BOTH); }
+#else
+        using Socket = int;
+        static constexpr Socket invalidSocket = -1;
+        static void closeSocket(Socket socket) { ::close(socket); }
+        static void shutdownSocket(Socket socket) { ::shutdown(socket, SHUT_RDWR); }
+#endif
+
+        static constexpr std::size_t patternSize = 1024 * 1024;
+        static constexpr std::size_t maxHeaderSize = 16 * 1024;
+
+        struct Request {
+            std::string_view method;
+            std::string_view path;
+            std::string_view range;
+            std::string_view ifNoneMatch;
+            std::string_view acceptEncoding;
+            // The header lines after the request line
+            std::string_view fields;
+            neko::uint64 contentLength = 0;
+            bool chunked = false;
+            bool expectContinue = false;
+            bool close = false;
+        };
+
+        void acceptLoop() {
+            while (!stopping.load()) {
+                Socket client = ::accept(listener, nullptr, nullptr);
+                if (client == invalidSocket)
+                    continue; // Woken by the destructor, or a failed connection
+                if (stopping.load()) {
+                    closeSocket(client);
+                    break;
+                }
+                int noDelay = 1;
+                setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&noDelay), sizeof(noDelay));
+                accepted.fetch_add(1, std::memory_order_relaxed);
+
+                // Join the threads of closed connections, so a connection per request does not pile them up
+                std::vector<std::thread> finished;
+                {
+                    std::lock_guard<std::mutex> lock(clientsMutex);
+                    for (auto id : finishedThreads) {
+                        auto it = std::find_if(clientThreads.begin(), clientThreads.end(), [id](const std::thread &thread) {
+                            return thread.get_id() == id;
+                        });
+                        finished.push_back(std::move(*it));
+                        clientThreads.erase(it);
+                    }
+                    finishedThreads.clear();
+                    clients.push_back(client);
+                    clientThreads.emplace_back([this, client] { serve(client); });
+                }
+                for (auto &thread : finished) {
+                    thread.join();
+                }
+            }
+        }
+
+        void serve(Socket client) {
+            std::vector<char> buffer(maxHeaderSize);
+            std::size_t filled = 0;
+            bool open = true;
+            while (open && !stopping.load()) {
+                // Read until the end of the headers
+                std::size_t headerEnd = 0;
+                while ((headerEnd = findHeaderEnd(buffer.data(), filled)) == 0) {
+                    if (filled == buffer.size())
+                        open = false; // Headers too large
+                    int received = open ? static_cast<int>(::recv(client, buffer.data() + filled, static_cast<int>(buffer.size() - filled), 0)) : 0;
+                    if (received <= 0) {
+                        open = false;
+                        break;
+                    }
+                    filled += static_cast<std::size_t>(received);
+                }
+                if (!open)
+                    break;
+
+                Request request = parse(std::string_view(buffer.data(), headerEnd));
+                // Drop the request body, part of which may already be in the buffer
+                std::size_t position = headerEnd;
+                auto receive = [&](char *out, std::size_t size) -> std::size_t {
+                    if (position < filled) {
+                        std::size_t taken = std::min(size, filled - position);
+                        std::memcpy(out, buffer.data() + position, taken);
+                        position += taken;
+                        return taken;
+                    }
+                    int received = static_cast<int>(::recv(client, out, static_cast<int>(size), 0));
+                    return received > 0 ? static_cast<std::size_t>(received) : 0;
+                };
+                if (request.expectContinue && (request.contentLength > 0 || request.chunked))
+                    open = sendAll(client, "HTTP/1.1 100 Continue\r\n\r\n", 25);
+                open = open && (request.chunked ? dropChunkedBody(receive) : dropBody(receive, request.contentLength));
+                if (!open)
+                    break;
+
+                open = respond(client, request) && !request.close;
+                // Keep what the client already sent of the next request
+                std::memmove(buffer.data(), buffer.data() + position, filled - position);
+                filled -= position;
+            }
+
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            for (auto it = clients.begin(); it != clients.end(); ++it) {
+                if (*it == client) {
+                    clients.erase(it);
+                    break;
+                }
+            }
+            closeSocket(client);
+            // Started under the lock, so the thread is already in clientThreads
+            finishedThreads.push_back(std::this_thread::get_id());
+        }
+
+        // Read and count size body bytes, false if the connection closed first
+        template <typename Receive>
+        bool dropBody(Receive &receive, neko::uint64 size) {
+            char sink[4096];
+            while (size > 0) {
+                std::size_t received = receive(sink, static_cast<std::size_t>(std::min<neko::uint64>(size, sizeof(sink))));
+                if (received == 0)
+                    return false;
+                bodyReceived.fetch_add(received, std::memory_order_relaxed);
+                size -= received;
+            }
+            return true;
+        }
+
+        // Read a Transfer-Encoding: chunked body up to and including its trailer
+        template <typename Receive>
+        bool dropChunkedBody(Receive &receive) {
+            std::string line;
+            auto readLine = [&]() {
+                line.clear();
+                char c = 0;
+                while (line.size() < maxHeaderSize && receive(&c, 1) == 1) {
+                    if (c == '\n') {
+                        if (!line.empty() && line.back() == '\r')
+                            line.pop_back();
+                        return true;
+                    }
+                    line.push_back(c);
+                }
+                return false;
+            };
+            while (readLine()) {
+                neko::uint64 size = 0;
+                if (std::from_chars(line.data(), line.data() + line.size(), size, 16).ec != std::errc())
+                    return false;
+                if (size == 0) {
+                    // Trailer fields up to the blank line
+                    while (readLine()) {
+                        if (line.empty())
+                            return true;
+                    }
+                    return false;
+                }
+                if (!dropBody(receive, size) || !readLine())
+                    return false;
+            }
+            return false;
+        }
+
+        // Size of the header block including the blank line, 0 if it is incomplete
+        static std::size_t findHeaderEnd(const char *data, std::size_t size) {
+            std::string_view view(data, size);
+            std::size_t end = view.find("\r\n\r\n");
+            return end == std::string_view::npos ? 0 : end + 4;
+        }
+
+        static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+            if (a.size() != b.size())
+                return false;
+            for (std::size_t i = 0; i < a.size(); ++i) {
+                char x = a[i], y = b[i];
+                if (x >= 'A' && x <= 'Z')
+                    x = static_cast<char>(x - 'A' + 'a');
+                if (y >= 'A' && y <= 'Z')
+                    y = static_cast<char>(y - 'A' + 'a');
+                if (x != y)
+                    return false;
+            }
+            return true;
+        }
+
+        static Request parse(std::string_view head) {
+            Request request;
+            std::size_t lineEnd = head.find("\r\n");
+            std::string_view line = head.substr(0, lineEnd);
+            std::size_t space = line.find(' ');
+            request.method = line.substr(0, space);
+            line.remove_prefix(space == std::string_view::npos ? line.size() : space + 1);
+            request.path = line.substr(0, line.find(' '));
+
+            head.remove_prefix(lineEnd + 2);
+            request.fields = head;
+            while (!head.empty()) {
+                lineEnd = head.find("\r\n");
+                line = head.substr(0, lineEnd);
+                head.remove_prefix(lineEnd == std::string_view::npos ? head.size() : lineEnd + 2);
+
+                std::size_t colon = line.find(':');
+                if (colon == std::string_view::npos)
+                    continue;
+                std::string_view name = line.substr(0, colon);
+                std::string_view value = line.substr(colon + 1);
+                while (!value.empty() && value.front() == ' ')
+                    value.remove_prefix(1);
+
+                if (equalsIgnoreCase(name, "Range")) {
+                    request.range = value;
+                } else if (equalsIgnoreCase(name, "Accept-Encoding")) {
+                    request.acceptEncoding = value;
+                } else if (equalsIgnoreCase(name, "If-None-Match")) {
+                    request.ifNoneMatch = value;
+                } else if (equalsIgnoreCase(name, "Content-Length")) {
+                    std::from_chars(value.data(), value.data() + value.size(), request.contentLength);
+                } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+                    request.chunked = equalsIgnoreCase(value, "chunked");
+                } else if (equalsIgnoreCase(name, "Expect")) {
+                    request.expectContinue = equalsIgnoreCase(value, "100-continue");
+                } else if (equalsIgnoreCase(name, "Connection")) {
+                    request.close = equalsIgnoreCase(value, "close");
+                }
+            }
+            return request;
+        }
+
+        // "bytes=first-last" or "bytes=first-" within size
+        static std::optional<std::pair<neko::uint64, neko::uint64>> parseRange(std::string_view range, neko::uint64 size) {
+            constexpr std::string_view prefix = "bytes=";
+            if (range.substr(0, prefix.size()) != prefix || size == 0)
+                return std::nullopt;
+            range.remove_prefix(prefix.size());
+            std::size_t dash = range.find('-');
+            if (dash == std::string_view::npos || dash == 0)
+                return std::nullopt;
+
+            neko::uint64 first = 0, last = size - 1;
+            if (std::from_chars(range.data(), range.data() + dash, first).ec != std::errc())
+                return std::nullopt;
+            if (dash + 1 < range.size() &&
+                std::from_chars(range.data() + dash + 1, range.data() + range.size(), last).ec != std::errc())
+                return std::nullopt;
+            if (first >= size || last < first)
+                return std::nullopt;
+            return std::make_pair(first, std::min(last, size - 1));
+        }
+
+        bool respond(Socket client, const Request &request) {
+            neko::uint64 number = served.fetch_add(1, std::memory_order_relaxed) + 1;
+            bool head = request.method == "HEAD";
+            std::string_view path = request.path.substr(0, request.path.find('?'));
+
+            if (path.substr(0, 6) == "/slow/") {
+                unsigned delay = 0;
+                std::from_chars(path.data() + 6, path.data() + path.size(), delay);
+                std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+                return sendText(client, "200 OK", "", "response " + std::to_string(number), head);
+            }
+            if (path.substr(0, 12) == "/first-slow/") {
+                unsigned delay = 0;
+                std::from_chars(path.data() + 12, path.data() + path.size(), delay);
+                if (!firstSlowTaken.exchange(true)) {
+                    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(delay);
+                    while (std::chrono::steady_clock::now() < until) {
+                        if (hungUp(client)) {
+                            abandonedResponses.fetch_add(1, std::memory_order_relaxed);
+                            return false;
+                        }
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    }
+                }
+                return sendText(client, "200 OK", "", "response " + std::to_string(number), head);
+            }
+            if (path.substr(0, 8) == "/status/") {
+                std::string status(path.substr(8));
+                bool retryAfter = status == "429" || status == "503";
+                return sendText(client, (status + " Status").c_str(), retryAfter ? "Retry-After: 1\r\n" : "", "", head);
+            }
+            if (path == "/echo")
+                return sendText(client, "200 OK", "", std::string(request.fields), head);
+            if (path == "/gzip") {
+                if (request.acceptEncoding.find("gzip") == std::string_view::npos)
+                    return sendText(client, "200 OK", "", std::string(gzipBody), head);
+                return sendText(client, "200 OK", "Content-Encoding: gzip\r\n", gzip(gzipBody), head);
+            }
+            if (path.substr(0, 8) == "/cached/") {
+                std::string fields = "Cache-Control: max-age=" + std::string(path.substr(8)) + "\r\nETag: \"v1\"\r\n";
+                if (request.ifNoneMatch == "\"v1\"")
+                    return sendText(client, "304 Not Modified", fields + "Link: </a>; rel=a\r\nLink: </b>; rel=b\r\nX-Revalidated: yes\r\n", "", true);
+                return sendText(client, "200 OK", fields + "Link: </old>; rel=old\r\n", "cached body", head);
+            }
+
+            neko::uint64 size = 0;
+            bool ranges = false;
+            bool trickle = false;
+            if (path == "/small") {
+                size = 64;
+            } else if (path == "/object" || path == "/straggler" || path == "/nohead") {
+                if (head && path == "/nohead")
+                    return sendHeader(client, "405 Method Not Allowed", 0, 0, 0, false);
+                size = objectSize;
+                ranges = true;
+                trickle = path == "/straggler";
+            } else if (path.substr(0, 7) == "/bytes/") {
+                std::from_chars(path.data() + 7, path.data() + path.size(), size);
+            } else {
+                return sendHeader(client, "404 Not Found", 0, 0, 0, false);
+            }
+
+            neko::uint64 first = 0, length = size;
+            const char *status = "200 OK";
+            if (ranges && !request.range.empty()) {
+                auto range = parseRange(request.range, size);
+                if (!range)
+                    return sendHeader(client, "416 Range Not Satisfiable", 0, 0, size, true);
+                first = range->first;
+                length = range->second - range->first + 1;
+                status = "206 Partial Content";
+            }
+
+            if (!sendHeader(client, status, length, first, size, ranges))
+                return false;
+            if (head)
+                return true;
+            return trickle && first == 0 ? trickleBody(client, length) : sendBody(client, first, length);
+        }
+
+        bool sendHeader(Socket client, const char *status, neko::uint64 length, neko::uint64 first, neko::uint64 total, bool ranges) {
+            char header[512];
+            int size = std::snprintf(header, sizeof(header),
+                                     "HTTP/1.1 %s\r\nContent-Length: %llu\r\nContent-Type: application/octet-stream\r\n",
+                                     status, static_cast<unsigned long long>(length));
+            if (ranges) {
+                size += std::snprintf(header + size, sizeof(header) - size, "Accept-Ranges: bytes\r\nETag: \"loopback-%llu\"\r\n",
+                                      static_cast<unsigned long long>(total));
+                if (std::strncmp(status, "206", 3) == 0) {
+                    size += std::snprintf(header + size, sizeof(header) - size, "Content-Range: bytes %llu-%llu/%llu\r\n",
+                                          static_cast<unsigned long long>(first), static_cast<unsigned long long>(first + length - 1),
+                                          static_cast<unsigned long long>(total));
+                } else if (std::strncmp(status, "416", 3) == 0) {
+                    size += std::snprintf(header + size, sizeof(header) - size, "Content-Range: bytes */%llu\r\n",
+                                          static_cast<unsigned long long>(total));
+                }
+            }
+            size += std::snprintf(header + size, sizeof(header) - size, "\r\n");
+            return sendAll(client, header, static_cast<std::size_t>(size));
+        }
+
+        // A response with a generated body; fields are complete header lines
+        bool sendText(Socket client, const char *status, const std::string &fields, const std::string &body, bool head) {
+            std::string response = "HTTP/1.1 " + std::string(status) + "\r\n";
+            if (std::strncmp(status, "304", 3) != 0)
+                response += "Content-Length: " + std::to_string(body.size()) + "\r\nContent-Type: text/plain\r\n";
+            response += fields + "\r\n";
+            if (!head) {
+                response += body;
+                bodySent.fetch_add(body.size(), std::memory_order_relaxed);
+            }
+            return sendAll(client, response.data(), response.size());
+        }
+
+        // Whether the client closed the connection, without waiting
+        static bool hungUp(Socket client) {
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(client, &readable);
+            timeval noWait{};
+            if (::select(static_cast<int>(client) + 1, &readable, nullptr, nullptr, &noWait) <= 0)
+                return false;
+            char byte = 0;
+            return ::recv(client, &byte, 1, MSG_PEEK) <= 0;
+        }
+
+        // A gzip member holding text in one stored (uncompressed) deflate block, text is below 64KB
+        static std::string gzip(std::string_view text) {
+            std::uint32_t crc = 0xffffffffu;
+            for (unsigned char byte : text) {
+                crc ^= byte;
+                for (int bit = 0; bit < 8; ++bit)
+                    crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+            }
+            crc ^= 0xffffffffu;
+
+            auto littleEndian = [](std::string &out, std::uint32_t value, int bytes) {
+                for (int i = 0; i < bytes; ++i)
+                    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+            };
+            auto size = static_cast<std::uint32_t>(text.size());
+            std::string out("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff\x01", 11); // Header, then a final stored block
+            littleEndian(out, size, 2);
+            littleEndian(out, ~size, 2);
+            out.append(text);
+            littleEndian(out, crc, 4);
+            littleEndian(out, size, 4);
+            return out;
+        }
+
+        // Body bytes [first, first + length) of the repeated pattern
+        bool sendBody(Socket client, neko::uint64 first, neko::uint64 length) {
+            while (length > 0) {
+                std::size_t offset = static_cast<std::size_t>(first % patternSize);
+                std::size_t chunk = static_cast<std::size_t>(std::min<neko::uint64>(length, patternSize - offset));
+                if (!sendAll(client, pattern.data() + offset, chunk))
+                    return false;
+                bodySent.fetch_add(chunk, std::memory_order_relaxed);
+                first += chunk;
+                length -= chunk;
+            }
+            return true;
+        }
+
+        // Body bytes [0, length) in 4KB pieces every 50ms, until the client hangs up
+        bool trickleBody(Socket client, neko::uint64 length) {
+            constexpr neko::uint64 piece = 4 * 1024;
+            for (neko::uint64 first = 0; first < length && !stopping.load(); first += piece) {
+                if (!sendBody(client, first, std::min(piece, length - first)))
+                    return false;
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+            return true;
+        }
+
+        static bool sendAll(Socket client, const char *data, std::size_t size) {
+#if defined(MSG_NOSIGNAL)
+            constexpr int flags = MSG_NOSIGNAL; // A client that hung up must not raise SIGPIPE
+#else
+            constexpr int flags = 0;
+#endif
+            while (size > 0) {
+                auto sent = ::send(client, data, static_cast<int>(std::min<std::size_t>(size, 1 << 30)), flags);
+                if (sent <= 0)
+                    return false;
+                data += sent;
+                size -= static_cast<std::size_t>(sent);
+            }
+            return true;
+        }
+
+        const neko::uint64 objectSize;
+        std::vector<char> pattern;
+
+        Socket listener = invalidSocket;
+        std::uint16_t listenPort = 0;
+        std::atomic<bool> stopping{false};
+        std::atomic<neko::uint64> accepted{0};
+        std::atomic<neko::uint64> served{0};
+        std::atomic<neko::uint64> bodySent{0};
+        std::atomic<neko::uint64> bodyReceived{0};
+        std::atomic<neko::uint64> abandonedResponses{0};
+        std::atomic<bool> firstSlowTaken{false};
+        std::thread acceptThread;
+
+        std::mutex clientsMutex;
+        std::vector<Socket> clients;
+        std::vector<std::thread> clientThreads;
+        // Threads of clientThreads that are done serving, joined at the next accept
+        std::vector<std::thread::id> finishedThreads;
+    };
+
+} // namespace neko::network::bench
@@ -0,0 +1,232 @@
+/**
+ * @file network_benchmark.cpp
+ * @brief Benchmarks for NekoNetwork against a loopback server
+ * @author moehoshio
+ * @copyright Copyright (c) 2025 Hoshi
+ * @license MIT OR Apache-2.0
+ * @note Set NEKO_NETWORK_BENCH_OBJECT_MB to change the size of the download object (default: 1024).
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <neko/network/network.hpp>
+
+#include "loopbackServer.hpp"
+
+// C++ STL
+#include <string>
+#include <vector>
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <new>
+
+using namespace neko::network;
+
+// ============================================================================
+// Allocation counting
+// ============================================================================
+
+// Every operator new of the process, the server's included (it allocates nothing per request).
+// libcurl allocates with malloc and is not counted.
+namespace {
+    std::atomic<neko::uint64> allocationCount{0};
+    std::atomic<neko::uint64> allocatedBytes{0};
+} // namespace
+
+// GCC sees the std::free of the replaced operator delete inlined next to a new-expression
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+    struct AllocationScope {
+        neko::uint64 count = allocationCount.load(std::memory_order_relaxed);
+        neko::uint64 bytes = allocatedBytes.load(std::memory_order_relaxed);
+
+        // Report the allocations since construction as per-iteration averages
+        void report(benchmark::State &state) const {
+            state.counters["allocs"] = benchmark::Counter(
+                static_cast<double>(allocationCount.load(std::memory_order_relaxed) - count), benchmark::Counter::kAvgIterations);
+            state.counters["allocBytes"] = benchmark::Counter(
+                static_cast<double>(allocatedBytes.load(std::memory_order_relaxed) - bytes), benchmark::Counter::kAvgIterations);
+        }
+    };
+
+    bench::LoopbackServer &server() {
+        static bench::LoopbackServer instance([] {
+            neko::uint64 megabytes = 1024;
+            if (const char *value = std::getenv("NEKO_NETWORK_BENCH_OBJECT_MB"))
+                megabytes = std::strtoull(value, nullptr, 10);
+            return megabytes * 1024 * 1024;
+        }());
+        return instance;
+    }
+
+    // Logging would dominate a loopback request
+    std::unique_ptr<Network> makeNetwork() {
+        return std::make_unique<Network>(executor::createExecutor(), std::make_shared<log::DefaultLogger>(log::Level::Off));
+    }
+
+} // namespace
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+// Latency of one small Get, with and without handle reuse (and with it the connection)
+static void BM_SmallRequest(benchmark::State &state) {
+    auto network = makeNetwork();
+    network->setMaxPooledHandles(static_cast<std::size_t>(state.range(0)));
+
+    RequestConfig config;
+    config.url = server().url("/small");
+    network->execute(config); // Warm up
+
+    neko::uint64 connections = server().connections();
+    AllocationScope allocations;
+    for (auto _ : state) {
+        auto result = network->execute(config);
+        if (!result.isSuccess()) {
+            state.SkipWithError(result.errorMessage.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(result.content.data());
+    }
+    allocations.report(state);
+    state.counters["connections"] = benchmark::Counter(
+        static_cast<double>(server().connections() - connections), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_SmallRequest)->ArgName("pooledHandles")->Arg(0)->Arg(16);
+
+// Many concurrent executeAsync requests, on executor tasks or on the curl_multi engine
+static void BM_AsyncFanOut(benchmark::State &state) {
+    auto network = makeNetwork();
+    auto engine = state.range(0) == 0 ? AsyncEngine::Executor : AsyncEngine::Multi;
+    network->setAsyncEngine(engine, 1);
+    auto fanOut = static_cast<std::size_t>(state.range(1));
+    network->setMaxPooledHandles(fanOut);
+
+    RequestConfig config;
+    config.url = server().url("/small");
+
+    std::vector<std::future<NetworkResult<std::string>>> futures;
+    futures.reserve(fanOut);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < fanOut; ++i) {
+            futures.push_back(network->executeAsync(config));
+        }
+        bool failed = false;
+        for (auto &future : futures) {
+            failed |= !future.get().isSuccess();
+        }
+        futures.clear();
+        if (failed) {
+            state.SkipWithError("Request failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * fanOut));
+}
+BENCHMARK(BM_AsyncFanOut)
+    ->ArgNames({"multi", "fanOut"})
+    ->ArgsProduct({{0, 1}, {16, 64}})
+    ->UseRealTime();
+
+// Throughput of multiThreadedDownload for the object: 0 = Direct, 1 = TempFiles, 2 = Adaptive
+static void BM_MultiThreadedDownload(benchmark::State &state) {
+    auto network = makeNetwork();
+    auto target = std::filesystem::temp_directory_path() / "neko_network_benchmark.bin";
+
+    MultiDownloadConfig config;
+    config.config.url = server().url("/object");
+    config.config.fileName = target.string();
+    config.config.method = RequestType::DownloadFile;
+    switch (state.range(0)) {
+        case 0:
+            config.approach = MultiDownloadConfig::Quantity;
+            config.segmentParam = 8;
+            config.writeMode = MultiDownloadConfig::Direct;
+            break;
+        case 1:
+            config.approach = MultiDownloadConfig::Quantity;
+            config.segmentParam = 8;
+            config.writeMode = MultiDownloadConfig::TempFiles;
+            break;
+        default:
+            config.approach = MultiDownloadConfig::Adaptive;
+            config.segmentParam = 8;
+            break;
+    }
+
+    for (auto _ : state) {
+        if (!network->multiThreadedDownload(config)) {
+            state.SkipWithError("Download failed");
+            break;
+        }
+        state.PauseTiming();
+        if (std::filesystem::file_size(target) != server().getObjectSize())
+            state.SkipWithError("Downloaded file has the wrong size");
+        std::filesystem::remove(target);
+        state.ResumeTiming();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * server().getObjectSize()));
+    std::error_code ec;
+    std::filesystem::remove(target, ec);
+}
+BENCHMARK(BM_MultiThreadedDownload)
+    ->ArgName("mode")
+    ->DenseRange(0, 2)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Allocations per Get for a response of the given size, by result type
+template <typename T>
+static void BM_ResponseAllocations(benchmark::State &state) {
+    auto network = makeNetwork();
+
+    RequestConfig config;
+    config.url = server().url("/bytes/" + std::to_string(state.range(0)));
+    network->execute<T>(config); // Warm up the handle and the buffer pool
+
+    AllocationScope allocations;
+    for (auto _ : state) {
+        auto result = network->execute<T>(config);
+        if (!result.isSuccess() || result.content.size() != static_cast<std::size_t>(state.range(0))) {
+            state.SkipWithError("Request failed");
+            break;
+        }
+        benchmark::DoNotOptimize(result.content.data());
+    }
+    allocations.report(state);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * state.range(0)));
+}
+BENCHMARK_TEMPLATE(BM_ResponseAllocations, std::string)->ArgName("bytes")->RangeMultiplier(16)->Range(1024, 4 * 1024 * 1024);
+BENCHMARK_TEMPLATE(BM_ResponseAllocations, PooledBuffer)->ArgName("bytes")->RangeMultiplier(16)->Range(1024, 4 * 1024 * 1024);
+
+BENCHMARK_MAIN();
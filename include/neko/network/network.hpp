@@ -11,19 +11,26 @@
 // Neko Module
 #include <neko/schema/types.hpp>
 
+#include <neko/network/networkBuffer.hpp>
 #include <neko/network/networkCommon.hpp>
 #include <neko/network/networkTypes.hpp>
+#include <neko/network/networkTask.hpp>
 
 // C++ STL
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include <algorithm>
+#include <atomic>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
 
 #include <functional>
 #include <optional>
+#include <type_traits>
 
 /**
  * @defgroup network Network Module
@@ -33,6 +40,8 @@ namespace neko::network {
 
     using CURL = void; // Placeholder for the actual CURL type, which is defined in the libcurl library.
 
+    class DownloadManager;
+
     /**
      * @class Network
      * @brief Network request handling class that provides various network request methods.
@@ -44,6 +53,10 @@ namespace neko::network {
             std::shared_ptr<executor::IAsyncExecutor> executor = executor::createExecutor(),
             std::shared_ptr<log::ILogger> logger = log::createLogger());
 
+        /**
+         * @brief Waits for the asynchronous requests that still run on the executor or on their own threads.
+         * @note Do not destroy a Network from one of its own completion callbacks, it would wait for itself.
+         */
         ~Network();
 
         /**
@@ -59,19 +72,141 @@ namespace neko::network {
          * @brief Execute a network request asynchronously.
          * @param config The configuration for the request
          * @return std::future<NetworkResult<T>> - A future that will contain the result of the network request when it completes.
+         * @note With AsyncEngine::Multi the request is driven by the Network's I/O threads instead of the executor.
+         * @see setAsyncEngine
          */
         template <typename T = std::string>
         std::future<NetworkResult<T>> executeAsync(const RequestConfig &config);
 
+        /**
+         * @brief Execute a network request asynchronously and deliver the result to a callback.
+         * @param config The configuration for the request
+         * @param onComplete Invoked exactly once with the result, on an executor or I/O thread.
+         * @note Unlike the future overload, nothing has to wait for the result; an exception thrown
+         *       while performing the request is reported as an error result.
+         */
+        template <typename T = std::string>
+        void executeAsync(const RequestConfig &config, std::type_identity_t<std::function<void(NetworkResult<T>)>> onComplete);
+
+        /**
+         * @brief Overloads of executeAsync that take over the config instead of copying it.
+         * @note executeAsync keeps its own copy of the config until the request is done; pass a temporary or
+         *       std::move to avoid copying the strings, callbacks and body.
+         */
+        template <typename T = std::string>
+        std::future<NetworkResult<T>> executeAsync(RequestConfig &&config);
+        template <typename T = std::string>
+        void executeAsync(RequestConfig &&config, std::type_identity_t<std::function<void(NetworkResult<T>)>> onComplete);
+
+        /**
+         * @brief Execute many requests with bounded concurrency and return their results in input order.
+         * @param requests The requests to execute
+         * @param options Limits for requests in flight overall and per host
+         * @return std::vector<NetworkResult<T>> - results[i] is the result of requests[i].
+         * @note Blocks until every request has completed. Requests run through executeAsync, so they use
+         *       the pooled handles and the selected AsyncEngine; with AsyncEngine::Multi no thread is used per request.
+         * @note Do not call this from a task of a saturated ThreadPoolExecutor that the requests also run on.
+         */
+        template <typename T = std::string>
+        std::vector<NetworkResult<T>> executeBatch(const std::vector<RequestConfig> &requests, const BatchOptions &options = {});
+
+        /**
+         * @brief Execute many requests with bounded concurrency and deliver each result as it finishes.
+         * @param onComplete Invoked once per request with its index in requests, on an executor or I/O thread.
+         *                   Calls may run concurrently; keep them short, the next request starts after it returns.
+         * @note Blocks until every request has completed and every callback has returned.
+         */
+        template <typename T = std::string>
+        void executeBatch(const std::vector<RequestConfig> &requests, const BatchOptions &options, std::type_identity_t<std::function<void(std::size_t, NetworkResult<T>)>> onComplete);
+
         /**
          * @brief Execute a network request with retry logic.
          * @param config The configuration for the request, including retry settings.
          * @return NetworkResult<T> - Returns the result of the first successful request, or the result of the last retry attempt if all retries fail.
+         * @note Waits between attempts on the calling thread. With hedging, the copies run through executeAsync.
          * @see RetryConfig for the struct that defines retry settings.
          */
         template <typename T = std::string>
         NetworkResult<T> executeWithRetry(const RetryConfig &config);
 
+        /**
+         * @brief Execute a network request with retry logic without blocking a thread.
+         * @note Attempts run through executeAsync, the waits between them on a Network-owned timer thread.
+         * @note If the Network is destroyed while waiting for a retry, the last result is delivered with an error.
+         */
+        template <typename T = std::string>
+        std::future<NetworkResult<T>> executeWithRetryAsync(const RetryConfig &config);
+        template <typename T = std::string>
+        void executeWithRetryAsync(const RetryConfig &config, std::type_identity_t<std::function<void(NetworkResult<T>)>> onComplete);
+
+        /**
+         * @brief Execute a request and receive the body into your own type through its ResponseSink<T> specialization.
+         * @return NetworkResult<T> - The result, content holds the finalized sink.
+         * @note Works for any default-constructible, movable T without changes to the library: the body is streamed
+         *       through chunkCallback and contentLengthCallback, which replace any set in config. Like any streamed
+         *       response, it is neither cached nor coalesced. The built-in types reserve in the same way through execute.
+         * @note A sink that returns false from append aborts the transfer with "Transfer aborted by ResponseSink".
+         * @see ResponseSink
+         */
+        template <ResponseSinkType T>
+        NetworkResult<T> executeInto(const RequestConfig &config) {
+            auto content = std::make_shared<T>();
+            return intoResult(execute<std::string>(sinkConfig(config, content)), std::move(*content));
+        }
+
+        /**
+         * @brief executeInto without blocking, the result is delivered to onComplete as with executeAsync.
+         */
+        template <ResponseSinkType T>
+        void executeIntoAsync(const RequestConfig &config, std::type_identity_t<std::function<void(NetworkResult<T>)>> onComplete) {
+            auto content = std::make_shared<T>();
+            executeAsync<std::string>(sinkConfig(config, content), [content, onComplete = std::move(onComplete)](NetworkResult<std::string> result) {
+                onComplete(intoResult(std::move(result), std::move(*content)));
+            });
+        }
+
+#if defined(NEKO_NETWORK_USE_COROUTINES)
+        /**
+         * @brief Execute a network request from a coroutine: co_await network.request(config).
+         * @return Task<NetworkResult<T>> - Starts the request when awaited, through executeAsync.
+         * @note No thread waits for the request: the coroutine resumes on the thread that completes it, an I/O thread
+         *       with AsyncEngine::Multi or an executor thread otherwise. Keep the work done there short.
+         * @note The Network must outlive the task.
+         * @note GCC 12 miscompiles braced aggregate temporaries in a co_await expression, so pass a named RequestConfig
+         *       rather than co_await request(RequestConfig{...}).
+         * @see whenAll, whenAny, syncWait
+         */
+        template <typename T = std::string>
+        Task<NetworkResult<T>> request(RequestConfig config) {
+            co_return co_await detail::CallbackAwaiter<NetworkResult<T>, std::function<void(std::function<void(NetworkResult<T>)>)>>(
+                [this, &config](std::function<void(NetworkResult<T>)> onComplete) {
+                    executeAsync<T>(std::move(config), std::move(onComplete));
+                });
+        }
+
+        /**
+         * @brief executeWithRetryAsync from a coroutine: co_await network.requestWithRetry(config).
+         * @see request
+         */
+        template <typename T = std::string>
+        Task<NetworkResult<T>> requestWithRetry(RetryConfig config) {
+            co_return co_await detail::CallbackAwaiter<NetworkResult<T>, std::function<void(std::function<void(NetworkResult<T>)>)>>(
+                [this, &config](std::function<void(NetworkResult<T>)> onComplete) {
+                    executeWithRetryAsync<T>(config, std::move(onComplete));
+                });
+        }
+#endif
+
+        /**
+         * @brief Limit how many retries executeWithRetry may make across all requests of this instance.
+         * @param budget The token bucket, std::nullopt (default) allows every retry.
+         * @return Network& - Reference to this instance for chaining.
+         * @note Keeps a brief outage of a backend from turning into a multiple of the load from retries.
+         * @see RetryBudget
+         */
+        Network &setRetryBudget(std::optional<RetryBudget> budget);
+        std::optional<RetryBudget> getRetryBudget() const;
+
         /**
          * @brief Perform a multi-threaded download of a file.
          * @param config The configuration for the multi-threaded download
@@ -82,6 +217,28 @@ namespace neko::network {
          */
         bool multiThreadedDownload(const MultiDownloadConfig &config);
 
+        /**
+         * @brief Fetch the size, type, validators and range support of a resource with one request.
+         * @param config The request to probe; its method, body and range are ignored, headers and proxy are used.
+         * @return std::optional<ResourceInfo> - The metadata, or std::nullopt if the request failed or the status was not 2xx.
+         * @note Sends HEAD. If the server rejects HEAD with an error status other than 404 or 410, a GET with
+         *       Range: bytes=0-0 is sent instead, and at most one body byte is read.
+         * @note With setProbeCacheTtl, successful results are cached by URL and reused by getContentSize,
+         *       getContentType, findUrlHeader and multiThreadedDownload.
+         */
+        std::optional<ResourceInfo> probe(const RequestConfig &config);
+        std::optional<ResourceInfo> probe(const std::string &url);
+
+        /**
+         * @brief Keep probe results for the given time.
+         * @param ttl How long a result is reused, 0 (default) disables the cache and drops the cached results.
+         * @return Network& - Reference to this instance for chaining.
+         * @note Cached results are keyed by URL only, regardless of the other request settings.
+         */
+        Network &setProbeCacheTtl(std::chrono::milliseconds ttl);
+        std::chrono::milliseconds getProbeCacheTtl() const;
+        void clearProbeCache();
+
         /**
          * @brief Find the URL header for a given URL.
          * @param url The URL to check
@@ -89,6 +246,7 @@ namespace neko::network {
          * @return std::optional<T> - Returns the value of the header if found,
          *                             or std::nullopt if the header is not found.
          * @note headerName is case-insensitive.
+         * @note Uses probe, so the header comes from the cached result if there is one.
          */
         template <typename T = std::string>
         std::optional<T> findUrlHeader(const std::string &url, const std::string &headerName = "Content-Type");
@@ -100,38 +258,340 @@ namespace neko::network {
         std::optional<std::string> getContentType(const std::string &url);
         std::optional<neko::uint64> getContentSize(const std::string &url);
 
+        /**
+         * @brief Set the maximum number of idle libcurl handles kept for reuse.
+         * @param maxHandles The pool capacity, 0 disables handle reuse.
+         * @return Network& - Reference to this instance for chaining.
+         * @note Reused handles keep their connection cache, TLS session and DNS cache,
+         *       so repeated requests to the same host skip the connect and handshake.
+         * @note Default is 16. Handles beyond the capacity are cleaned up when released.
+         */
+        Network &setMaxPooledHandles(std::size_t maxHandles);
+        std::size_t getMaxPooledHandles() const;
+
+        /**
+         * @brief Select the engine that drives executeAsync.
+         * @param engine AsyncEngine::Executor (default) runs each request on the IAsyncExecutor,
+         *               AsyncEngine::Multi drives all requests with curl_multi on ioThreads I/O threads.
+         * @param ioThreads Number of I/O threads for AsyncEngine::Multi, at least 1.
+         * @return Network& - Reference to this instance for chaining.
+         * @note Call this before issuing requests. Switching engines fails the requests still pending on the old one.
+         * @note With AsyncEngine::Multi, progressCallback and completion run on an I/O thread; keep them short.
+         * @note With AsyncEngine::Multi, all requests to one host run on the same I/O thread, so HTTP/2 requests share one multiplexed connection.
+         */
+        Network &setAsyncEngine(AsyncEngine engine, std::size_t ioThreads = 1);
+        AsyncEngine getAsyncEngine() const;
+
+        /**
+         * @brief Share the DNS cache and TLS sessions between all requests of this instance or of the process.
+         * @param scope ShareScope::None (default) keeps the caches per pooled handle, ShareScope::Instance shares them
+         *              between all handles of this Network, ShareScope::Process between all Networks that select it.
+         * @param shareCookies Also share cookies; this enables the in-memory cookie engine for every request.
+         * @return Network& - Reference to this instance for chaining.
+         * @note A resumed TLS session saves one round trip per new connection, a shared DNS cache saves the lookup.
+         * @note Live connections are not shared, libcurl does not support that across threads; they stay with the pooled handle.
+         * @note Requests already running keep the previous share until they finish.
+         */
+        Network &setShareScope(ShareScope scope, bool shareCookies = false);
+        ShareScope getShareScope() const;
+
+        /**
+         * @brief Keep responses of Get requests in memory and revalidate them instead of downloading them again.
+         * @param options The size of the cache, std::nullopt (default) disables it and drops the cached responses.
+         * @return Network& - Reference to this instance for chaining.
+         * @note Follows the response's Cache-Control (max-age, no-cache, no-store) or Expires. A fresh response is
+         *       returned without a request. A stale one with an ETag or Last-Modified is revalidated with
+         *       If-None-Match / If-Modified-Since, and a 304 returns the cached content.
+         * @note Entries are keyed by URL and request headers, so requests with different credentials or Accept
+         *       headers never share a response. Responses with "Vary: *" are not cached.
+         * @see RequestConfig::useCache, NetworkResult::fromCache
+         */
+        Network &setResponseCache(std::optional<ResponseCacheOptions> options);
+        void clearResponseCache();
+
+        /**
+         * @brief Let concurrent identical Get and Head requests share one transfer.
+         * @param enable Whether to coalesce requests (default: false).
+         * @return Network& - Reference to this instance for chaining.
+         * @note A request through execute or executeAsync that matches one in flight by method, URL, range and
+         *       headers does not send its own; it gets a copy of that request's result with coalesced set.
+         * @note Requests with a progressCallback or chunkCallback, and file results, are never coalesced.
+         */
+        Network &setRequestCoalescing(bool enable);
+        bool getRequestCoalescing() const;
+
+        /**
+         * @brief Set the pool that PooledBuffer results and the segment merge of multiThreadedDownload draw from.
+         * @param pool The pool, nullptr to allocate every buffer on its own. Each instance starts with its own pool.
+         * @return Network& - Reference to this instance for chaining.
+         * @note The pool can be shared between instances; a result keeps its pool alive.
+         * @see BufferPool, PooledBuffer
+         */
+        Network &setBufferPool(std::shared_ptr<BufferPool> pool);
+        std::shared_ptr<BufferPool> getBufferPool() const;
+
+        /**
+         * @brief Enable a circuit breaker and a rate limit for every host.
+         * @param policy The thresholds and limits, std::nullopt (default) disables both.
+         * @return Network& - Reference to this instance for chaining.
+         * @note While the circuit of a host is open, its requests fail at once with "Circuit breaker open".
+         * @note Requests over the rate limit wait; executeAsync waits on the timer thread, execute on the calling thread.
+         * @note Host health (latency and error rate) is tracked either way, see hostHealth and selectHost.
+         */
+        Network &setHostPolicy(std::optional<HostPolicy> policy);
+        std::optional<HostPolicy> getHostPolicy() const;
+
+        /**
+         * @brief Get the tracked health of a host.
+         * @param host "host" or "host:port", or a URL, as in the metrics.
+         */
+        HostHealth hostHealth(const std::string &host) const;
+
+        /**
+         * @brief Pick the host to send the next request to.
+         * @param hosts Candidate hosts, e.g. mirrors of one service.
+         * @return One of hosts, or an empty string if hosts is empty.
+         * @note Power of two choices: of two random hosts whose circuit is closed, the one with the lower
+         *       latency EWMA (plus a penalty for its error rate) times requests in flight wins.
+         *       Hosts without samples are tried first.
+         */
+        std::string selectHost(const std::vector<std::string> &hosts);
+        // selectHost over config::globalConfig's available host list.
+        std::string selectHost();
+
+        /**
+         * @brief Like neko::network::buildUrl, but with the host picked by selectHost.
+         */
+        std::string buildUrl(const std::string &path, const std::string &protocol = config::globalConfig.getProtocol());
+
+        /**
+         * @brief Discard the cached request defaults so they are resolved again on the next request.
+         * @note The global user agent and protocol, the system proxy and the custom CA bundle (workPath/cacert.pem)
+         *       are resolved once and reused by every request.
+         * @note Changes made through config::globalConfig are picked up automatically. Call this after changing
+         *       the proxy environment variables, the system proxy settings or cacert.pem.
+         */
+        void invalidateCachedDefaults();
+
+        /**
+         * @brief Get a snapshot of the request metrics collected by this instance.
+         * @return MetricsSnapshot - Counters by RequestType, bytes transferred, retries and per-host latency histograms.
+         * @note Counters are updated without locks. A snapshot taken while requests are running is not
+         *       one consistent point in time, but every counter in it is monotonic until resetMetrics().
+         * @note Intended to be polled by an exporter, e.g. once per scrape interval.
+         */
+        MetricsSnapshot metrics() const;
+
+        /**
+         * @brief Reset all metrics to zero, except the in-flight counts.
+         */
+        void resetMetrics();
+
+        /**
+         * @brief Set the default diagnostics capture for requests that do not set RequestConfig::diagnostics.
+         * @param mode DiagnosticsMode::OnError (default) keeps the last onErrorBudget bytes of verbose text,
+         *             DiagnosticsMode::Full keeps everything, DiagnosticsMode::Off disables CURLOPT_VERBOSE.
+         * @param onErrorBudget Buffer size in bytes for DiagnosticsMode::OnError, default is 16 KiB.
+         * @return Network& - Reference to this instance for chaining.
+         * @note The captured text is appended to NetworkResult::detailedErrorMessage when a request fails.
+         */
+        Network &setDiagnosticsMode(DiagnosticsMode mode, std::size_t onErrorBudget = 16 * 1024);
+        DiagnosticsMode getDiagnosticsMode() const;
+
     private:
+        // The copy of config used by executeInto, the callbacks keep the sink alive
+        template <typename T>
+        static RequestConfig sinkConfig(const RequestConfig &config, const std::shared_ptr<T> &content) {
+            RequestConfig copy = config;
+            copy.contentLengthCallback = [content](neko::uint64 length) {
+                ResponseSink<T>::reserve(*content, std::min(length, maxSinkReserve));
+            };
+            copy.chunkCallback = [content](std::string_view chunk) {
+                return static_cast<bool>(ResponseSink<T>::append(*content, chunk.data(), chunk.size()));
+            };
+            return copy;
+        }
+
+        template <typename T>
+        static NetworkResult<T> intoResult(NetworkResult<std::string> &&streamed, T &&content) {
+            NetworkResult<T> result{};
+            result.statusCode = streamed.statusCode;
+            result.hasError = streamed.hasError;
+            result.errorMessage = streamed.errorMessage == "Transfer aborted by chunkCallback" ? "Transfer aborted by ResponseSink" : std::move(streamed.errorMessage);
+            result.detailedErrorMessage = std::move(streamed.detailedErrorMessage);
+            result.timings = std::move(streamed.timings);
+            result.headers = std::move(streamed.headers);
+            result.fromCache = streamed.fromCache;
+            result.coalesced = streamed.coalesced;
+            if (!result.hasError)
+                ResponseSink<T>::finalize(content);
+            result.content = std::move(content);
+            return result;
+        }
+
+        // Logs through this instance
+        friend class DownloadManager;
+
         std::shared_ptr<log::ILogger> logger;
         std::shared_ptr<executor::IAsyncExecutor> executor;
 
+        // Internal types, defined in network.cpp
+        struct HandlePool;
+        class SharedCache;
+        class MultiEngine;
+        template <typename T>
+        struct RequestContext;
+        template <typename T>
+        struct AsyncRequest;
+        template <typename T>
+        struct BatchState;
+        struct RequestDefaults;
+        struct Metrics;
+        struct DownloadManifest;
+        struct ProbeCache;
+        class Timer;
+        class TaskGroup;
+        class RetryLimiter;
+        class HostTracker;
+        class ResponseCache;
+        struct CachedResponse;
+        class FlightGroup;
+        template <typename T>
+        struct RetryState;
+        template <typename T>
+        struct HedgeState;
+
+        // Pool of reusable easy handles
+        std::unique_ptr<HandlePool> handlePool;
+        // Selected with setShareScope, the share itself lives in handlePool
+        ShareScope shareScope = ShareScope::None;
+        std::atomic<bool> shareCookies{false};
+        // curl_multi I/O threads, only present with AsyncEngine::Multi
+        std::unique_ptr<MultiEngine> multiEngine;
+        // Environment resolved once for all requests, rebuilt when globalConfig changes
+        std::mutex defaultsMutex;
+        std::shared_ptr<const RequestDefaults> defaults;
+        // Request metrics, see metrics()
+        std::unique_ptr<Metrics> metricsRegistry;
+        // Results of probe, kept while setProbeCacheTtl is non-zero
+        std::unique_ptr<ProbeCache> probeCache;
+        // Delayed retries and hedges, its thread starts with the first scheduled task
+        std::unique_ptr<Timer> timer;
+        // Requests posted to the executor or to detached threads, the destructor waits for them
+        std::unique_ptr<TaskGroup> tasks;
+        // Retry budget tokens, see setRetryBudget
+        std::unique_ptr<RetryLimiter> retryLimiter;
+        // Per-host health, circuit breakers and rate limits, see setHostPolicy
+        std::unique_ptr<HostTracker> hostTracker;
+        // Set with setResponseCache, requests keep the cache they started with
+        mutable std::mutex responseCacheMutex;
+        std::shared_ptr<ResponseCache> responseCache;
+        // Requests in flight that identical requests wait for, see setRequestCoalescing
+        std::unique_ptr<FlightGroup> flights;
+        std::atomic<bool> coalescing{false};
+        // Storage of PooledBuffer results, see setBufferPool
+        mutable std::mutex bufferPoolMutex;
+        std::shared_ptr<BufferPool> bufferPool;
+        // Default diagnostics capture
+        std::atomic<DiagnosticsMode> diagnosticsMode{DiagnosticsMode::OnError};
+        std::atomic<std::size_t> diagnosticsBudget{16 * 1024};
+
         // === Internal methods ===
 
+        // admitted: the circuit breaker and rate limit were already applied, by executeAsync
         template <typename T = std::string>
-        NetworkResult<T> doExecute(const RequestConfig &config);
+        NetworkResult<T> doExecute(const RequestConfig &config, bool admitted = false);
+
+        // The response cache if config may use it, nullptr otherwise
+        template <typename T>
+        std::shared_ptr<ResponseCache> cacheFor(const RequestConfig &config) const;
+
+        // Store a response or complete a revalidation; returns the result to hand to the caller
+        template <typename T>
+        NetworkResult<T> cacheResponse(ResponseCache &cache, const std::string &key,
+                                       const std::shared_ptr<const CachedResponse> &stale, NetworkResult<T> result);
+
+        // The coalescing key of config, std::nullopt if it must be sent on its own
+        template <typename T>
+        std::optional<std::string> flightKey(const RequestConfig &config) const;
+
+        // executeAsync once the request is admitted
+        template <typename T>
+        void startAsync(RequestConfig &&config, std::function<void(NetworkResult<T>)> onComplete);
+
+        // The error detail if the host's circuit is open, std::nullopt if the request may start
+        std::optional<std::string> circuitRejection(const RequestConfig &config);
+
+        // Send config, and a second copy of it after delay unless the first has finished by then
+        template <typename T>
+        void executeHedged(const RequestConfig &config, std::chrono::milliseconds delay, std::function<void(NetworkResult<T>)> onComplete);
+
+        // When to send the hedged copy, std::nullopt if the request is not hedged
+        std::optional<std::chrono::milliseconds> hedgeDelayFor(const RetryConfig &config);
+
+        // Delay before the next attempt, or std::nullopt if result is final; takes a retry budget token
+        template <typename T>
+        std::optional<std::chrono::milliseconds> nextRetryDelay(const RetryConfig &config, int attempt, const NetworkResult<T> &result);
+
+        // Run the next attempt of an executeWithRetryAsync
+        template <typename T>
+        void attemptWithRetry(const std::shared_ptr<RetryState<T>> &state);
+
+        // Starts the given batch requests, each completion starts the next ready ones
+        template <typename T>
+        void launchBatch(const std::shared_ptr<BatchState<T>> &state, const std::vector<std::size_t> &ready);
 
         /**
          * @return If there is an error, return the error message, otherwise return an std::nullopt.
          */
         std::optional<std::string> initCurl(CURL *curl, const RequestConfig &config);
 
-        template <typename T = std::string>
-        NetworkResult<T> performRequest(CURL *curl, const RequestConfig &config);
+        // Returns the cached defaults, resolving them again if globalConfig changed since they were built.
+        std::shared_ptr<const RequestDefaults> getRequestDefaults();
+
+        /**
+         * @brief Configure the handle for the request method and register the context buffers.
+         * @return false if the request cannot be started, the error is set on context.result.
+         */
+        template <typename T>
+        bool setupRequest(CURL *curl, RequestContext<T> &context);
+
+        /**
+         * @brief Collect the outcome of a finished transfer.
+         * @param code The CURLcode returned by curl_easy_perform or reported by the multi engine.
+         */
+        template <typename T>
+        NetworkResult<T> completeRequest(CURL *curl, int code, RequestContext<T> &context);
+
+        // multiThreadedDownload with Approach::Adaptive, fileName is already preallocated to fileSize.
+        // With a manifest only its missing ranges are fetched and progress is recorded in it.
+        bool adaptiveDownload(const MultiDownloadConfig &config, neko::uint64 fileSize, DownloadManifest *manifest);
+
+        // Load the progress manifest of a resumable multiThreadedDownload, or start a new one.
+        // Returns nullptr if the resource cannot be resumed safely (no validators).
+        std::unique_ptr<DownloadManifest> openManifest(const MultiDownloadConfig &config, const ResourceInfo &info);
+
         int getHttpStatusCode(CURL *curl);
 
-        template <typename T = std::string>
-        NetworkResult<T> handleGetRequest(CURL *curl, const RequestConfig &config);
-        template <typename T = std::string>
-        NetworkResult<T> handleHeadRequest(CURL *curl, const RequestConfig &config);
-        template <typename T = std::string>
-        NetworkResult<T> handlePostRequest(CURL *curl, const RequestConfig &config);
-        template <typename T = std::string>
-        NetworkResult<T> handleDownloadRequest(CURL *curl, const RequestConfig &config);
+        void recordRequestStart(const RequestConfig &config);
+        template <typename T>
+        void recordRequestEnd(const RequestConfig &config, const NetworkResult<T> &result);
 
         void logError(const std::string &message);
         void logInfo(const std::string &message);
         void logWarn(const std::string &message);
         void logDebug(const std::string &message);
 
+        bool isLogEnabled(log::Level level) const;
+
+        /**
+         * @brief Log a message that is only built if the level is enabled.
+         * @param format Called with a std::ostream to write the message into.
+         * @note Levels below NEKO_NETWORK_LOG_LEVEL compile to nothing.
+         */
+        template <log::Level level, typename Format>
+        void logLazy(Format &&format);
+
         // logging RequestConfig information
         void logRequestInfo(const RequestConfig &config);
     };
@@ -0,0 +1,152 @@
+/**
+ * @file networkBuffer.hpp
+ * @brief Pooled receive buffers: BufferPool and PooledBuffer
+ * @author moehoshio
+ * @copyright Copyright (c) 2025 Hoshi
+ * @license MIT OR Apache-2.0
+ */
+
+#pragma once
+
+#include <neko/schema/types.hpp>
+
+#include <neko/network/networkCommon.hpp>
+
+// C++ STL
+#include <string_view>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace neko::network {
+
+    class BufferPool;
+
+    /**
+     * @class PooledBuffer
+     * @brief A growable byte buffer whose storage comes from a BufferPool and goes back to it when released.
+     * @note Move-only. The storage is returned when the buffer is destroyed, reset or moved over, on any thread;
+     *       the pool may already be gone by then.
+     * @note A default-constructed buffer has no pool and allocates its storage directly.
+     */
+    class PooledBuffer {
+    public:
+        PooledBuffer() = default;
+        PooledBuffer(PooledBuffer &&other) noexcept
+            : pool(std::move(other.pool)), bytes(std::exchange(other.bytes, nullptr)),
+              length(std::exchange(other.length, 0)), room(std::exchange(other.room, 0)) {}
+        PooledBuffer &operator=(PooledBuffer &&other) noexcept {
+            if (this != &other) {
+                reset();
+                pool = std::move(other.pool);
+                bytes = std::exchange(other.bytes, nullptr);
+                length = std::exchange(other.length, 0);
+                room = std::exchange(other.room, 0);
+            }
+            return *this;
+        }
+        PooledBuffer(const PooledBuffer &) = delete;
+        PooledBuffer &operator=(const PooledBuffer &) = delete;
+        ~PooledBuffer() { reset(); }
+
+        char *data() noexcept { return bytes; }
+        const char *data() const noexcept { return bytes; }
+        std::size_t size() const noexcept { return length; }
+        std::size_t capacity() const noexcept { return room; }
+        bool empty() const noexcept { return length == 0; }
+        std::string_view view() const noexcept { return {bytes, length}; }
+
+        const char *begin() const noexcept { return bytes; }
+        const char *end() const noexcept { return bytes + length; }
+
+        // Make room for at least capacity bytes, rounded up to the pool's size class
+        void reserve(std::size_t capacity);
+        void append(const char *data, std::size_t size);
+        // Keep the storage for reuse, drop the contents
+        void clear() noexcept { length = 0; }
+        // Give the storage back to the pool; the buffer stays bound to it
+        void reset() noexcept;
+
+    private:
+        friend class BufferPool;
+        explicit PooledBuffer(std::shared_ptr<BufferPool> pool) : pool(std::move(pool)) {}
+
+        std::shared_ptr<BufferPool> pool;
+        char *bytes = nullptr;
+        std::size_t length = 0;
+        std::size_t room = 0;
+    };
+
+    /**
+     * @class BufferPool
+     * @brief Recycles the storage of PooledBuffers in power-of-two size classes, from 4KB to 64MB.
+     * @note A released block first goes to a small cache of the releasing thread (classes up to 256KB),
+     *       then to the pool's free lists while they hold less than maxCachedBytes; otherwise it is freed.
+     *       Larger requests than the biggest class are never pooled.
+     * @note Owned by std::shared_ptr, buffers keep their pool alive. Thread-safe.
+     * @see Network::setBufferPool
+     */
+    class BufferPool : public std::enable_shared_from_this<BufferPool> {
+    public:
+        static constexpr std::size_t minBlockSize = 4 * 1024;
+        static constexpr std::size_t sizeClasses = 15; // 4KB << 14 = 64MB
+
+        struct Stats {
+            // Blocks that had to be allocated
+            neko::uint64 allocations = 0;
+            // Blocks handed out again from a cache
+            neko::uint64 reuses = 0;
+            // Bytes held in the pool's free lists, the thread caches not included
+            neko::uint64 cachedBytes = 0;
+        };
+
+        explicit BufferPool(std::size_t maxCachedBytes = 64 * 1024 * 1024) : maxCachedBytes(maxCachedBytes) {}
+        ~BufferPool();
+        BufferPool(const BufferPool &) = delete;
+        BufferPool &operator=(const BufferPool &) = delete;
+
+        /**
+         * @brief Get a buffer with room for at least capacity bytes.
+         * @note capacity 0 binds the buffer to the pool without allocating.
+         */
+        PooledBuffer acquire(std::size_t capacity = 0);
+
+        Stats stats() const;
+
+        // Free every block held in the free lists
+        void trim();
+
+    private:
+        friend class PooledBuffer;
+
+        // Storage of at least size bytes; capacity receives the actual size
+        char *allocate(std::size_t size, std::size_t &capacity);
+        void recycle(char *block, std::size_t capacity) noexcept;
+
+        struct FreeList {
+            std::mutex mutex;
+            std::vector<char *> blocks;
+        };
+
+        const std::size_t maxCachedBytes;
+        std::array<FreeList, sizeClasses> freeLists;
+        std::atomic<neko::uint64> cachedBytes{0};
+        std::atomic<neko::uint64> allocations{0};
+        std::atomic<neko::uint64> reuses{0};
+    };
+
+    template <>
+    struct ResponseSink<PooledBuffer> {
+        static void reserve(PooledBuffer &sink, neko::uint64 size) { sink.reserve(sink.size() + size); }
+        static bool append(PooledBuffer &sink, const char *data, neko::uint64 size) {
+            sink.append(data, size);
+            return true;
+        }
+        static void finalize(PooledBuffer &) {}
+    };
+
+} // namespace neko::network
@@ -8,10 +8,18 @@
 #include <neko/log/nlog.hpp>
 #endif
 
+// Minimum log level compiled in: 0 = Debug, 1 = Info, 2 = Warn, 3 = Error, 4 = Off.
+// Messages below this level are removed at compile time. Set through the CMake cache variable of the same name.
+#ifndef NEKO_NETWORK_LOG_LEVEL
+#define NEKO_NETWORK_LOG_LEVEL 0
+#endif
+
 // C++ STL
 #include <string>
 #include <vector>
 
+#include <concepts>
+
 #include <functional>
 #include <memory>
 #include <optional>
@@ -19,9 +27,13 @@
 #include <fstream>
 #include <iostream>
 
-#include <future> // For std::async
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future> // For std::packaged_task
 #include <mutex>
 #include <shared_mutex>
+#include <thread>
 
 namespace neko::network {
     
@@ -48,6 +60,25 @@ namespace neko::network {
         constexpr neko::cstr svgContentHeader = "Content-Type: image/svg+xml";
     } // namespace header
 
+    /**
+     * @brief HTTP protocol version preference for a request.
+     * @note Versions other than Http1_1 allow requests to the same host to share one multiplexed connection.
+     */
+    enum class HttpVersion {
+        // Whatever libcurl defaults to (HTTP/2 over TLS, HTTP/1.1 otherwise, for libcurl 7.62 and newer).
+        Default,
+        // Always HTTP/1.1, one request per connection at a time.
+        Http1_1,
+        // Try HTTP/2, also upgrading plain http:// connections, and fall back to HTTP/1.1.
+        Http2,
+        // HTTP/2 for https:// only, HTTP/1.1 for plain http://.
+        Http2Tls,
+        // HTTP/2 without negotiation, the server must speak HTTP/2 directly. Mostly useful for plain-text h2c services.
+        Http2PriorKnowledge,
+        // Try HTTP/3 (QUIC) and fall back to HTTP/2 or HTTP/1.1; treated as Http2Tls if libcurl lacks HTTP/3 support.
+        Http3
+    };
+
     namespace config {
 
         class NetConfig {
@@ -55,9 +86,24 @@ namespace neko::network {
             std::string proxy;
             std::string protocol;
             std::vector<std::string> availableHostList;
+            HttpVersion httpVersion = HttpVersion::Default;
             mutable std::shared_mutex mutex;
+            // Bumped on every change so that cached copies (e.g. in Network) know when to refresh
+            std::atomic<neko::uint64> version{0};
+
+            void touch() {
+                version.fetch_add(1, std::memory_order_release);
+            }
 
         public:
+            /**
+             * @brief Get the configuration version.
+             * @note The value changes whenever any setting is modified; it can be compared cheaply without taking the lock.
+             */
+            neko::uint64 getVersion() const {
+                return version.load(std::memory_order_acquire);
+            }
+
             std::string getUserAgent() const {
                 std::shared_lock<std::shared_mutex> lock(mutex);
                 return userAgent;
@@ -70,6 +116,14 @@ namespace neko::network {
                 std::shared_lock<std::shared_mutex> lock(mutex);
                 return protocol;
             }
+            HttpVersion getHttpVersion() const {
+                std::shared_lock<std::shared_mutex> lock(mutex);
+                return httpVersion;
+            }
+            /**
+             * @brief Get the first available host.
+             * @note Network::selectHost picks the healthiest host of the list instead.
+             */
             std::string getAvailableHost() const {
                 std::shared_lock<std::shared_mutex> lock(mutex);
                 if (!availableHostList.empty()) {
@@ -77,34 +131,50 @@ namespace neko::network {
                 }
                 return std::string();
             }
+            std::vector<std::string> getAvailableHostList() const {
+                std::shared_lock<std::shared_mutex> lock(mutex);
+                return availableHostList;
+            }
 
             NetConfig &setUserAgent(const std::string &ua) {
                 std::unique_lock<std::shared_mutex> lock(mutex);
                 userAgent = ua;
+                touch();
                 return *this;
             }
             NetConfig &setProxy(const std::string &p) {
                 std::unique_lock<std::shared_mutex> lock(mutex);
                 proxy = p;
+                touch();
                 return *this;
             }
             NetConfig &setProtocol(const std::string &p) {
                 std::unique_lock<std::shared_mutex> lock(mutex);
                 protocol = p;
+                touch();
+                return *this;
+            }
+            NetConfig &setHttpVersion(HttpVersion version) {
+                std::unique_lock<std::shared_mutex> lock(mutex);
+                httpVersion = version;
+                touch();
                 return *this;
             }
             NetConfig &setAvailableHostList(const std::vector<std::string> &hosts) {
                 std::unique_lock<std::shared_mutex> lock(mutex);
                 availableHostList = hosts;
+                touch();
                 return *this;
             }
             void pushAvailableHost(const std::string &host) {
                 std::unique_lock<std::shared_mutex> lock(mutex);
                 availableHostList.push_back(host);
+                touch();
             }
             void clearAvailableHost() {
                 std::unique_lock<std::shared_mutex> lock(mutex);
                 availableHostList.clear();
+                touch();
             }
             void clear() {
                 std::unique_lock<std::shared_mutex> lock(mutex);
@@ -112,11 +182,67 @@ namespace neko::network {
                 proxy.clear();
                 protocol.clear();
                 availableHostList.clear();
+                httpVersion = HttpVersion::Default;
+                touch();
             }
         } inline globalConfig;
 
     } // namespace config
 
+    /**
+     * @brief How a response body is written into a content type T.
+     * @note Specialize it to receive bodies into your own type, see Network::executeInto.
+     *       Specializations are provided for std::string, std::vector<char> and std::fstream.
+     *
+     * - reserve(sink, size): called once before the first chunk if the response has a Content-Length, with at most
+     *   maxSinkReserve bytes. It is a hint: the body can be shorter, or longer if it is compressed on the wire.
+     * - append(sink, data, size): called for every chunk, return false to abort the transfer.
+     * - finalize(sink): called once after a successful transfer, before the content is handed out.
+     */
+    template <typename T>
+    struct ResponseSink;
+
+    // Largest size passed to ResponseSink::reserve, a bogus Content-Length must not allocate without bound
+    inline constexpr neko::uint64 maxSinkReserve = 64 * 1024 * 1024;
+
+    template <typename T>
+    concept ResponseSinkType = requires(T &sink, const char *data, neko::uint64 size) {
+        ResponseSink<T>::reserve(sink, size);
+        { ResponseSink<T>::append(sink, data, size) } -> std::convertible_to<bool>;
+        ResponseSink<T>::finalize(sink);
+    };
+
+    template <>
+    struct ResponseSink<std::string> {
+        static void reserve(std::string &sink, neko::uint64 size) { sink.reserve(sink.size() + size); }
+        static bool append(std::string &sink, const char *data, neko::uint64 size) {
+            sink.append(data, size);
+            return true;
+        }
+        static void finalize(std::string &) {}
+    };
+
+    template <>
+    struct ResponseSink<std::vector<char>> {
+        static void reserve(std::vector<char> &sink, neko::uint64 size) { sink.reserve(sink.size() + size); }
+        static bool append(std::vector<char> &sink, const char *data, neko::uint64 size) {
+            sink.insert(sink.end(), data, data + size);
+            return true;
+        }
+        static void finalize(std::vector<char> &) {}
+    };
+
+    template <>
+    struct ResponseSink<std::fstream> {
+        static void reserve(std::fstream &, neko::uint64) {}
+        // Write errors are left in the stream state for the caller to check
+        static bool append(std::fstream &sink, const char *data, neko::uint64 size) {
+            sink.write(data, static_cast<std::streamsize>(size));
+            return true;
+        }
+        static void finalize(std::fstream &sink) { sink.flush(); }
+    };
+
     namespace helper {
 
         /**
@@ -126,74 +252,24 @@ namespace neko::network {
          **/
         std::optional<std::string> getSysProxy();
 
-        template <typename T>
-        struct WriteCallbackContext {
-            T *buffer;
-            std::function<void(neko::uint64)> *progressCallback;
-            neko::uint64 totalBytes = 0;
-        };
-
-        template <typename T>
-        neko::uint64 writeToCallback(char *ptr, neko::uint64 size, neko::uint64 nmemb, void *userdata) {
-            auto *ctx = static_cast<WriteCallbackContext<T> *>(userdata);
-            neko::uint64 written = size * nmemb;
-            ctx->buffer->append(ptr, written);
-            ctx->totalBytes += written;
-            if (ctx->progressCallback && *ctx->progressCallback) {
-                (*ctx->progressCallback)(ctx->totalBytes);
-            }
-            return written;
-        }
+    } // namespace helper
 
-        template <>
-        inline neko::uint64 writeToCallback<std::string>(char *ptr, neko::uint64 size, neko::uint64 nmemb, void *userdata) {
-            auto *ctx = static_cast<WriteCallbackContext<std::string> *>(userdata);
-            neko::uint64 written = size * nmemb;
-            ctx->buffer->append(ptr, written);
-            ctx->totalBytes += written;
-            if (ctx->progressCallback && *ctx->progressCallback) {
-                (*ctx->progressCallback)(ctx->totalBytes);
-            }
-            return written;
-        }
-        template <>
-        inline neko::uint64 writeToCallback<std::fstream>(char *ptr, neko::uint64 size, neko::uint64 nmemb, void *userdata) {
-            auto *ctx = static_cast<WriteCallbackContext<std::fstream> *>(userdata);
-            neko::uint64 written = size * nmemb;
-            ctx->buffer->write(ptr, written);
-            ctx->totalBytes += written;
-            if (ctx->progressCallback && *ctx->progressCallback) {
-                (*ctx->progressCallback)(ctx->totalBytes);
-            }
-            return written;
-        }
-        template <>
-        inline neko::uint64 writeToCallback<std::vector<char>>(char *ptr, neko::uint64 size, neko::uint64 nmemb, void *userdata) {
-            auto *ctx = static_cast<WriteCallbackContext<std::vector<char>> *>(userdata);
-            neko::uint64 written = size * nmemb;
-            ctx->buffer->insert(ctx->buffer->end(), ptr, ptr + written);
-            ctx->totalBytes += written;
-            if (ctx->progressCallback && *ctx->progressCallback) {
-                (*ctx->progressCallback)(ctx->totalBytes);
-            }
-            return written;
-        }
+    namespace log {
+        // Logging functions
 
         /**
-         * @brief Header callback function for capturing HTTP headers
-         * This is used specifically for HEAD requests to capture response headers
+         * @brief Log severity, from most to least verbose.
          */
-        inline neko::uint64 headerCallback(char *ptr, neko::uint64 size, neko::uint64 nmemb, void *userdata) {
-            auto *headers = static_cast<std::string *>(userdata);
-            neko::uint64 dataSize = size * nmemb;
-            headers->append(ptr, dataSize);
-            return dataSize;
-        }
-
-    } // namespace helper
+        enum class Level {
+            Debug = 0,
+            Info = 1,
+            Warn = 2,
+            Error = 3,
+            Off = 4
+        };
 
-    namespace log {
-        // Logging functions
+        /// @brief The minimum level compiled into the library, see NEKO_NETWORK_LOG_LEVEL.
+        inline constexpr Level compiledLevel = static_cast<Level>(NEKO_NETWORK_LOG_LEVEL);
 
         class ILogger {
         public:
@@ -202,10 +278,28 @@ namespace neko::network {
             virtual void info(const std::string &msg) = 0;
             virtual void warn(const std::string &msg) = 0;
             virtual void debug(const std::string &msg) = 0;
+
+            /**
+             * @brief Whether messages of the given level are wanted.
+             * @note Network checks this before building a message, so a disabled level costs no formatting.
+             *       The default accepts every level.
+             */
+            virtual bool enabled([[maybe_unused]] Level level) const {
+                return true;
+            }
         };
 
         class DefaultLogger : public ILogger {
         public:
+            explicit DefaultLogger(Level minLevel = Level::Debug) : minLevel(minLevel) {}
+
+            bool enabled(Level level) const override {
+                return level >= minLevel.load(std::memory_order_relaxed);
+            }
+            void setLevel(Level level) {
+                minLevel.store(level, std::memory_order_relaxed);
+            }
+
             void error(const std::string &msg) override {
                 std::cerr << "Network Error: " << msg << std::endl;
             }
@@ -218,6 +312,9 @@ namespace neko::network {
             void debug(const std::string &msg) override {
                 std::cout << "Network Debug: " << msg << std::endl;
             }
+
+        private:
+            std::atomic<Level> minLevel;
         };
 
 #ifdef NEKO_IMPORT_NLOG
@@ -274,29 +371,124 @@ namespace neko::network {
 
     namespace executor {
 
-        // Asynchronous executor interface
+        /**
+         * @brief Asynchronous executor interface
+         *
+         * Custom executors override post(), which receives type-erased tasks.
+         * submit() builds the returned future on top of post(), so every task goes through the override.
+         */
         class IAsyncExecutor {
         public:
             virtual ~IAsyncExecutor() = default;
 
+            /**
+             * @brief Schedule a task for execution.
+             * @param task The task to run. It must be invoked exactly once.
+             * @note The default implementation runs the task on a new detached thread.
+             */
+            virtual void post(std::function<void()> task) {
+                std::thread(std::move(task)).detach();
+            }
+
+            /**
+             * @brief Schedule a task and get its result through a future.
+             * @note Unlike one from std::async, the future does not wait for the task when it is destroyed.
+             *       Network waits for the requests it posted in its destructor instead.
+             */
             template <typename F>
             auto submit(F &&f) -> std::future<decltype(f())> {
-                return submitImpl(std::function<decltype(f())()>(std::forward<F>(f)));
+                using R = decltype(f());
+                // std::function needs a copyable callable, so the packaged_task is shared
+                auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+                auto future = task->get_future();
+                post([task]() { (*task)(); });
+                return future;
             }
+        };
 
-        protected:
-            template <typename R>
-            std::future<R> submitImpl(std::function<R()> f) {
-                // Default implementation using std::async
-                return std::async(std::launch::async, std::move(f));
+        /**
+         * @brief Runs every task on its own detached thread. This is the default executor.
+         * @note Nothing waits for the tasks; whoever posts them must keep what they use alive until they are done.
+         */
+        class StdAsyncExecutor : public IAsyncExecutor {
+        public:
+            void post(std::function<void()> task) override {
+                std::thread(std::move(task)).detach();
             }
         };
 
-        class StdAsyncExecutor : public IAsyncExecutor {
-        protected:
-            template <typename R>
-            std::future<R> submitImpl(std::function<R()> f) {
-                return std::async(std::launch::async, std::move(f));
+        /**
+         * @brief Fixed-size thread pool executor.
+         *
+         * Tasks are queued and run by a bounded set of worker threads,
+         * e.g. a multiThreadedDownload with 255 segments runs on threadCount() workers instead of 255 threads.
+         * @note Queued tasks are still run when the executor is destroyed, so pending futures are always fulfilled.
+         * @note Do not block a worker on a future of another task submitted to the same pool
+         *       (such as calling multiThreadedDownload from inside a pool task) when the pool may be saturated.
+         */
+        class ThreadPoolExecutor : public IAsyncExecutor {
+        public:
+            explicit ThreadPoolExecutor(std::size_t threads = std::thread::hardware_concurrency()) {
+                if (threads == 0)
+                    threads = 1;
+                workers.reserve(threads);
+                for (std::size_t i = 0; i < threads; ++i) {
+                    workers.emplace_back([this]() { workerLoop(); });
+                }
+            }
+
+            ~ThreadPoolExecutor() override {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                }
+                condition.notify_all();
+                for (auto &worker : workers) {
+                    if (worker.joinable())
+                        worker.join();
+                }
+            }
+
+            ThreadPoolExecutor(const ThreadPoolExecutor &) = delete;
+            ThreadPoolExecutor &operator=(const ThreadPoolExecutor &) = delete;
+
+            void post(std::function<void()> task) override {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    tasks.push_back(std::move(task));
+                }
+                condition.notify_one();
+            }
+
+            std::size_t threadCount() const {
+                return workers.size();
+            }
+
+            std::size_t pendingTasks() const {
+                std::lock_guard<std::mutex> lock(mutex);
+                return tasks.size();
+            }
+
+        private:
+            std::vector<std::thread> workers;
+            std::deque<std::function<void()>> tasks;
+            mutable std::mutex mutex;
+            std::condition_variable condition;
+            bool stopping = false;
+
+            void workerLoop() {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                        if (tasks.empty())
+                            return; // stopping and drained
+                        task = std::move(tasks.front());
+                        tasks.pop_front();
+                    }
+                    task();
+                }
             }
         };
 
@@ -0,0 +1,205 @@
+/**
+ * @file networkDownload.hpp
+ * @brief Download manager: prioritized download jobs under a shared bandwidth cap
+ * @author moehoshio
+ * @copyright Copyright (c) 2025 Hoshi
+ * @license MIT OR Apache-2.0
+ */
+
+#pragma once
+
+#include <neko/schema/types.hpp>
+
+#include <neko/network/network.hpp>
+#include <neko/network/networkTypes.hpp>
+
+// C++ STL
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+
+namespace neko::network {
+
+    /**
+     * @brief Settings of a DownloadManager.
+     * @struct DownloadManagerOptions
+     * @ingroup network
+     */
+    struct DownloadManagerOptions {
+        /**
+         * @brief Maximum number of jobs running at once.
+         * @note Default is 2. Each job still splits its file into segments as its MultiDownloadConfig says.
+         */
+        std::size_t maxConcurrentJobs = 2;
+        /**
+         * @brief The running jobs never drop below this when backing off. Default is 1.
+         */
+        std::size_t minConcurrentJobs = 1;
+        /**
+         * @brief Receive rate cap in bytes per second shared by all jobs, 0 (default) means no cap.
+         * @see DownloadManager::setBandwidthLimit
+         */
+        neko::uint64 bandwidthLimit = 0;
+        /**
+         * @brief Latency of interactive requests above which the jobs back off.
+         * @note Every adjustInterval the percentile of MetricsSnapshot::interactiveLatency over the last interval
+         *       is compared to it. Above, the allowed jobs are halved, and so is the rate of the running ones.
+         *       Otherwise one more job is allowed, up to maxConcurrentJobs, and the rate rises by an eighth of
+         *       what it was before backing off, until it is back there.
+         * @note Default is 0, which disables backing off.
+         * @see DownloadManager::getBackoffRate
+         */
+        std::chrono::milliseconds latencyTarget{0};
+        // Percentile compared to latencyTarget, in [0, 1]
+        double latencyPercentile = 0.95;
+        std::chrono::milliseconds adjustInterval{1000};
+    };
+
+    /**
+     * @brief The state of a DownloadJob.
+     * @enum DownloadState
+     * @ingroup network
+     */
+    enum class DownloadState {
+        Queued,
+        Running,
+        Completed,
+        Failed,
+        Cancelled
+    };
+
+    /**
+     * @class DownloadJob
+     * @brief A download queued in a DownloadManager, shared between the manager and the caller.
+     * @note Thread-safe. The job stays valid after its manager is destroyed.
+     */
+    class DownloadJob {
+    public:
+        DownloadJob(const DownloadJob &) = delete;
+        DownloadJob &operator=(const DownloadJob &) = delete;
+
+        DownloadState getState() const noexcept {
+            return state.load(std::memory_order_acquire);
+        }
+
+        // Higher runs first, jobs of equal priority run in the order they were added
+        int getPriority() const noexcept {
+            return priority.load(std::memory_order_relaxed);
+        }
+        // Only affects a job that is still queued
+        void setPriority(int value) noexcept {
+            priority.store(value, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Bytes of the file present so far, summed over all segments, including resumed ones.
+         * @note The same value config.progressCallback of the job receives; it never decreases.
+         */
+        neko::uint64 getDownloadedBytes() const noexcept {
+            return downloaded.load(std::memory_order_relaxed);
+        }
+
+        // Receive rate cap of this job alone in bytes per second, 0 means only the manager's cap applies
+        void setBandwidthLimit(neko::uint64 bytesPerSecond) {
+            limiter->setRate(bytesPerSecond);
+        }
+        neko::uint64 getBandwidthLimit() const {
+            return limiter->getRate();
+        }
+
+        // A queued job does not start, a running one is aborted
+        void cancel() {
+            cancellation->cancel();
+        }
+
+        /**
+         * @brief Block until the job has finished.
+         * @return bool - true if the download succeeded.
+         */
+        bool wait() const {
+            return result.get();
+        }
+        const std::shared_future<bool> &future() const noexcept {
+            return result;
+        }
+
+    private:
+        friend class DownloadManager;
+
+        DownloadJob(MultiDownloadConfig config, int priority, neko::uint64 sequence,
+                    std::shared_ptr<BandwidthLimiter> limiter, std::shared_ptr<CancellationToken> cancellation)
+            : config(std::move(config)), limiter(std::move(limiter)), cancellation(std::move(cancellation)),
+              priority(priority), sequence(sequence), result(done.get_future().share()) {}
+
+        // Set once, by the manager
+        void finish(DownloadState finalState, bool success) {
+            state.store(finalState, std::memory_order_release);
+            done.set_value(success);
+        }
+
+        MultiDownloadConfig config;
+        const std::shared_ptr<BandwidthLimiter> limiter;
+        const std::shared_ptr<CancellationToken> cancellation;
+        std::atomic<int> priority;
+        const neko::uint64 sequence;
+        std::atomic<DownloadState> state{DownloadState::Queued};
+        std::atomic<neko::uint64> downloaded{0};
+        std::promise<bool> done;
+        std::shared_future<bool> result;
+    };
+
+    /**
+     * @class DownloadManager
+     * @brief Runs multi-threaded downloads from a priority queue next to other traffic of a Network.
+     * @ingroup network
+     * @note Every job gets a BandwidthLimiter under the manager's, so the manager's cap holds across all segments
+     *       of all jobs, and each job can be capped further. The limiter replaces config.bandwidthLimiter of the job.
+     * @note With DownloadManagerOptions::latencyTarget, fewer jobs are started and the running ones are slowed
+     *       down while interactive requests of the Network get slow. Running jobs are not interrupted.
+     * @note Destroying the manager cancels the remaining jobs and waits for the running ones. The Network must outlive it.
+     */
+    class DownloadManager {
+    public:
+        explicit DownloadManager(Network &network, DownloadManagerOptions options = {});
+        ~DownloadManager();
+        DownloadManager(const DownloadManager &) = delete;
+        DownloadManager &operator=(const DownloadManager &) = delete;
+
+        /**
+         * @brief Queue a download.
+         * @param config The download; its progressCallback receives the bytes of the whole file, and cancelling
+         *        config.config.cancellation cancels the job.
+         * @param priority Higher runs first.
+         * @param bandwidthLimit Cap of this job in bytes per second, 0 means only the manager's cap applies.
+         * @return std::shared_ptr<DownloadJob> - The job, to follow, wait for or cancel it.
+         */
+        std::shared_ptr<DownloadJob> enqueue(MultiDownloadConfig config, int priority = 0, neko::uint64 bandwidthLimit = 0);
+
+        // Cap of all jobs together in bytes per second, 0 removes it; applies to running jobs at once
+        void setBandwidthLimit(neko::uint64 bytesPerSecond);
+        // The cap set by setBandwidthLimit or the options, a backoff does not change it
+        neko::uint64 getBandwidthLimit() const;
+        // Rate of all jobs together while backing off, in bytes per second; 0 if not backing off
+        neko::uint64 getBackoffRate() const;
+
+        // How many jobs may run now, between the option's minimum and maximum
+        std::size_t getConcurrency() const;
+        std::size_t queuedJobs() const;
+        std::size_t runningJobs() const;
+
+        // Block until no job is queued or running
+        void waitIdle();
+
+    private:
+        struct State;
+
+        void schedule();
+        void adjustConcurrency();
+        void run(std::shared_ptr<DownloadJob> job);
+
+        Network &network;
+        const std::shared_ptr<State> state;
+    };
+
+} // namespace neko::network
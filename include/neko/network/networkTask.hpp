@@ -0,0 +1,370 @@
+/**
+ * @file networkTask.hpp
+ * @brief C++20 coroutine support: Task, whenAll, whenAny and syncWait
+ * @author moehoshio
+ * @copyright Copyright (c) 2025 Hoshi
+ * @license MIT OR Apache-2.0
+ * @note Only available if NEKO_NETWORK_USE_COROUTINES is defined, which CMake does when the compiler supports coroutines.
+ */
+
+#pragma once
+
+#if defined(NEKO_NETWORK_USE_COROUTINES)
+
+// C++ STL
+#include <coroutine>
+#include <exception>
+#include <vector>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace neko::network {
+
+    template <typename T = void>
+    class Task;
+
+    namespace detail {
+
+        template <typename T>
+        struct TaskPromiseBase {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr exception;
+
+            // Resume whoever awaits the task, without growing the stack
+            struct FinalAwaiter {
+                bool await_ready() const noexcept { return false; }
+                template <typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                    auto continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+                void await_resume() const noexcept {}
+            };
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+            void unhandled_exception() noexcept { exception = std::current_exception(); }
+        };
+
+        template <typename T>
+        struct TaskPromise : TaskPromiseBase<T> {
+            std::optional<T> value;
+
+            Task<T> get_return_object() noexcept;
+
+            template <typename U = T>
+            void return_value(U &&result) {
+                value.emplace(std::forward<U>(result));
+            }
+
+            T result() {
+                if (this->exception)
+                    std::rethrow_exception(this->exception);
+                return std::move(*value);
+            }
+        };
+
+        template <>
+        struct TaskPromise<void> : TaskPromiseBase<void> {
+            Task<void> get_return_object() noexcept;
+
+            void return_void() const noexcept {}
+
+            void result() {
+                if (exception)
+                    std::rethrow_exception(exception);
+            }
+        };
+
+        // A coroutine that starts at once and frees itself when done, used to drive tasks
+        struct Detached {
+            struct promise_type {
+                Detached get_return_object() const noexcept { return {}; }
+                std::suspend_never initial_suspend() const noexcept { return {}; }
+                std::suspend_never final_suspend() const noexcept { return {}; }
+                void return_void() const noexcept {}
+                void unhandled_exception() const noexcept { std::terminate(); }
+            };
+        };
+
+        /**
+         * Awaits a callback-based operation: start(onComplete) begins it, and the coroutine resumes on the
+         * thread that calls onComplete. If onComplete runs before start returns, the coroutine does not suspend.
+         */
+        template <typename R, typename Start>
+        struct CallbackAwaiter {
+            Start start;
+            std::optional<R> result;
+            std::coroutine_handle<> handle;
+            std::atomic<bool> done{false};
+
+            explicit CallbackAwaiter(Start start) : start(std::move(start)) {}
+
+            bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> awaiting) {
+                handle = awaiting;
+                start([this](R value) {
+                    result.emplace(std::move(value));
+                    // Whoever comes second resumes, or continues if it is await_suspend itself
+                    if (done.exchange(true, std::memory_order_acq_rel))
+                        handle.resume();
+                });
+                return !done.exchange(true, std::memory_order_acq_rel);
+            }
+
+            R await_resume() {
+                return std::move(*result);
+            }
+        };
+
+        template <typename T>
+        struct WhenAllState : std::enable_shared_from_this<WhenAllState<T>> {
+            explicit WhenAllState(std::size_t count) : results(count), remaining(count + 1) {}
+
+            std::vector<std::optional<T>> results;
+            std::mutex exceptionMutex;
+            std::exception_ptr exception;
+            // The tasks and the awaiting coroutine; the last one to finish resumes it
+            std::atomic<std::size_t> remaining;
+            std::coroutine_handle<> continuation;
+
+            void finishOne() {
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    continuation.resume();
+            }
+        };
+
+        template <typename T>
+        Detached driveWhenAll(Task<T> task, std::shared_ptr<WhenAllState<T>> state, std::size_t index) {
+            try {
+                state->results[index].emplace(co_await std::move(task));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state->exceptionMutex);
+                if (!state->exception)
+                    state->exception = std::current_exception();
+            }
+            state->finishOne();
+        }
+
+        template <typename T>
+        struct WhenAllAwaiter {
+            // Owned by the awaiting coroutine, which outlives the awaiter
+            WhenAllState<T> &state;
+            std::vector<Task<T>> &tasks;
+
+            bool await_ready() const noexcept { return tasks.empty(); }
+
+            bool await_suspend(std::coroutine_handle<> awaiting) {
+                state.continuation = awaiting;
+                auto shared = state.shared_from_this();
+                for (std::size_t i = 0; i < tasks.size(); ++i) {
+                    driveWhenAll(std::move(tasks[i]), shared, i);
+                }
+                // Suspend unless every task already finished
+                return state.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        template <typename T>
+        struct WhenAnyState : std::enable_shared_from_this<WhenAnyState<T>> {
+            std::optional<std::size_t> index;
+            std::optional<T> value;
+            std::exception_ptr exception;
+            std::atomic<bool> claimed{false};
+            // Set by the first task and by the awaiting coroutine once it suspended; the second one resumes it
+            std::atomic<bool> ready{false};
+            std::coroutine_handle<> continuation;
+        };
+
+        template <typename T>
+        Detached driveWhenAny(Task<T> task, std::shared_ptr<WhenAnyState<T>> state, std::size_t index) {
+            std::optional<T> value;
+            std::exception_ptr exception;
+            try {
+                value.emplace(co_await std::move(task));
+            } catch (...) {
+                exception = std::current_exception();
+            }
+            if (state->claimed.exchange(true, std::memory_order_acq_rel))
+                co_return;
+            state->index = index;
+            state->value = std::move(value);
+            state->exception = exception;
+            if (state->ready.exchange(true, std::memory_order_acq_rel))
+                state->continuation.resume();
+        }
+
+        template <typename T>
+        struct WhenAnyAwaiter {
+            // Owned by the awaiting coroutine, which outlives the awaiter
+            WhenAnyState<T> &state;
+            std::vector<Task<T>> &tasks;
+
+            bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> awaiting) {
+                state.continuation = awaiting;
+                auto shared = state.shared_from_this();
+                for (std::size_t i = 0; i < tasks.size(); ++i) {
+                    driveWhenAny(std::move(tasks[i]), shared, i);
+                }
+                return !state.ready.exchange(true, std::memory_order_acq_rel);
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+    } // namespace detail
+
+    /**
+     * @class Task
+     * @brief A lazily started coroutine that produces a T, awaited with co_await.
+     * @note The coroutine starts when the task is awaited and resumes the awaiting coroutine when it finishes,
+     *       on whatever thread it finished on. An exception thrown in it is rethrown by co_await.
+     * @note A task can be awaited once. Use syncWait to wait for one from a function that is not a coroutine.
+     */
+    template <typename T>
+    class Task {
+    public:
+        using promise_type = detail::TaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        Task() = default;
+        explicit Task(Handle handle) : handle(handle) {}
+        Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+        Task &operator=(Task &&other) noexcept {
+            if (this != &other) {
+                if (handle)
+                    handle.destroy();
+                handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+        ~Task() {
+            if (handle)
+                handle.destroy();
+        }
+
+        bool valid() const noexcept {
+            return static_cast<bool>(handle);
+        }
+
+        auto operator co_await() const noexcept {
+            struct Awaiter {
+                Handle handle;
+                bool await_ready() const noexcept { return !handle || handle.done(); }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                    handle.promise().continuation = awaiting;
+                    return handle;
+                }
+                T await_resume() {
+                    if (!handle)
+                        throw std::logic_error("Task: awaiting an empty task");
+                    return handle.promise().result();
+                }
+            };
+            return Awaiter{handle};
+        }
+
+    private:
+        Handle handle;
+    };
+
+    namespace detail {
+        template <typename T>
+        Task<T> TaskPromise<T>::get_return_object() noexcept {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+    } // namespace detail
+
+    /**
+     * @brief Run the tasks concurrently and wait for all of them.
+     * @return Task<std::vector<T>> - The results in the order of the tasks.
+     * @note If a task throws, the first exception is rethrown once all tasks finished.
+     */
+    template <typename T>
+    Task<std::vector<T>> whenAll(std::vector<Task<T>> tasks) {
+        static_assert(!std::is_void_v<T>, "whenAll needs tasks that produce a value");
+        auto state = std::make_shared<detail::WhenAllState<T>>(tasks.size());
+        co_await detail::WhenAllAwaiter<T>{*state, tasks};
+        if (state->exception)
+            std::rethrow_exception(state->exception);
+
+        std::vector<T> results;
+        results.reserve(state->results.size());
+        for (auto &result : state->results) {
+            results.push_back(std::move(*result));
+        }
+        co_return results;
+    }
+
+    template <typename T>
+    struct WhenAnyResult {
+        // Index of the task that finished first
+        std::size_t index = 0;
+        T value;
+    };
+
+    /**
+     * @brief Run the tasks concurrently and wait for the first one to finish.
+     * @return Task<WhenAnyResult<T>> - Which task finished first and its result; its exception is rethrown.
+     * @note The other tasks still run to completion in the background and their results are dropped.
+     * @throws std::invalid_argument if tasks is empty, when awaited.
+     */
+    template <typename T>
+    Task<WhenAnyResult<T>> whenAny(std::vector<Task<T>> tasks) {
+        static_assert(!std::is_void_v<T>, "whenAny needs tasks that produce a value");
+        if (tasks.empty())
+            throw std::invalid_argument("whenAny: no tasks");
+
+        auto state = std::make_shared<detail::WhenAnyState<T>>();
+        co_await detail::WhenAnyAwaiter<T>{*state, tasks};
+        if (state->exception)
+            std::rethrow_exception(state->exception);
+        co_return WhenAnyResult<T>{*state->index, std::move(*state->value)};
+    }
+
+    /**
+     * @brief Block the calling thread until the task finished.
+     * @return T - The result of the task; its exception is rethrown.
+     * @note For the top level of a program or a test. Do not call it on a thread the task needs to finish,
+     *       such as the thread that completes its requests.
+     */
+    template <typename T>
+    T syncWait(Task<T> task) {
+        auto done = std::make_shared<std::promise<T>>();
+        auto future = done->get_future();
+        [](Task<T> task, std::shared_ptr<std::promise<T>> done) -> detail::Detached {
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    co_await std::move(task);
+                    done->set_value();
+                } else {
+                    done->set_value(co_await std::move(task));
+                }
+            } catch (...) {
+                done->set_exception(std::current_exception());
+            }
+        }(std::move(task), done);
+        return future.get();
+    }
+
+} // namespace neko::network
+
+#endif // NEKO_NETWORK_USE_COROUTINES
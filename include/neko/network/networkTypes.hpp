@@ -3,9 +3,21 @@
 #include <neko/schema/types.hpp>
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <array>
 #include <chrono>
 #include <functional>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace neko::network {
 
@@ -16,6 +28,235 @@ namespace neko::network {
         DownloadFile,
         UploadFile
     };
+
+    // Number of RequestType values, used to index per-type tables.
+    inline constexpr std::size_t requestTypeCount = 5;
+
+    /**
+     * @brief The engine that drives asynchronous requests.
+     * @see Network::setAsyncEngine
+     */
+    enum class AsyncEngine {
+        // Each request blocks one executor task in curl_easy_perform (default).
+        Executor,
+        // All requests are multiplexed with curl_multi on a few Network-owned I/O threads.
+        Multi
+    };
+    /**
+     * @brief Which requests share DNS results and TLS sessions.
+     * @see Network::setShareScope
+     */
+    enum class ShareScope {
+        // Each pooled handle keeps its own caches (default).
+        None,
+        // All requests of one Network share one cache.
+        Instance,
+        // All Networks that select this scope share one cache.
+        Process
+    };
+    /**
+     * @brief How much libcurl verbose output is captured for a request.
+     * @see Network::setDiagnosticsMode
+     */
+    enum class DiagnosticsMode {
+        // Verbose output is not enabled; errors only carry the libcurl error text.
+        Off,
+        // The most recent verbose text is kept in a fixed-size buffer and attached to the error if the request fails (default).
+        OnError,
+        // All verbose output, including TLS data, is kept; it is attached to errors and logged at debug level on success.
+        Full
+    };
+
+    /**
+     * @brief Timing and transfer details of a request, as reported by libcurl.
+     * @note The phase times are cumulative from the start of the request:
+     *       nameLookup <= connect <= appConnect <= preTransfer <= startTransfer <= total.
+     */
+    struct RequestTimings {
+        // DNS resolution done.
+        std::chrono::microseconds nameLookup{0};
+        // TCP connect done.
+        std::chrono::microseconds connect{0};
+        // TLS handshake done, 0 for plain HTTP.
+        std::chrono::microseconds appConnect{0};
+        // About to send the request.
+        std::chrono::microseconds preTransfer{0};
+        // First response byte received.
+        std::chrono::microseconds startTransfer{0};
+        // Whole request, including redirects.
+        std::chrono::microseconds total{0};
+        // Time spent in redirects before the final request.
+        std::chrono::microseconds redirect{0};
+
+        neko::uint64 bytesUploaded = 0;
+        neko::uint64 bytesDownloaded = 0;
+        // Average speeds over the transfer, in bytes per second.
+        neko::uint64 uploadSpeed = 0;
+        neko::uint64 downloadSpeed = 0;
+
+        int redirectCount = 0;
+        // IP address of the last connection, empty if none was made.
+        std::string primaryIp;
+        // True if the request did not open a new connection, e.g. a pooled handle kept it alive.
+        bool connectionReused = false;
+        // HTTP version used for the final response, e.g. "HTTP/2", empty if no response was received.
+        std::string httpVersion;
+    };
+
+    /**
+     * @brief Ordered list of HTTP header fields with case-insensitive names.
+     * @note Fields are kept as their "Name: Value" line, so a map built once can be handed to libcurl
+     *       for every request without formatting it again.
+     * @note Repeated names (e.g. Set-Cookie) are kept in order; a linear search is used since
+     *       requests and responses rarely carry more than a few dozen fields.
+     */
+    class HeaderMap {
+    public:
+        HeaderMap() = default;
+        HeaderMap(std::initializer_list<std::pair<std::string_view, std::string_view>> fields) {
+            for (const auto &[name, value] : fields) {
+                add(name, value);
+            }
+        }
+
+        /**
+         * @brief Parse a header block of "Name: Value" lines separated by "\n" or "\r\n".
+         * @note Lines without a colon, such as status lines, are skipped.
+         */
+        static HeaderMap parse(std::string_view block) {
+            HeaderMap headers;
+            while (!block.empty()) {
+                auto end = block.find('\n');
+                headers.addLine(block.substr(0, end));
+                block.remove_prefix(end == std::string_view::npos ? block.size() : end + 1);
+            }
+            return headers;
+        }
+
+        /**
+         * @brief Append a field, keeping any existing fields with the same name.
+         * @note An empty value makes libcurl drop a header it would add itself, e.g. "Expect".
+         * @note A field whose name or value contains CR, LF or NUL is ignored, it could inject further fields.
+         */
+        HeaderMap &add(std::string_view name, std::string_view value) {
+            if (!isSafe(name) || !isSafe(value))
+                return *this;
+            Field field;
+            field.line.reserve(name.size() + value.size() + 2);
+            field.line.append(name).append(": ").append(value);
+            field.nameLength = name.size();
+            fields.push_back(std::move(field));
+            return *this;
+        }
+
+        // Replace all fields with this name by a single one, an unsafe field (see add) changes nothing.
+        HeaderMap &set(std::string_view name, std::string_view value) {
+            if (!isSafe(name) || !isSafe(value))
+                return *this;
+            remove(name);
+            return add(name, value);
+        }
+
+        /**
+         * @brief Append a raw "Name: Value" line, surrounding whitespace of the value is trimmed.
+         * @return false if the line is not a header field.
+         */
+        bool addLine(std::string_view line) {
+            auto colon = line.find(':');
+            if (colon == std::string_view::npos || colon == 0)
+                return false;
+            auto name = trim(line.substr(0, colon));
+            if (name.empty())
+                return false;
+            add(name, trim(line.substr(colon + 1)));
+            return true;
+        }
+
+        // Remove all fields with this name, returns how many were removed.
+        std::size_t remove(std::string_view name) {
+            return std::erase_if(fields, [name](const Field &field) { return equalNames(field.name(), name); });
+        }
+
+        /**
+         * @brief Value of the first field with this name, without copying it.
+         * @note The view stays valid until the map is modified or destroyed.
+         */
+        std::optional<std::string_view> find(std::string_view name) const {
+            for (const auto &field : fields) {
+                if (equalNames(field.name(), name))
+                    return field.value();
+            }
+            return std::nullopt;
+        }
+
+        // Value of the first field with this name.
+        std::optional<std::string> get(std::string_view name) const {
+            if (auto value = find(name))
+                return std::string(*value);
+            return std::nullopt;
+        }
+
+        // Values of all fields with this name, in order.
+        std::vector<std::string_view> getAll(std::string_view name) const {
+            std::vector<std::string_view> values;
+            for (const auto &field : fields) {
+                if (equalNames(field.name(), name))
+                    values.push_back(field.value());
+            }
+            return values;
+        }
+
+        bool contains(std::string_view name) const { return find(name).has_value(); }
+        std::size_t size() const { return fields.size(); }
+        bool empty() const { return fields.empty(); }
+        void clear() { fields.clear(); }
+
+        // Call fn(name, value) for each field in order.
+        template <typename Fn>
+        void forEach(Fn &&fn) const {
+            for (const auto &field : fields) {
+                fn(field.name(), field.value());
+            }
+        }
+
+        // Call fn(line) with each "Name: Value" line in order, the line is null-terminated.
+        template <typename Fn>
+        void forEachLine(Fn &&fn) const {
+            for (const auto &field : fields) {
+                fn(field.line);
+            }
+        }
+
+        static bool equalNames(std::string_view a, std::string_view b) {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                       return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+                   });
+        }
+
+    private:
+        struct Field {
+            std::string line;
+            std::size_t nameLength = 0;
+
+            std::string_view name() const { return std::string_view(line).substr(0, nameLength); }
+            std::string_view value() const { return std::string_view(line).substr(nameLength + 2); }
+        };
+
+        static bool isSafe(std::string_view text) {
+            return text.find_first_of(std::string_view("\r\n\0", 3)) == std::string_view::npos;
+        }
+
+        static std::string_view trim(std::string_view text) {
+            auto first = text.find_first_not_of(" \t\r\n");
+            if (first == std::string_view::npos)
+                return {};
+            auto last = text.find_last_not_of(" \t\r\n");
+            return text.substr(first, last - first + 1);
+        }
+
+        std::vector<Field> fields;
+    };
+
     /**
      * @brief This structure holds the result of a network request, including status code, content, and error messages.
      * @struct NetworkResult
@@ -38,6 +279,18 @@ namespace neko::network {
         // A more detailed error message, if available.
         std::string detailedErrorMessage;
 
+        // Timing breakdown, set for every request that reached libcurl (also if it failed).
+        std::optional<RequestTimings> timings;
+
+        // Response header fields of the final response, after redirects, for every request method.
+        HeaderMap headers;
+
+        // The content came from the response cache, either still fresh or confirmed by a 304 response.
+        bool fromCache = false;
+
+        // The result is a copy of an identical request that was in flight, see Network::setRequestCoalescing.
+        bool coalesced = false;
+
         /**
          * @brief Check if the request was successful.
          * @return Returns true if the request was successful (status code is between 200 and 299) and no error occurred (hasError is false), otherwise returns false.
@@ -56,13 +309,195 @@ namespace neko::network {
          * @brief Set an error message for the request result.
          * @note This function is used internally to Network set the error message.
          */
-        void setError(const std::string &message, const std::string &detailsMessage = "") {
+        void setError(std::string message, std::string detailsMessage = {}) {
             hasError = true;
-            errorMessage = message;
+            errorMessage = std::move(message);
             if (!detailsMessage.empty()) {
-                detailedErrorMessage = detailsMessage;
+                detailedErrorMessage = std::move(detailsMessage);
+            }
+        }
+    };
+
+    /**
+     * @brief Metadata of a remote resource, as returned by Network::probe.
+     */
+    struct ResourceInfo {
+        // Status code of the probe response, 2xx.
+        int statusCode = 0;
+        // Full size of the resource, unset if the server did not tell.
+        std::optional<neko::uint64> contentLength;
+        std::string contentType;
+        std::string etag;
+        std::string lastModified;
+        // The server announced or served byte ranges.
+        bool acceptsRanges = false;
+        // Response headers of the probe; after a range probe, Content-Length holds the full size.
+        HeaderMap headers;
+    };
+
+    /**
+     * @brief Cancels the requests it is attached to through RequestConfig::cancellation.
+     * @class CancellationToken
+     * @ingroup network
+     * @note A running transfer is aborted within a progress tick, a request that has not started fails at once
+     *       with "Request cancelled". Cancelling cannot be undone.
+     * @note A token created with parents is cancelled as soon as any of them is, e.g. to cancel a group of
+     *       requests that a caller can also cancel as a whole.
+     */
+    class CancellationToken {
+    public:
+        CancellationToken() = default;
+        explicit CancellationToken(const std::vector<std::shared_ptr<CancellationToken>> &parents) {
+            for (const auto &parent : parents) {
+                if (!parent)
+                    continue;
+                std::size_t id = parent->subscribe([this]() { cancel(); });
+                if (id != 0)
+                    parentSubscriptions.emplace_back(parent, id);
+            }
+        }
+        ~CancellationToken() {
+            for (auto &[parent, id] : parentSubscriptions) {
+                parent->unsubscribe(id);
+            }
+        }
+        CancellationToken(const CancellationToken &) = delete;
+        CancellationToken &operator=(const CancellationToken &) = delete;
+
+        void cancel() {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (cancelled.exchange(true, std::memory_order_acq_rel))
+                return;
+            // Callbacks run unlocked, so they may unsubscribe or destroy tokens subscribed to this one
+            runner = std::this_thread::get_id();
+            while (!callbacks.empty()) {
+                auto [id, callback] = std::move(callbacks.front());
+                callbacks.erase(callbacks.begin());
+                runningId = id;
+                lock.unlock();
+                callback();
+                lock.lock();
+                runningId = 0;
+                callbackDone.notify_all();
             }
+            runner = std::thread::id();
         }
+
+        bool isCancelled() const noexcept {
+            return cancelled.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Invoke callback once when the token is cancelled.
+         * @return std::size_t - An id for unsubscribe, or 0 if the token was already cancelled and callback has run.
+         * @note The callback runs on the thread that calls cancel(), without the token's lock held.
+         */
+        std::size_t subscribe(std::function<void()> callback) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!cancelled.load(std::memory_order_acquire)) {
+                    callbacks.emplace_back(++lastId, std::move(callback));
+                    return lastId;
+                }
+            }
+            callback();
+            return 0;
+        }
+
+        /**
+         * @brief Once this returns, the callback is not running and will not run.
+         * @note Called from a running callback (of this token), it does not wait for that callback.
+         */
+        void unsubscribe(std::size_t id) {
+            std::unique_lock<std::mutex> lock(mutex);
+            callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), [id](const auto &entry) { return entry.first == id; }), callbacks.end());
+            if (runner != std::this_thread::get_id())
+                callbackDone.wait(lock, [this, id]() { return runningId != id; });
+        }
+
+    private:
+        std::atomic<bool> cancelled{false};
+        std::mutex mutex;
+        std::condition_variable callbackDone;
+        std::size_t lastId = 0;
+        // The callback cancel() is running, 0 if none, and the thread running it
+        std::size_t runningId = 0;
+        std::thread::id runner;
+        std::vector<std::pair<std::size_t, std::function<void()>>> callbacks;
+        std::vector<std::pair<std::shared_ptr<CancellationToken>, std::size_t>> parentSubscriptions;
+    };
+
+    /**
+     * @brief Caps the receive rate of the requests it is attached to through RequestConfig::bandwidthLimiter.
+     * @class BandwidthLimiter
+     * @ingroup network
+     * @note A token bucket shared by every attached transfer: once they received more than the rate allows,
+     *       each of them pauses reading until the bucket refilled, so the sender is slowed down by TCP flow control.
+     * @note A limiter created with a parent also takes the bytes from it, e.g. a per-download cap under a global one.
+     * @note Thread-safe; the rate can be changed while transfers run.
+     */
+    class BandwidthLimiter {
+    public:
+        explicit BandwidthLimiter(neko::uint64 bytesPerSecond = 0, std::shared_ptr<BandwidthLimiter> parent = nullptr)
+            : parent(std::move(parent)), rate(bytesPerSecond) {}
+        BandwidthLimiter(const BandwidthLimiter &) = delete;
+        BandwidthLimiter &operator=(const BandwidthLimiter &) = delete;
+
+        // 0 removes the cap of this limiter, its parent's still applies
+        void setRate(neko::uint64 bytesPerSecond) {
+            std::lock_guard<std::mutex> lock(mutex);
+            rate = bytesPerSecond;
+            available = std::min(available, burst());
+        }
+
+        neko::uint64 getRate() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return rate;
+        }
+
+        // Bytes taken from this limiter so far, including those of its children, with or without a cap
+        neko::uint64 getConsumedBytes() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return consumed;
+        }
+
+        /**
+         * @brief Take bytes that were received from the bucket.
+         * @return How long the transfer should wait before it receives more, zero if it is within the rate.
+         */
+        std::chrono::steady_clock::duration consume(neko::uint64 bytes) {
+            std::chrono::steady_clock::duration wait{};
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto now = std::chrono::steady_clock::now();
+                if (rate > 0) {
+                    std::chrono::duration<double> elapsed = now - refilled;
+                    available = std::min(available + elapsed.count() * static_cast<double>(rate), burst());
+                    available -= static_cast<double>(bytes);
+                    if (available < 0)
+                        wait = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(-available / static_cast<double>(rate)));
+                }
+                refilled = now;
+                consumed += bytes;
+            }
+            if (parent)
+                wait = std::max(wait, parent->consume(bytes));
+            return wait;
+        }
+
+    private:
+        // A tenth of a second of data may arrive at once, but never less than one receive buffer
+        double burst() const {
+            return std::max(static_cast<double>(rate) / 10.0, 16.0 * 1024.0);
+        }
+
+        const std::shared_ptr<BandwidthLimiter> parent;
+        mutable std::mutex mutex;
+        neko::uint64 rate;
+        neko::uint64 consumed = 0;
+        double available = 0;
+        std::chrono::steady_clock::time_point refilled = std::chrono::steady_clock::now();
     };
 
     /**
@@ -86,20 +521,75 @@ namespace neko::network {
          * @note This field is used to set custom headers for the request.
          * @note The header should be formatted as "Key: Value" pairs, separated by newlines.
          * @note Example: "Content-Type: application/json \nAuthorization: Bearer token"
+         * @note Sent together with headers.
          */
         std::string header;
 
+        /**
+         * @brief Header fields for the request, sent after the lines of header.
+         * @note A map can be built once and assigned to many requests.
+         */
+        HeaderMap headers;
+
         /**
          * @brief Data to be sent in the body of the request.
          * @note only used for POST requests. otherwise ignored.
+         * @note Sent straight from this string, it is not copied again by libcurl.
          */
         std::string postData;
 
+        /**
+         * @brief Shared request body, used instead of postData if set.
+         * @note only used for POST requests. The body is sent from this buffer without being copied,
+         *       and copies of the config, such as the one executeAsync keeps, share the same buffer.
+         */
+        std::shared_ptr<const std::string> body;
+
+        // Returned by bodyReader to fail the request.
+        static constexpr std::size_t bodyReadAbort = static_cast<std::size_t>(-1);
+
+        /**
+         * @brief Streams the request body in chunks instead of taking it from postData, body or fileName.
+         * @note used for POST and UploadFile requests. Called with the body offset of the first byte wanted and a buffer of size bytes;
+         *       returns the number of bytes written (at most size), 0 at the end of the body, or bodyReadAbort.
+         * @note Offsets normally continue where the previous call stopped. When libcurl has to resend the body
+         *       (e.g. after a redirect), or executeWithRetry retries, reading starts again at offset 0.
+         * @note Called on the thread performing the request.
+         */
+        std::function<std::size_t(neko::uint64 offset, char *buffer, std::size_t size)> bodyReader = nullptr;
+
+        /**
+         * @brief Length of the body produced by bodyReader.
+         * @note If unset, the body is sent with chunked transfer encoding, which not every server accepts.
+         */
+        std::optional<neko::uint64> bodySize;
+
+        /**
+         * @brief Advertise the response encodings libcurl supports (gzip, deflate, br, zstd, as built) and decode them transparently.
+         * @note only used for Get and Post requests without a range; content and chunkCallback always receive decoded bytes.
+         */
+        bool acceptEncoding = true;
+
+        /**
+         * @brief gzip postData (or body) before sending it and add "Content-Encoding: gzip".
+         * @note Not applied to bodyReader bodies. The server must accept compressed request bodies. Bodies are sent unchanged
+         *       if NekoNetwork was built without zlib (NEKO_NETWORK_ENABLE_ZLIB), compression does not make them smaller
+         *       or they are larger than 4 GiB.
+         */
+        bool compressPostData = false;
+
+        /**
+         * @brief Serve and store this request through the response cache, if Network::setResponseCache enabled one.
+         * @note Only Get requests for std::string or std::vector<char> without range and chunkCallback are cached.
+         */
+        bool useCache = true;
+
         /**
          * @brief The fileName field is used to specify the name of the file to be uploaded or downloaded.
          * @note only used for UploadFile and DownloadFile request types.
          * @note For DownloadFile, this field specifies where to save the downloaded file.
-         * @note For UploadFile, this field specifies the file to be uploaded.
+         * @note For UploadFile, this field specifies the file to be uploaded. It is sent with PUT and read in chunks,
+         *       so the file is never held in memory; progressCallback reports the bytes uploaded.
          */
         std::string fileName;
 
@@ -107,6 +597,8 @@ namespace neko::network {
          * @brief Whether the download is resumable.
          * @note If true, the request will attempt to resume a previous download if the server supports it.
          * @note This is useful for large files or unreliable connections.
+         * @note For multiThreadedDownload with WriteMode::Direct, the written ranges are recorded in <fileName>.nekopart
+         *       together with the ETag/Last-Modified of the resource, and a later call only downloads the missing ranges.
          */
         bool resumable = false;
 
@@ -119,10 +611,92 @@ namespace neko::network {
          */
         std::string range;
 
+        /**
+         * @brief Write the downloaded bytes into an existing file at this offset.
+         * @note only used for DownloadFile. If set, fileName is neither truncated nor appended to;
+         *       the response body is written in place starting at this byte offset.
+         * @note When range is also set, writes beyond the range length fail the request,
+         *       so a server that ignores the Range header cannot overwrite neighbouring data.
+         * @note resumable is ignored for positional writes.
+         * @note Used by multiThreadedDownload to write segments straight into the output file.
+         */
+        std::optional<neko::uint64> writeOffset;
+
         /**
          * @brief Callback function invoked each time data is received. Can be used to calculate download progress. The parameter is usually in bytes.
          */
         std::function<void(neko::uint64)> progressCallback = nullptr;
+
+        /**
+         * @brief Callback invoked with each chunk of the response body as it arrives.
+         * @note only used for Get and Post requests. If set, the body is not buffered: content stays empty
+         *       and memory use does not grow with the response size, so large feeds can be parsed incrementally.
+         * @note Return false to abort the transfer; the result then reports an error.
+         * @note The string_view is only valid for the duration of the call.
+         */
+        std::function<bool(std::string_view)> chunkCallback = nullptr;
+
+        /**
+         * @brief Called once before the first chunk with the Content-Length of the response, so that a chunkCallback can preallocate.
+         * @note Not called if the response has no Content-Length. With a compressed response the length is that of the
+         *       encoded body, chunkCallback receives more bytes than that.
+         */
+        std::function<void(neko::uint64)> contentLengthCallback = nullptr;
+
+        /**
+         * @brief Diagnostics capture for this request.
+         * @note If unset, the Network default is used (DiagnosticsMode::OnError unless changed).
+         * @see Network::setDiagnosticsMode
+         */
+        std::optional<DiagnosticsMode> diagnostics;
+
+        /**
+         * @brief HTTP protocol version preference for this request.
+         * @note If unset, config::globalConfig.getHttpVersion() is used.
+         * @note With AsyncEngine::Multi, concurrent HTTP/2 requests to the same host wait for and share one connection.
+         */
+        std::optional<HttpVersion> httpVersion;
+
+        /**
+         * @brief Maximum time for the whole transfer, including connecting and redirects.
+         * @note Default is 0, no limit. A request that runs out of time fails with libcurl's "Timeout was reached".
+         */
+        std::chrono::milliseconds timeout{0};
+
+        /**
+         * @brief Maximum time to connect, including name resolution and the TLS handshake.
+         * @note Default is 0, libcurl's default of 300 seconds.
+         */
+        std::chrono::milliseconds connectTimeout{0};
+
+        /**
+         * @brief Abort the transfer if it is slower than lowSpeedLimit bytes per second for lowSpeedTime.
+         * @note Both must be set to take effect. Catches stalled connections that a timeout would only end much later.
+         */
+        std::size_t lowSpeedLimit = 0;
+        std::chrono::seconds lowSpeedTime{0};
+
+        /**
+         * @brief Point in time by which the request must be done, across retries and waits for a rate limit.
+         * @note Each attempt gets the time left as its timeout (the smaller of the two if timeout is also set),
+         *       a request past the deadline fails at once with "Deadline exceeded" and is not retried.
+         */
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+
+        /**
+         * @brief Cancel the request from another thread with cancellation->cancel().
+         * @note A cancelled request fails with "Request cancelled" and is not retried.
+         * @see CancellationToken
+         */
+        std::shared_ptr<CancellationToken> cancellation;
+
+        /**
+         * @brief Share a receive rate cap with other requests.
+         * @note Waiting for the limiter blocks the transfer's thread, so with AsyncEngine::Multi
+         *       these requests still run on executor tasks and never stall the I/O threads.
+         * @see BandwidthLimiter
+         */
+        std::shared_ptr<BandwidthLimiter> bandwidthLimiter;
     };
 
     /**
@@ -139,16 +713,114 @@ namespace neko::network {
          */
         int maxRetries = 3;
         /**
-         * @brief Delay between retry attempts.
+         * @brief Delay before the first retry, each further retry waits backoffMultiplier times longer.
          * @note Default is 150 milliseconds.
          */
         std::chrono::milliseconds retryDelay{150};
+        /**
+         * @brief Growth factor of the delay between retries, 1 keeps it fixed.
+         * @note Default is 2.
+         */
+        double backoffMultiplier = 2.0;
+        /**
+         * @brief Upper bound of the delay between retries, including a wait asked for by Retry-After.
+         * @note Default is 10 seconds.
+         */
+        std::chrono::milliseconds maxDelay{10000};
+        /**
+         * @brief Wait a random time between 0 and the backoff delay instead of the delay itself.
+         * @note Clients that failed together then do not retry together. Default is true.
+         */
+        bool jitter = true;
+        /**
+         * @brief Wait as long as the Retry-After header of a failed response asks, instead of the backoff delay.
+         * @note If it asks for longer than maxDelay, the request is not retried. Default is true.
+         */
+        bool honorRetryAfter = true;
         /**
          * @brief List of HTTP status codes considered successful for the request.
          * @note These status codes will be treated as successful requests, even if there are errors.
          * @note The default value is {200, 204}, which represents HTTP 200 OK and HTTP 204 No Content.
          */
         std::vector<int> successCodes = {200, 204};
+        /**
+         * @brief HTTP status codes worth retrying; any other code that is not a success ends the retries, e.g. 404.
+         * @note Requests that got no response at all (connection errors, timeouts) are always retried.
+         */
+        std::vector<int> retryableCodes = {408, 425, 429, 500, 502, 503, 504};
+        /**
+         * @brief Send a second copy of the request if the first has not finished after hedgeDelay,
+         *        and use whichever completes first.
+         * @note Only Get and Head requests without chunkCallback are hedged. The slower copy is cancelled once the other has a usable result.
+         * @note Default is false.
+         */
+        bool hedge = false;
+        /**
+         * @brief When the hedged copy is sent.
+         * @note 0 (default) uses the 95th percentile latency of the host from Network::metrics();
+         *       no copy is sent until the host has completed 20 requests.
+         */
+        std::chrono::milliseconds hedgeDelay{0};
+    };
+
+    /**
+     * @brief Limits the retries of executeWithRetry across all requests of a Network.
+     * @note A token bucket: each executeWithRetry call adds ratio tokens, each second adds minPerSecond tokens,
+     *       and each retry takes one. Without a token, the failed result is returned without retrying.
+     * @see Network::setRetryBudget
+     * @struct RetryBudget
+     * @ingroup network
+     */
+    struct RetryBudget {
+        // Retries earned per request, e.g. 0.1 allows one retry per ten requests.
+        double ratio = 0.1;
+        // Retries always available per second, so that low-traffic instances can still retry.
+        double minPerSecond = 10.0;
+        // Most tokens that can be saved up, which is the largest burst of retries.
+        double maxTokens = 100.0;
+    };
+
+    /**
+     * @brief Size and layout of the response cache.
+     * @see Network::setResponseCache
+     * @struct ResponseCacheOptions
+     * @ingroup network
+     */
+    struct ResponseCacheOptions {
+        /**
+         * @brief Memory budget for cached bodies and headers.
+         * @note Default is 32 MiB. The least recently used entries are evicted first.
+         */
+        std::size_t maxBytes = 32 * 1024 * 1024;
+        /**
+         * @brief Number of independently locked parts, each with maxBytes / shards of the budget.
+         * @note Default is 16. A response larger than one shard's budget is not cached.
+         */
+        std::size_t shards = 16;
+    };
+
+    /**
+     * @brief Concurrency limits for Network::executeBatch.
+     * @struct BatchOptions
+     * @ingroup network
+     */
+    struct BatchOptions {
+        /**
+         * @brief Maximum number of requests in flight at once.
+         * @note Default is 16. 0 means no limit.
+         */
+        std::size_t maxConcurrency = 16;
+        /**
+         * @brief Maximum number of requests in flight to one host (host and port).
+         * @note Default is 6, like common browsers. 0 means no limit.
+         */
+        std::size_t maxPerHost = 6;
+        /**
+         * @brief Cancel the rest of the batch once a request fails.
+         * @note A request fails if it has an error or an HTTP status of 400 or above. The requests in flight
+         *       are aborted and the queued ones are not sent; they all complete with "Request cancelled".
+         */
+        bool cancelOnError = false;
     };
 
     /**
@@ -181,7 +853,14 @@ namespace neko::network {
             /**
              * @note Quantity: Split the file based on the specified number of segments, where segmentParam indicates the number of segments. 0 means default value (100 segments).
              */
-            Quantity = 3
+            Quantity = 3,
+            /**
+             * @note Adaptive: A fixed set of workers, where segmentParam indicates the number of workers (0 means default value, 8 workers),
+             *       pull byte ranges from a shared queue. Ranges get smaller towards the end of the file, and an idle worker takes over
+             *       the second half of the slowest remaining range, so the finish time follows the aggregate bandwidth instead of the slowest connection.
+             * @note Always writes in place (WriteMode::Direct) and requires the server to answer range requests with 206 Partial Content.
+             */
+            Adaptive = 4
         };
         Approach approach = Approach::Auto;
 
@@ -190,6 +869,7 @@ namespace neko::network {
          * @note For Thread approach, this indicates the number of tasks (default is 100).
          * @note For Size approach, this indicates the size of each segment in bytes (default is 5MB).
          * @note For Quantity approach, this indicates the number of segments (default is 100).
+         * @note For Adaptive approach, this indicates the number of workers (default is 8).
          * @note If set to 0, the default value will be used based on the approach.
          */
         neko::uint64 segmentParam = 0;
@@ -200,6 +880,187 @@ namespace neko::network {
          * @note The default value is {200, 206}, which represents HTTP 200 OK and HTTP 206 Partial Content.
          */
         std::vector<int> successCodes = {200, 206};
+
+        /**
+         * @brief How the segments are written to config.fileName.
+         * @enum WriteMode
+         * @ingroup network
+         */
+        enum WriteMode {
+            /**
+             * @note Direct: Preallocate the output file to the content size and write every segment straight to its offset. No temporary files and no merge phase.
+             */
+            Direct = 0,
+            /**
+             * @note TempFiles: Download every segment to a temporary file under system::tempFolder(), then merge them into the output file.
+             */
+            TempFiles = 1
+        };
+        WriteMode writeMode = WriteMode::Direct;
+
+        /**
+         * @brief Maximum number of concurrent connections to the download host.
+         * @note Only used by the Adaptive approach, where it caps the number of workers. Default is 8.
+         */
+        neko::uint64 maxConnectionsPerHost = 8;
+    };
+
+    /**
+     * @brief Log-bucketed latency histogram.
+     * @note Bucket 0 counts values below 1 microsecond, bucket i (i > 0) counts values in [2^(i-1), 2^i) microseconds.
+     *       The last bucket also counts everything above its range.
+     * @struct LatencyHistogram
+     * @ingroup network
+     */
+    struct LatencyHistogram {
+        static constexpr std::size_t bucketCount = 32;
+
+        std::array<neko::uint64, bucketCount> buckets{};
+        neko::uint64 count = 0;
+        neko::uint64 sumMicroseconds = 0;
+        neko::uint64 maxMicroseconds = 0;
+
+        /// @brief Exclusive upper bound of bucket i, in microseconds.
+        static constexpr neko::uint64 bucketUpperBound(std::size_t i) {
+            return neko::uint64(1) << i;
+        }
+
+        std::chrono::microseconds mean() const {
+            return std::chrono::microseconds(count ? sumMicroseconds / count : 0);
+        }
+
+        /**
+         * @brief Approximate percentile.
+         * @param p Percentile in [0, 1], e.g. 0.99.
+         * @return The upper bound of the bucket containing the percentile, capped at the maximum observed value.
+         */
+        std::chrono::microseconds percentile(double p) const {
+            if (count == 0)
+                return std::chrono::microseconds(0);
+            auto rank = static_cast<neko::uint64>(p * static_cast<double>(count - 1)) + 1;
+            neko::uint64 seen = 0;
+            for (std::size_t i = 0; i < bucketCount; ++i) {
+                seen += buckets[i];
+                if (seen >= rank)
+                    return std::chrono::microseconds(std::min(bucketUpperBound(i), maxMicroseconds));
+            }
+            return std::chrono::microseconds(maxMicroseconds);
+        }
+    };
+
+    /**
+     * @brief Request counters of one RequestType.
+     * @note A request is failed if it reported an error or an HTTP status of 400 or above.
+     */
+    struct RequestTypeMetrics {
+        neko::uint64 inFlight = 0;
+        neko::uint64 completed = 0;
+        neko::uint64 failed = 0;
+    };
+
+    /**
+     * @brief Request counters and latency of one host.
+     * @note Latency is the total request time and is only recorded for requests that reached libcurl.
+     */
+    struct HostMetrics {
+        neko::uint64 requests = 0;
+        neko::uint64 failures = 0;
+        LatencyHistogram latency;
+    };
+
+    /**
+     * @brief Point-in-time copy of a Network's metrics.
+     * @see Network::metrics
+     * @struct MetricsSnapshot
+     * @ingroup network
+     */
+    struct MetricsSnapshot {
+        // Indexed by RequestType, use byType(type)
+        std::array<RequestTypeMetrics, requestTypeCount> requestTypes{};
+
+        neko::uint64 bytesSent = 0;
+        neko::uint64 bytesReceived = 0;
+        // Extra attempts issued by executeWithRetry and by multiThreadedDownload segment retries
+        neko::uint64 retries = 0;
+
+        // Response cache: served without a request, served after a 304, and cacheable requests sent in full
+        neko::uint64 cacheHits = 0;
+        neko::uint64 cacheRevalidated = 0;
+        neko::uint64 cacheMisses = 0;
+        // Requests answered by an identical one in flight
+        neko::uint64 coalesced = 0;
+
+        /**
+         * @brief Latency of interactive requests: Get, Post and Head without a range or a bandwidth limiter.
+         * @note Downloads and their segments are left out, so this shows what bulk transfers do to API calls.
+         *       DownloadManager backs off when its percentile rises.
+         */
+        LatencyHistogram interactiveLatency;
+
+        /**
+         * @brief Per-host metrics, keyed by "host:port" as written in the URL (port omitted if not given).
+         * @note At most 256 hosts are tracked, further hosts are counted under "<other>".
+         */
+        std::unordered_map<std::string, HostMetrics> hosts;
+
+        const RequestTypeMetrics &byType(RequestType type) const {
+            return requestTypes[static_cast<std::size_t>(type)];
+        }
+    };
+
+    /**
+     * @brief State of a host's circuit breaker.
+     * @see HostPolicy
+     */
+    enum class CircuitState {
+        // Requests pass.
+        Closed,
+        // Requests fail at once without contacting the host.
+        Open,
+        // One trial request is in flight; its outcome closes or reopens the circuit.
+        HalfOpen
+    };
+
+    /**
+     * @brief Circuit breaker and rate limit applied to each host.
+     * @see Network::setHostPolicy
+     * @struct HostPolicy
+     * @ingroup network
+     */
+    struct HostPolicy {
+        /**
+         * @brief Error rate (EWMA of failed requests) at which the circuit of a host opens.
+         * @note A request fails if it got no response or a 5xx status. Default is 0.5, 0 or above 1 never opens.
+         */
+        double failureThreshold = 0.5;
+        // Requests a host must have completed before its circuit can open.
+        neko::uint64 minRequests = 10;
+        // How long an open circuit rejects requests before one trial request is let through.
+        std::chrono::milliseconds openDuration{5000};
+        /**
+         * @brief Requests per second started to one host, 0 (default) for no limit.
+         * @note Requests over the limit are delayed, not rejected.
+         */
+        double requestsPerSecond = 0.0;
+        // Requests that may start at once after an idle period.
+        double burst = 10.0;
+    };
+
+    /**
+     * @brief Health of one host as tracked by Network.
+     * @see Network::hostHealth
+     * @struct HostHealth
+     * @ingroup network
+     */
+    struct HostHealth {
+        // Exponentially weighted moving average of the total request time.
+        std::chrono::microseconds latency{0};
+        // Exponentially weighted moving average of failed requests, 0 to 1.
+        double errorRate = 0.0;
+        // Completed requests that reached the host.
+        neko::uint64 samples = 0;
+        neko::uint64 inFlight = 0;
+        CircuitState circuit = CircuitState::Closed;
     };
 
 } // namespace neko::network
@@ -1,6 +1,7 @@
 // Neko Module
 #include <neko/network/network.hpp>
 #include <neko/network/networkCommon.hpp>
+#include <neko/network/networkDownload.hpp>
 #include <neko/network/networkTypes.hpp>
 
 #include <neko/function/utilities.hpp> // For utility functions bool to, isProxyAddress etc.
@@ -9,17 +10,40 @@
 // libcurl
 #include <curl/curl.h>
 
+#if defined(NEKO_NETWORK_USE_ZLIB)
+#include <zlib.h> // For compressPostData
+#endif
+
 // C++ STL
 #include <string>
 #include <vector>
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <thread>
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <limits>
+#include <list>
+#include <queue>
+#include <random>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 
 #include <filesystem>
 #include <fstream>
@@ -27,6 +51,10 @@
 
 #if defined(_WIN32)
 #include <winreg.h> // For Windows Proxy
+#else
+#include <cerrno>
+#include <fcntl.h>  // For positional segment writes
+#include <unistd.h>
 #endif
 
 namespace neko::network {
@@ -70,444 +98,3462 @@ namespace neko::network {
     }
 
     //=================================================
-    // Network Implementation
+    // SharedCache Implementation
     //=================================================
 
-    Network::Network(std::shared_ptr<executor::IAsyncExecutor> executor, std::shared_ptr<log::ILogger> logger)
-        : executor(std::move(executor)), logger(std::move(logger)) {
-        curl_global_init(CURL_GLOBAL_DEFAULT);
-    }
-    Network::~Network() {
-        curl_global_cleanup();
-    }
-
-    void Network::logError(const std::string &msg) {
-        if (logger)
-            logger->error("Network Error: " + msg);
-    }
-    void Network::logInfo(const std::string &msg) {
-        if (logger)
-            logger->info("Network: " + msg);
-    }
-    void Network::logWarn(const std::string &msg) {
-        if (logger)
-            logger->warn("Network: " + msg);
-    }
-    void Network::logDebug(const std::string &msg) {
-        if (logger)
-            logger->debug("Network [Debug]: " + msg);
-    }
+    /**
+     * A CURLSH object sharing the DNS cache and TLS sessions (optionally cookies) between all easy handles
+     * attached to it, with one mutex per kind of shared data.
+     * The connection cache is not shared: libcurl does not support using shared connections from concurrent
+     * threads, live connections stay with the pooled handle (or the multi handle) that opened them.
+     * Handles are attached for the duration of a lease and hold a reference, so it outlives every user.
+     */
+    class Network::SharedCache {
+    public:
+        explicit SharedCache(bool shareCookies) : cookies(shareCookies) {
+            share = curl_share_init();
+            curl_share_setopt(share, CURLSHOPT_LOCKFUNC, &lock);
+            curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, &unlock);
+            curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+            if (cookies)
+                curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
+        }
 
-    void Network::logRequestInfo(const RequestConfig &config) {
+        ~SharedCache() {
+            curl_share_cleanup(share);
+        }
 
-        std::string methodStr;
-        switch (config.method) {
-            case RequestType::Get:
-                methodStr = "GET";
-                break;
-            case RequestType::Head:
-                methodStr = "HEAD";
-                break;
-            case RequestType::Post:
-                methodStr = "POST";
-                break;
-            case RequestType::DownloadFile:
-                methodStr = "DOWNLOAD";
-                break;
-            case RequestType::UploadFile:
-                methodStr = "UPLOAD";
-                break;
-            default:
-                methodStr = "UNKNOWN";
-                break;
+        SharedCache(const SharedCache &) = delete;
+        SharedCache &operator=(const SharedCache &) = delete;
+
+        CURLSH *handle() const { return share; }
+        bool sharesCookies() const { return cookies; }
+
+        /**
+         * @brief The process-wide share, created on first use and released with the last Network using it.
+         * @note Shares with and without cookies are kept apart, so opting into cookies does not leak them to other instances.
+         */
+        static std::shared_ptr<SharedCache> process(bool shareCookies) {
+            static std::mutex mutex;
+            static std::array<std::weak_ptr<SharedCache>, 2> instances;
+
+            std::lock_guard<std::mutex> guard(mutex);
+            auto &slot = instances[shareCookies ? 1 : 0];
+            auto instance = slot.lock();
+            if (!instance) {
+                instance = std::make_shared<SharedCache>(shareCookies);
+                slot = instance;
+            }
+            return instance;
         }
-        auto sysProxy = helper::getSysProxy();
 
-        std::stringstream ss;
-        ss << "Network::logRequestInfo() : "
-           << "Request: URL: " << config.url
-           << ", Method: " << methodStr
-           << ", FileName: " << config.fileName
-           << ", Range: " << config.range
-           << ", Resumable: " << util::logic::boolTo(config.resumable)
-           << ", UserAgent: " << util::logic::boolTo(config.userAgent.empty(), config::globalConfig.getUserAgent(), config.userAgent)
-           << ", Global Protocol: " << config::globalConfig.getProtocol()
-           << ", Proxy: " << util::logic::boolTo<std::string>(config.proxy.empty(), "<none>", config.proxy)
-           << ", SysProxy: " << sysProxy.value_or("<none>")
-           << ", ID: " << config.requestId;
+    private:
+        CURLSH *share = nullptr;
+        bool cookies = false;
+        std::array<std::mutex, CURL_LOCK_DATA_LAST> mutexes;
 
-        logInfo(ss.str());
+        // libcurl does not pass the access type to the unlock function, so shared access takes the same exclusive lock
+        static void lock(CURL *, curl_lock_data data, curl_lock_access, void *userptr) {
+            static_cast<SharedCache *>(userptr)->mutexes[data].lock();
+        }
+        static void unlock(CURL *, curl_lock_data data, void *userptr) {
+            static_cast<SharedCache *>(userptr)->mutexes[data].unlock();
+        }
+    };
 
-        ss.str(""); // Clear the stringstream for next use
-        ss << "Network::logRequestInfo() : "
-           << "Header: " << util::logic::boolTo<std::string>(config.header.empty(), "<none>", config.header)
-           << ", PostData: " << util::logic::boolTo<std::string>(config.postData.empty(), "<none>", config.postData)
-           << ", ProgressCallback: " << (config.progressCallback ? "set" : "not set");
+    //=================================================
+    // HandlePool Implementation
+    //=================================================
 
-        logDebug(ss.str());
-    }
+    /**
+     * Keeps idle easy handles so that their connection cache, TLS session and DNS cache
+     * survive between requests. Handles are reset with curl_easy_reset before being pooled,
+     * which clears the options but keeps the live connections.
+     * With a SharedCache, a leased handle is attached to it and detached again on release,
+     * so idle handles never refer to a share that may be replaced.
+     */
+    struct Network::HandlePool {
+        std::mutex mutex;
+        std::vector<CURL *> idle;
+        std::atomic<std::size_t> maxIdle{16};
+        // Guarded by mutex, null unless sharing is enabled
+        std::shared_ptr<SharedCache> share;
+
+        // Returns the handle to the pool when the request is done with it.
+        struct Lease {
+            HandlePool &pool;
+            // Declared before handle, acquire() fills it in
+            std::shared_ptr<SharedCache> share;
+            CURL *handle;
+
+            Lease(HandlePool &pool) : pool(pool), handle(pool.acquire(share)) {}
+            ~Lease() { pool.release(handle, share.get()); }
+            Lease(const Lease &) = delete;
+            Lease &operator=(const Lease &) = delete;
+        };
 
-    std::optional<std::string> Network::initCurl(CURL *curl, const RequestConfig &config) {
-        std::stringstream errorMsg;
-        if (!curl) {
-            errorMsg << "Failed to initialize curl. ID: " << config.requestId;
-            logError("Network::initCurl() : " + errorMsg.str());
-            return errorMsg.str();
+        ~HandlePool() {
+            for (auto *handle : idle) {
+                curl_easy_cleanup(handle);
+            }
         }
 
-        // Set CA certificate
-        // Try to use custom cacert.pem if available
-        std::string caPath = system::workPath() + "/cacert.pem";
-        if (std::filesystem::exists(caPath)) {
-            curl_easy_setopt(curl, CURLOPT_CAINFO, caPath.c_str());
-            logDebug("Network::initCurl() : Using custom CA bundle at: " + caPath);
+        CURL *acquire(std::shared_ptr<SharedCache> &shareOut) {
+            CURL *handle = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                shareOut = share;
+                if (!idle.empty()) {
+                    handle = idle.back();
+                    idle.pop_back();
+                }
+            }
+            if (!handle)
+                handle = curl_easy_init();
+            if (handle && shareOut)
+                curl_easy_setopt(handle, CURLOPT_SHARE, shareOut->handle());
+            return handle;
         }
 
-        curl_easy_setopt(curl, CURLOPT_SSL_OPTIONS, CURLSSLOPT_NO_REVOKE);
-        auto systemProxy = helper::getSysProxy();
+        void release(CURL *handle, SharedCache *attached) {
+            if (!handle)
+                return;
+            // curl_easy_reset keeps the share, detach it explicitly
+            if (attached)
+                curl_easy_setopt(handle, CURLOPT_SHARE, nullptr);
+            curl_easy_reset(handle);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (idle.size() < maxIdle.load(std::memory_order_relaxed)) {
+                    idle.push_back(handle);
+                    return;
+                }
+            }
+            curl_easy_cleanup(handle);
+        }
 
-        // proxy = "true" means use system proxy
-        if (config.proxy == "true" && systemProxy && util::check::isProxyAddress(*systemProxy)) {
-            curl_easy_setopt(curl, CURLOPT_PROXY, systemProxy.value_or("").c_str());
-        } else if (!config.proxy.empty() && util::check::isProxyAddress(config.proxy)) {
-            curl_easy_setopt(curl, CURLOPT_PROXY, config.proxy.c_str());
-        } else {
-            curl_easy_setopt(curl, CURLOPT_PROXY, "");
-            if (!config.proxy.empty() && config.proxy != "false") {
-                errorMsg << "Invalid proxy address: " << config.proxy << ", ID: " << config.requestId;
-                logWarn("Network::initCurl() : " + errorMsg.str());
-                errorMsg.str("");
+        void shrinkTo(std::size_t capacity) {
+            std::vector<CURL *> excess;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                while (idle.size() > capacity) {
+                    excess.push_back(idle.back());
+                    idle.pop_back();
+                }
+            }
+            for (auto *handle : excess) {
+                curl_easy_cleanup(handle);
             }
         }
+    };
 
-        // Handle resumable downloads
-        if (config.resumable && !config.fileName.empty()) {
-            std::fstream infile(config.fileName, std::ios::in | std::ios::binary);
-            if (!infile.is_open()) {
-                errorMsg << "Failed to open file for resuming: " << config.fileName << ", ID: " << config.requestId;
-                logError("Network::initCurl() : " + errorMsg.str());
-                return errorMsg.str();
+    //=================================================
+    // BufferPool Implementation
+    //=================================================
+
+    namespace {
+        constexpr std::size_t maxBlockSize = BufferPool::minBlockSize << (BufferPool::sizeClasses - 1);
+
+        // Size class holding size bytes, sizeClasses if it is too large to pool
+        std::size_t sizeClassOf(std::size_t size) {
+            if (size > maxBlockSize)
+                return BufferPool::sizeClasses;
+            return size <= BufferPool::minBlockSize ? 0 : static_cast<std::size_t>(std::bit_width((size - 1) / BufferPool::minBlockSize));
+        }
+
+        constexpr std::size_t blockSizeOf(std::size_t sizeClass) {
+            return BufferPool::minBlockSize << sizeClass;
+        }
+
+        /**
+         * A few free blocks of the small classes per thread, taken and given back without a lock.
+         * Blocks are plain heap memory of their class size, so the cache serves every pool.
+         */
+        struct ThreadBlockCache {
+            static constexpr std::size_t classes = 7; // Up to 256KB
+            static constexpr std::size_t depth = 4;
+
+            std::array<std::array<char *, depth>, classes> blocks{};
+            std::array<std::size_t, classes> counts{};
+
+            ~ThreadBlockCache() {
+                for (std::size_t c = 0; c < classes; ++c) {
+                    for (std::size_t i = 0; i < counts[c]; ++i) {
+                        ::operator delete(blocks[c][i]);
+                    }
+                }
             }
 
-            infile.seekg(0, std::ios::end);
-            neko::uint64 fileSize = infile.tellg();
-            infile.close();
+            char *take(std::size_t sizeClass) {
+                if (sizeClass >= classes || counts[sizeClass] == 0)
+                    return nullptr;
+                return blocks[sizeClass][--counts[sizeClass]];
+            }
 
-            // If range download, resume from the specified range (file_size + range_start)
-            if (!config.range.empty()) {
-                neko::uint64 resumeOffset = fileSize + std::stoull(config.range.substr(0, config.range.find('-')));
-                curl_easy_setopt(curl, CURLOPT_RESUME_FROM, resumeOffset);
-            } else {
-                curl_easy_setopt(curl, CURLOPT_RESUME_FROM, fileSize);
+            bool give(std::size_t sizeClass, char *block) {
+                if (sizeClass >= classes || counts[sizeClass] == depth)
+                    return false;
+                blocks[sizeClass][counts[sizeClass]++] = block;
+                return true;
             }
-        }
+        };
 
-        // Set headers and range
-        if (!config.header.empty())
-            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, curl_slist_append(NULL, config.header.c_str()));
+        thread_local ThreadBlockCache threadBlockCache;
+    } // namespace
 
-        if (!config.range.empty())
-            curl_easy_setopt(curl, CURLOPT_RANGE, config.range.c_str());
+    BufferPool::~BufferPool() {
+        trim();
+    }
 
-        // Set user agent and URL
-        std::string userAgent = config.userAgent.empty() ? config::globalConfig.getUserAgent() : config.userAgent;
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, userAgent.c_str());
-        curl_easy_setopt(curl, CURLOPT_URL, config.url.c_str());
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 5L);
+    PooledBuffer BufferPool::acquire(std::size_t capacity) {
+        PooledBuffer buffer(shared_from_this());
+        buffer.reserve(capacity);
+        return buffer;
+    }
 
-        return std::nullopt; // No error
+    BufferPool::Stats BufferPool::stats() const {
+        Stats stats;
+        stats.allocations = allocations.load(std::memory_order_relaxed);
+        stats.reuses = reuses.load(std::memory_order_relaxed);
+        stats.cachedBytes = cachedBytes.load(std::memory_order_relaxed);
+        return stats;
     }
 
-    int Network::getHttpStatusCode(CURL *curl) {
-        long statusCode = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &statusCode);
-        return static_cast<int>(statusCode);
+    void BufferPool::trim() {
+        for (std::size_t c = 0; c < sizeClasses; ++c) {
+            std::vector<char *> blocks;
+            {
+                std::lock_guard<std::mutex> lock(freeLists[c].mutex);
+                blocks.swap(freeLists[c].blocks);
+            }
+            cachedBytes.fetch_sub(blocks.size() * blockSizeOf(c), std::memory_order_relaxed);
+            for (char *block : blocks) {
+                ::operator delete(block);
+            }
+        }
     }
 
-    // This callback function is used to handle libcurl debug messages, called only in Network::performRequest function.
-    namespace {
-        neko::uint64 debugCallback(CURL *handle, curl_infotype type, char *data, neko::uint64 size, void *userptr) {
-            if (type == CURLINFO_TEXT || type == CURLINFO_SSL_DATA_IN || type == CURLINFO_SSL_DATA_OUT) {
-                if (userptr) {
-                    static_cast<std::vector<std::string> *>(userptr)->emplace_back(std::string(data, size));
-                }
+    char *BufferPool::allocate(std::size_t size, std::size_t &capacity) {
+        std::size_t sizeClass = sizeClassOf(size);
+        if (sizeClass == sizeClasses) {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            capacity = size;
+            return static_cast<char *>(::operator new(size));
+        }
+
+        capacity = blockSizeOf(sizeClass);
+        char *block = threadBlockCache.take(sizeClass);
+        if (!block) {
+            FreeList &list = freeLists[sizeClass];
+            std::lock_guard<std::mutex> lock(list.mutex);
+            if (!list.blocks.empty()) {
+                block = list.blocks.back();
+                list.blocks.pop_back();
+                cachedBytes.fetch_sub(capacity, std::memory_order_relaxed);
             }
-            return 0;
         }
-    } // namespace
+        if (block) {
+            reuses.fetch_add(1, std::memory_order_relaxed);
+            return block;
+        }
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return static_cast<char *>(::operator new(capacity));
+    }
 
-    template <typename T>
-    NetworkResult<T> Network::performRequest(CURL *curl, const RequestConfig &config) {
-        NetworkResult<T> result;
-        std::stringstream ss;
+    void BufferPool::recycle(char *block, std::size_t capacity) noexcept {
+        std::size_t sizeClass = sizeClassOf(capacity);
+        // Blocks outside the classes were allocated to size
+        if (sizeClass == sizeClasses || blockSizeOf(sizeClass) != capacity) {
+            ::operator delete(block);
+            return;
+        }
+        if (threadBlockCache.give(sizeClass, block))
+            return;
+
+        // The free lists may exceed the limit by the blocks of concurrent releases, never by more
+        if (cachedBytes.fetch_add(capacity, std::memory_order_relaxed) + capacity <= maxCachedBytes) {
+            FreeList &list = freeLists[sizeClass];
+            try {
+                std::lock_guard<std::mutex> lock(list.mutex);
+                list.blocks.push_back(block);
+                return;
+            } catch (...) {
+                // Out of memory for the list itself, free the block below
+            }
+        }
+        cachedBytes.fetch_sub(capacity, std::memory_order_relaxed);
+        ::operator delete(block);
+    }
 
-        ss << "Network::performRequest() : "
-           << "Performing request, URL: " << config.url
-           << ", Method: " << static_cast<int>(config.method)
-           << ", ID: " << config.requestId;
-        logInfo(ss.str());
-        ss.str("");
+    void PooledBuffer::reserve(std::size_t capacity) {
+        if (capacity <= room)
+            return;
+        std::size_t newRoom = capacity;
+        char *block = pool ? pool->allocate(capacity, newRoom) : static_cast<char *>(::operator new(capacity));
+        if (length > 0)
+            std::memcpy(block, bytes, length);
+        std::size_t kept = length;
+        reset();
+        bytes = block;
+        length = kept;
+        room = newRoom;
+    }
 
-        // Set up debug messages vector
-        std::vector<std::string> curlDebugMsgs;
-        curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+    void PooledBuffer::append(const char *data, std::size_t size) {
+        if (size == 0)
+            return;
+        if (length + size > room)
+            reserve(std::max(length + size, room * 2));
+        std::memcpy(bytes + length, data, size);
+        length += size;
+    }
 
-        curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION, &debugCallback);
-        curl_easy_setopt(curl, CURLOPT_DEBUGDATA, &curlDebugMsgs);
+    void PooledBuffer::reset() noexcept {
+        if (bytes) {
+            if (pool)
+                pool->recycle(bytes, room);
+            else
+                ::operator delete(bytes);
+        }
+        bytes = nullptr;
+        length = 0;
+        room = 0;
+    }
 
-        // Output libcurl version information
-        curl_version_info_data *ver = curl_version_info(CURLVERSION_NOW);
-        ss << "Network::performRequest() : "
-           << "libcurl version: " << ver->version
-           << ", SSL version: " << ver->ssl_version
-           << ", ID: " << config.requestId;
-        logInfo(ss.str());
-        ss.str("");
+    //=================================================
+    // Metrics Implementation
+    //=================================================
 
-        // Execute request
-        CURLcode res = curl_easy_perform(curl);
+    namespace {
+        /**
+         * Host part of a URL including the port if given, lowercased.
+         * "https://User@Example.com:8443/path?q" -> "example.com:8443"
+         */
+        std::string hostOf(const std::string &url) {
+            std::string_view view(url);
+            auto scheme = view.find("://");
+            if (scheme != std::string_view::npos)
+                view.remove_prefix(scheme + 3);
+            view = view.substr(0, view.find_first_of("/?#"));
+            auto at = view.rfind('@');
+            if (at != std::string_view::npos)
+                view.remove_prefix(at + 1);
+
+            std::string host(view);
+            std::transform(host.begin(), host.end(), host.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return host;
+        }
 
-        // Get connection IP
-        char *ip = nullptr;
-        curl_easy_getinfo(curl, CURLINFO_PRIMARY_IP, &ip);
+        // CURL_HTTP_VERSION_* value for a preference, HttpVersion::Default leaves libcurl's default
+        long curlHttpVersion(HttpVersion version) {
+            switch (version) {
+                case HttpVersion::Http1_1:
+                    return CURL_HTTP_VERSION_1_1;
+                case HttpVersion::Http2:
+                    return CURL_HTTP_VERSION_2_0;
+                case HttpVersion::Http2Tls:
+                    return CURL_HTTP_VERSION_2TLS;
+                case HttpVersion::Http2PriorKnowledge:
+                    return CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+                case HttpVersion::Http3: {
+                    // Only request HTTP/3 if this libcurl was built with it, otherwise setopt fails
+                    static const bool supported = (curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP3) != 0;
+                    return supported ? CURL_HTTP_VERSION_3 : CURL_HTTP_VERSION_2TLS;
+                }
+                case HttpVersion::Default:
+                default:
+                    return CURL_HTTP_VERSION_NONE;
+            }
+        }
 
-        // Set status code
-        result.statusCode = getHttpStatusCode(curl);
+        std::string httpVersionName(long version) {
+            switch (version) {
+                case CURL_HTTP_VERSION_1_0:
+                    return "HTTP/1.0";
+                case CURL_HTTP_VERSION_1_1:
+                    return "HTTP/1.1";
+                case CURL_HTTP_VERSION_2_0:
+                    return "HTTP/2";
+                case CURL_HTTP_VERSION_3:
+                    return "HTTP/3";
+                default:
+                    return std::string();
+            }
+        }
+    } // namespace
 
-        if (res != CURLE_OK) {
-            // Handle error
-            ss << "Failed to get network req: " << std::string(curl_easy_strerror(res)) << ", ID: " << config.requestId << ", IP: " << (ip ? ip : "N/A");
+    /**
+     * Counters are plain relaxed atomics so the request path never takes a lock,
+     * except for a shared lock to find the host entry (an exclusive one the first time a host is seen).
+     * Host entries are never removed, reset only zeroes them, so references stay valid.
+     */
+    struct Network::Metrics {
+        static constexpr std::size_t maxHosts = 256;
+
+        struct TypeCounters {
+            std::atomic<neko::uint64> inFlight{0};
+            std::atomic<neko::uint64> completed{0};
+            std::atomic<neko::uint64> failed{0};
+        };
 
-            std::string basicMsg = ss.str();
-            logError(basicMsg);
-            ss.str("");
+        struct HostCounters {
+            std::atomic<neko::uint64> requests{0};
+            std::atomic<neko::uint64> failures{0};
+            std::array<std::atomic<neko::uint64>, LatencyHistogram::bucketCount> buckets{};
+            std::atomic<neko::uint64> count{0};
+            std::atomic<neko::uint64> sum{0};
+            std::atomic<neko::uint64> max{0};
+
+            void recordLatency(neko::uint64 micros) {
+                std::size_t bucket = std::min<std::size_t>(std::bit_width(micros), LatencyHistogram::bucketCount - 1);
+                buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+                count.fetch_add(1, std::memory_order_relaxed);
+                sum.fetch_add(micros, std::memory_order_relaxed);
+                neko::uint64 current = max.load(std::memory_order_relaxed);
+                while (micros > current && !max.compare_exchange_weak(current, micros, std::memory_order_relaxed)) {
+                }
+            }
 
-            // Add debug messages
-            for (const auto &dbg : curlDebugMsgs) {
-                ss << "\n[Debug] " << dbg;
+            void reset() {
+                requests.store(0, std::memory_order_relaxed);
+                failures.store(0, std::memory_order_relaxed);
+                for (auto &bucket : buckets) {
+                    bucket.store(0, std::memory_order_relaxed);
+                }
+                count.store(0, std::memory_order_relaxed);
+                sum.store(0, std::memory_order_relaxed);
+                max.store(0, std::memory_order_relaxed);
             }
 
-            // Add certificate information
-            struct curl_certinfo *ci = nullptr;
-            if (curl_easy_getinfo(curl, CURLINFO_CERTINFO, &ci) == CURLE_OK && ci) {
-                for (int i = 0; i < ci->num_of_certs; i++) {
-                    struct curl_slist *slist = ci->certinfo[i];
-                    for (; slist; slist = slist->next) {
-                        ss << "\n[CERT] " << slist->data;
-                    }
+            LatencyHistogram latency() const {
+                LatencyHistogram histogram;
+                for (std::size_t i = 0; i < LatencyHistogram::bucketCount; ++i) {
+                    histogram.buckets[i] = buckets[i].load(std::memory_order_relaxed);
                 }
+                histogram.count = count.load(std::memory_order_relaxed);
+                histogram.sumMicroseconds = sum.load(std::memory_order_relaxed);
+                histogram.maxMicroseconds = max.load(std::memory_order_relaxed);
+                return histogram;
             }
+        };
 
-            logDebug(ss.str());
-            result.setError(basicMsg, ss.str());
-            return result;
+        std::array<TypeCounters, requestTypeCount> types;
+        std::atomic<neko::uint64> bytesSent{0};
+        std::atomic<neko::uint64> bytesReceived{0};
+        std::atomic<neko::uint64> retries{0};
+        std::atomic<neko::uint64> cacheHits{0};
+        std::atomic<neko::uint64> cacheRevalidated{0};
+        std::atomic<neko::uint64> cacheMisses{0};
+        std::atomic<neko::uint64> coalesced{0};
+        // Latency of interactive requests only, see MetricsSnapshot::interactiveLatency
+        HostCounters interactive;
+
+        std::shared_mutex hostsMutex;
+        std::unordered_map<std::string, std::unique_ptr<HostCounters>> hosts;
+
+        TypeCounters &type(RequestType requestType) {
+            return types[static_cast<std::size_t>(requestType)];
         }
-        ss << "Network::performRequest() : "
-           << "Request completed successfully, ID: " << config.requestId
-           << ", Status Code: " << result.statusCode;
 
-        logInfo(ss.str());
-        return result;
-    }
+        HostCounters &host(const std::string &name) {
+            {
+                std::shared_lock<std::shared_mutex> lock(hostsMutex);
+                auto it = hosts.find(name);
+                if (it != hosts.end())
+                    return *it->second;
+            }
+            std::unique_lock<std::shared_mutex> lock(hostsMutex);
+            const std::string &key = (hosts.size() < maxHosts || hosts.count(name)) ? name : otherHost;
+            auto &entry = hosts[key];
+            if (!entry)
+                entry = std::make_unique<HostCounters>();
+            return *entry;
+        }
 
-    template <typename T>
-    NetworkResult<T> Network::handleGetRequest(CURL *curl, const RequestConfig &config) {
-        T content{};
-        helper::WriteCallbackContext<T> writeContext;
-        writeContext.buffer = &content;
-        writeContext.progressCallback = const_cast<std::function<void(neko::uint64)>*>(&config.progressCallback);
+        MetricsSnapshot snapshot() {
+            MetricsSnapshot result;
+            for (std::size_t i = 0; i < requestTypeCount; ++i) {
+                result.requestTypes[i].inFlight = types[i].inFlight.load(std::memory_order_relaxed);
+                result.requestTypes[i].completed = types[i].completed.load(std::memory_order_relaxed);
+                result.requestTypes[i].failed = types[i].failed.load(std::memory_order_relaxed);
+            }
+            result.bytesSent = bytesSent.load(std::memory_order_relaxed);
+            result.bytesReceived = bytesReceived.load(std::memory_order_relaxed);
+            result.retries = retries.load(std::memory_order_relaxed);
+            result.cacheHits = cacheHits.load(std::memory_order_relaxed);
+            result.cacheRevalidated = cacheRevalidated.load(std::memory_order_relaxed);
+            result.cacheMisses = cacheMisses.load(std::memory_order_relaxed);
+            result.coalesced = coalesced.load(std::memory_order_relaxed);
+            result.interactiveLatency = interactive.latency();
+
+            std::shared_lock<std::shared_mutex> lock(hostsMutex);
+            for (const auto &[name, counters] : hosts) {
+                HostMetrics &host = result.hosts[name];
+                host.requests = counters->requests.load(std::memory_order_relaxed);
+                host.failures = counters->failures.load(std::memory_order_relaxed);
+                host.latency = counters->latency();
+            }
+            return result;
+        }
 
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &helper::writeToCallback<T>);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &writeContext);
+        void reset() {
+            // inFlight is left alone, requests that are running still finish later
+            for (auto &counters : types) {
+                counters.completed.store(0, std::memory_order_relaxed);
+                counters.failed.store(0, std::memory_order_relaxed);
+            }
+            bytesSent.store(0, std::memory_order_relaxed);
+            bytesReceived.store(0, std::memory_order_relaxed);
+            retries.store(0, std::memory_order_relaxed);
+            cacheHits.store(0, std::memory_order_relaxed);
+            cacheRevalidated.store(0, std::memory_order_relaxed);
+            cacheMisses.store(0, std::memory_order_relaxed);
+            coalesced.store(0, std::memory_order_relaxed);
+            interactive.reset();
+
+            std::shared_lock<std::shared_mutex> lock(hostsMutex);
+            for (auto &[name, counters] : hosts) {
+                counters->reset();
+            }
+        }
 
-        NetworkResult<T> result = performRequest<T>(curl, config);
+    private:
+        inline static const std::string otherHost = "<other>";
+    };
 
-        if (!result.hasError) {
-            result.content = std::move(content);
-        }
+    //=================================================
+    // Timer and RetryLimiter Implementation
+    //=================================================
 
-        return result;
-    }
+    /**
+     * Counts the tasks handed to the executor or to detached threads. Their futures do not block like
+     * those of std::async, so the Network waits here before it frees what the tasks use.
+     */
+    class Network::TaskGroup {
+    public:
+        // The task counts as running until the returned handle and all its copies are destroyed
+        std::shared_ptr<void> hold() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++active;
+            }
+            return std::shared_ptr<void>(nullptr, [this](void *) { release(); });
+        }
 
-    template <typename T>
-    NetworkResult<T> Network::handleHeadRequest(CURL *curl, const RequestConfig &config) {
-        std::string headerContent;
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            idle.wait(lock, [this]() { return active == 0; });
+        }
 
-        // HEAD requests don't have a response body, only headers
-        // Use CURLOPT_HEADERFUNCTION to capture the response headers
-        curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
-        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &helper::headerCallback);
-        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &headerContent);
+    private:
+        void release() {
+            // Notified under the lock, the waiter may destroy the group as soon as it sees no task
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active == 0)
+                idle.notify_all();
+        }
 
-        NetworkResult<T> result = performRequest<T>(curl, config);
+        std::mutex mutex;
+        std::condition_variable idle;
+        std::size_t active = 0;
+    };
+
+    /**
+     * Runs tasks after a delay on one thread, started with the first scheduled task.
+     * Tasks are called with cancelled = true instead if the timer stops first, and right away once it has stopped,
+     * so every scheduled task runs exactly once.
+     */
+    class Network::Timer {
+    public:
+        using Task = std::function<void(bool cancelled)>;
+
+        ~Timer() {
+            stop();
+        }
 
-        if (!result.hasError) {
-            // Convert headerContent to the appropriate type T
-            if constexpr (std::is_same_v<T, std::string>) {
-                result.content = std::move(headerContent);
-            } else if constexpr (std::is_same_v<T, std::vector<char>>) {
-                result.content = std::vector<char>(headerContent.begin(), headerContent.end());
+        void schedule(std::chrono::steady_clock::duration delay, Task task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!stopping) {
+                    if (!thread.joinable())
+                        thread = std::thread([this]() { run(); });
+                    queue.push(Entry{std::chrono::steady_clock::now() + delay, nextSequence++, std::move(task)});
+                    wakeup.notify_one();
+                    return;
+                }
             }
-            // For other types like std::fstream, headers are not typically stored
+            task(true);
         }
 
-        return result;
-    }
+        // Stop the thread and cancel the pending tasks, later tasks are cancelled when scheduled
+        void stop() {
+            std::vector<Task> cancelled;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stopping)
+                    return;
+                stopping = true;
+                wakeup.notify_one();
+            }
+            if (thread.joinable())
+                thread.join();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                while (!queue.empty()) {
+                    cancelled.push_back(std::move(const_cast<Entry &>(queue.top()).task));
+                    queue.pop();
+                }
+            }
+            for (auto &task : cancelled) {
+                task(true);
+            }
+        }
 
-    template <typename T>
-    NetworkResult<T> Network::handlePostRequest(CURL *curl, const RequestConfig &config) {
-        T content{};
-        helper::WriteCallbackContext<T> writeContext;
-        writeContext.buffer = &content;
-        writeContext.progressCallback = const_cast<std::function<void(neko::uint64)>*>(&config.progressCallback);
+    private:
+        struct Entry {
+            std::chrono::steady_clock::time_point due;
+            neko::uint64 sequence;
+            Task task;
 
-        curl_easy_setopt(curl, CURLOPT_POST, 1L);
-        curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, config.postData.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &helper::writeToCallback<T>);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &writeContext);
+            // Earliest due first, in scheduling order for equal times
+            bool operator>(const Entry &other) const {
+                return due != other.due ? due > other.due : sequence > other.sequence;
+            }
+        };
 
-        NetworkResult<T> result = performRequest<T>(curl, config);
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopping) {
+                if (queue.empty()) {
+                    wakeup.wait(lock);
+                    continue;
+                }
+                auto due = queue.top().due;
+                if (due > std::chrono::steady_clock::now()) {
+                    wakeup.wait_until(lock, due);
+                    continue;
+                }
+                Task task = std::move(const_cast<Entry &>(queue.top()).task);
+                queue.pop();
+                lock.unlock();
+                task(false);
+                lock.lock();
+            }
+        }
 
-        if (!result.hasError) {
-            result.content = std::move(content);
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+        neko::uint64 nextSequence = 0;
+        bool stopping = false;
+        std::thread thread;
+    };
+
+    // Token bucket of setRetryBudget, allows every retry while no budget is set.
+    class Network::RetryLimiter {
+    public:
+        void configure(std::optional<RetryBudget> value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            budget = value;
+            tokens = budget ? budget->maxTokens : 0.0;
+            lastRefill = std::chrono::steady_clock::now();
         }
 
-        return result;
-    }
+        std::optional<RetryBudget> get() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return budget;
+        }
 
-    template <typename T>
-    NetworkResult<T> Network::handleDownloadRequest(CURL *curl, const RequestConfig &config) {
-        NetworkResult<T> result;
+        // A request that may retry starts
+        void deposit() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (budget)
+                tokens = std::min(budget->maxTokens, tokens + budget->ratio);
+        }
 
-        std::fstream file(config.fileName, std::ios::out | std::ios::binary | (config.resumable ? std::ios::app : std::ios::trunc));
-        if (!file.is_open()) {
-            std::string errorMsg = "Failed to open file for writing: " + config.fileName + ", ID: " + config.requestId;
-            logError("Network::handleDownloadRequest() : " + errorMsg);
-            result.setError("File operation error : ", errorMsg);
-            return result;
+        // Take a token for one retry, false if the budget is used up
+        bool withdraw() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!budget)
+                return true;
+            auto now = std::chrono::steady_clock::now();
+            std::chrono::duration<double> elapsed = now - lastRefill;
+            lastRefill = now;
+            tokens = std::min(budget->maxTokens, tokens + elapsed.count() * budget->minPerSecond);
+            if (tokens < 1.0)
+                return false;
+            tokens -= 1.0;
+            return true;
         }
 
-        helper::WriteCallbackContext<std::fstream> writeContext;
-        writeContext.buffer = &file;
-        writeContext.progressCallback = const_cast<std::function<void(neko::uint64)>*>(&config.progressCallback);
+    private:
+        mutable std::mutex mutex;
+        std::optional<RetryBudget> budget;
+        double tokens = 0.0;
+        std::chrono::steady_clock::time_point lastRefill = std::chrono::steady_clock::now();
+    };
 
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &helper::writeToCallback<std::fstream>);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &writeContext);
+    //=================================================
+    // HostTracker Implementation
+    //=================================================
 
-        result = performRequest<T>(curl, config);
-        return result;
-    }
+    /**
+     * Health of each host: latency and error rate EWMAs, requests in flight, circuit breaker and rate limit tokens.
+     * Hosts are keyed like the metrics (hostOf); at most maxHosts are tracked, further hosts are not limited.
+     */
+    class Network::HostTracker {
+    public:
+        static constexpr std::size_t maxHosts = 256;
+        // Weight of the newest sample in the moving averages
+        static constexpr double alpha = 0.2;
+
+        void configure(std::optional<HostPolicy> value) {
+            std::unique_lock<std::shared_mutex> lock(hostsMutex);
+            policy = value;
+            for (auto &[name, host] : hosts) {
+                std::lock_guard<std::mutex> hostLock(host->mutex);
+                host->circuit = CircuitState::Closed;
+                host->tokens = policy ? policy->burst : 0.0;
+                host->lastRefill = std::chrono::steady_clock::now();
+            }
+        }
 
-    template <typename T>
-    NetworkResult<T> Network::doExecute(const RequestConfig &config) {
-        logRequestInfo(config);
+        std::optional<HostPolicy> getPolicy() const {
+            std::shared_lock<std::shared_mutex> lock(hostsMutex);
+            return policy;
+        }
 
-        CURL *curl = curl_easy_init();
-        NetworkResult<T> result;
+        void started(const std::string &name) {
+            if (auto *host = find(name, true))
+                host->inFlight.fetch_add(1, std::memory_order_relaxed);
+        }
 
-        auto initError = initCurl(curl, config);
-        if (initError.has_value()) {
-            result.setError("Failed to initialize libcurl", initError.value());
-            if (curl)
-                curl_easy_cleanup(curl);
-            return result;
+        // A started request ended; reached is false if it never got to the host (e.g. setup failed)
+        void ended(const std::string &name, bool reached, bool failed, std::chrono::microseconds latency, const std::function<void(CircuitState)> &onTransition) {
+            auto *host = find(name, true);
+            if (!host)
+                return;
+            host->inFlight.fetch_sub(1, std::memory_order_relaxed);
+
+            auto current = getPolicy();
+            std::optional<CircuitState> transition;
+            {
+                std::lock_guard<std::mutex> lock(host->mutex);
+                if (!reached) {
+                    // A trial that never reached the host decides nothing, let the next request try
+                    if (host->circuit == CircuitState::HalfOpen)
+                        host->circuit = CircuitState::Open;
+                    return;
+                }
+                double sample = static_cast<double>(latency.count());
+                host->latency = host->samples == 0 ? sample : alpha * sample + (1 - alpha) * host->latency;
+                host->errorRate = alpha * (failed ? 1.0 : 0.0) + (1 - alpha) * host->errorRate;
+                ++host->samples;
+
+                if (!current)
+                    return;
+                if (host->circuit == CircuitState::HalfOpen) {
+                    host->circuit = failed ? CircuitState::Open : CircuitState::Closed;
+                    host->openedAt = std::chrono::steady_clock::now();
+                    if (!failed)
+                        host->errorRate = 0.0;
+                    transition = host->circuit;
+                } else if (host->circuit == CircuitState::Closed && host->samples >= current->minRequests &&
+                           current->failureThreshold > 0.0 && host->errorRate >= current->failureThreshold) {
+                    host->circuit = CircuitState::Open;
+                    host->openedAt = std::chrono::steady_clock::now();
+                    transition = host->circuit;
+                }
+            }
+            if (transition && onTransition)
+                onTransition(*transition);
         }
 
+        // false if the circuit is open; lets one trial through once openDuration has passed
+        bool admit(const std::string &name) {
+            auto current = getPolicy();
+            if (!current)
+                return true;
+            auto *host = find(name, false);
+            if (!host)
+                return true;
+            std::lock_guard<std::mutex> lock(host->mutex);
+            switch (host->circuit) {
+                case CircuitState::Closed:
+                    return true;
+                case CircuitState::Open:
+                    if (std::chrono::steady_clock::now() - host->openedAt < current->openDuration)
+                        return false;
+                    host->circuit = CircuitState::HalfOpen;
+                    return true;
+                case CircuitState::HalfOpen:
+                default:
+                    return false;
+            }
+        }
+
+        // Take a rate limit token, returns how long to wait before starting the request
+        std::chrono::steady_clock::duration reserve(const std::string &name) {
+            auto current = getPolicy();
+            if (!current || current->requestsPerSecond <= 0.0)
+                return std::chrono::steady_clock::duration::zero();
+            auto *host = find(name, true);
+            if (!host)
+                return std::chrono::steady_clock::duration::zero();
+
+            std::lock_guard<std::mutex> lock(host->mutex);
+            auto now = std::chrono::steady_clock::now();
+            std::chrono::duration<double> elapsed = now - host->lastRefill;
+            host->lastRefill = now;
+            host->tokens = std::min(current->burst, host->tokens + elapsed.count() * current->requestsPerSecond);
+            // Reserving ahead (negative tokens) paces the waiting requests one interval apart
+            host->tokens -= 1.0;
+            if (host->tokens >= 0.0)
+                return std::chrono::steady_clock::duration::zero();
+            return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(-host->tokens / current->requestsPerSecond));
+        }
+
+        HostHealth health(const std::string &name) const {
+            HostHealth result;
+            std::shared_lock<std::shared_mutex> lock(hostsMutex);
+            auto it = hosts.find(name);
+            if (it == hosts.end())
+                return result;
+            const Host &host = *it->second;
+            std::lock_guard<std::mutex> hostLock(host.mutex);
+            result.latency = std::chrono::microseconds(static_cast<std::chrono::microseconds::rep>(host.latency));
+            result.errorRate = host.errorRate;
+            result.samples = host.samples;
+            result.inFlight = static_cast<neko::uint64>(std::max<neko::int64>(0, host.inFlight.load(std::memory_order_relaxed)));
+            result.circuit = host.circuit;
+            return result;
+        }
+
+    private:
+        struct Host {
+            mutable std::mutex mutex;
+            std::atomic<neko::int64> inFlight{0};
+            double latency = 0.0;
+            double errorRate = 0.0;
+            neko::uint64 samples = 0;
+            CircuitState circuit = CircuitState::Closed;
+            std::chrono::steady_clock::time_point openedAt{};
+            double tokens = 0.0;
+            std::chrono::steady_clock::time_point lastRefill = std::chrono::steady_clock::now();
+        };
+
+        Host *find(const std::string &name, bool create) {
+            {
+                std::shared_lock<std::shared_mutex> lock(hostsMutex);
+                auto it = hosts.find(name);
+                if (it != hosts.end())
+                    return it->second.get();
+                if (!create || hosts.size() >= maxHosts)
+                    return nullptr;
+            }
+            std::unique_lock<std::shared_mutex> lock(hostsMutex);
+            if (hosts.size() >= maxHosts && !hosts.count(name))
+                return nullptr;
+            auto &entry = hosts[name];
+            if (!entry) {
+                entry = std::make_unique<Host>();
+                entry->tokens = policy ? policy->burst : 0.0;
+            }
+            return entry.get();
+        }
+
+        mutable std::shared_mutex hostsMutex;
+        std::unordered_map<std::string, std::unique_ptr<Host>> hosts;
+        std::optional<HostPolicy> policy;
+    };
+
+    //=================================================
+    // MultiEngine Implementation
+    //=================================================
+
+    /**
+     * Drives asynchronous requests with curl_multi on a fixed number of I/O threads.
+     * Each thread owns one multi handle with HTTP/2 multiplexing enabled. Requests are assigned by host,
+     * so all requests to one host run on the same multi handle and can share its connections.
+     * Completion callbacks run on the I/O thread that finished the transfer.
+     */
+    class Network::MultiEngine {
+    public:
+        using Completion = std::function<void(int)>;
+
+        explicit MultiEngine(std::size_t ioThreads) {
+            for (std::size_t i = 0; i < ioThreads; ++i) {
+                auto worker = std::make_unique<Worker>();
+                worker->multi = curl_multi_init();
+                curl_multi_setopt(worker->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+                workers.push_back(std::move(worker));
+            }
+            for (auto &worker : workers) {
+                worker->thread = std::thread([w = worker.get()]() { run(*w); });
+            }
+        }
+
+        ~MultiEngine() {
+            for (auto &worker : workers) {
+                worker->stop.store(true);
+                curl_multi_wakeup(worker->multi);
+            }
+            for (auto &worker : workers) {
+                if (worker->thread.joinable())
+                    worker->thread.join();
+                curl_multi_cleanup(worker->multi);
+            }
+        }
+
+        MultiEngine(const MultiEngine &) = delete;
+        MultiEngine &operator=(const MultiEngine &) = delete;
+
+        /**
+         * @brief Hand a fully configured easy handle to the engine.
+         * @param host Requests with the same host go to the same I/O thread, see hostOf(). Empty spreads round-robin.
+         * @note onDone is invoked exactly once with the transfer's CURLcode. If the engine shuts down first,
+         *       it is invoked with CURLE_ABORTED_BY_CALLBACK.
+         */
+        void submit(CURL *handle, const std::string &host, Completion onDone) {
+            std::size_t index = host.empty() ? next.fetch_add(1, std::memory_order_relaxed) : std::hash<std::string>{}(host);
+            Worker &worker = *workers[index % workers.size()];
+            {
+                std::lock_guard<std::mutex> lock(worker.mutex);
+                worker.incoming.emplace_back(handle, std::move(onDone));
+            }
+            curl_multi_wakeup(worker.multi);
+        }
+
+        // Let every I/O thread run its transfers now instead of at the next poll timeout, e.g. to abort a cancelled one
+        void wakeAll() {
+            for (auto &worker : workers) {
+                curl_multi_wakeup(worker->multi);
+            }
+        }
+
+        std::size_t threadCount() const {
+            return workers.size();
+        }
+
+    private:
+        struct Worker {
+            CURLM *multi = nullptr;
+            std::thread thread;
+            std::atomic<bool> stop{false};
+
+            std::mutex mutex;
+            std::vector<std::pair<CURL *, Completion>> incoming;
+
+            // Only touched by the worker thread
+            std::unordered_map<CURL *, Completion> active;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<std::size_t> next{0};
+
+        static void run(Worker &worker) {
+            std::vector<std::pair<CURL *, Completion>> pending;
+
+            while (!worker.stop.load()) {
+                {
+                    std::lock_guard<std::mutex> lock(worker.mutex);
+                    pending.swap(worker.incoming);
+                }
+                for (auto &[handle, onDone] : pending) {
+                    if (curl_multi_add_handle(worker.multi, handle) != CURLM_OK) {
+                        onDone(CURLE_FAILED_INIT);
+                        continue;
+                    }
+                    worker.active.emplace(handle, std::move(onDone));
+                }
+                pending.clear();
+
+                int running = 0;
+                curl_multi_perform(worker.multi, &running);
+
+                int queued = 0;
+                while (CURLMsg *msg = curl_multi_info_read(worker.multi, &queued)) {
+                    if (msg->msg != CURLMSG_DONE)
+                        continue;
+                    CURL *handle = msg->easy_handle;
+                    CURLcode result = msg->data.result;
+                    curl_multi_remove_handle(worker.multi, handle);
+
+                    auto it = worker.active.find(handle);
+                    if (it == worker.active.end())
+                        continue;
+                    Completion onDone = std::move(it->second);
+                    worker.active.erase(it);
+                    onDone(result);
+                }
+
+                curl_multi_poll(worker.multi, nullptr, 0, 1000, nullptr);
+            }
+
+            // Shutting down: fail everything that has not finished yet
+            for (auto &[handle, onDone] : worker.active) {
+                curl_multi_remove_handle(worker.multi, handle);
+                onDone(CURLE_ABORTED_BY_CALLBACK);
+            }
+            worker.active.clear();
+
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            for (auto &[handle, onDone] : worker.incoming) {
+                onDone(CURLE_ABORTED_BY_CALLBACK);
+            }
+            worker.incoming.clear();
+        }
+    };
+
+    //=================================================
+    // Request defaults
+    //=================================================
+
+    /**
+     * Settings shared by every request that are expensive to look up: the system proxy reads
+     * environment variables (and the registry on Windows), the CA bundle needs a filesystem check,
+     * and the global config is guarded by a lock. The snapshot is immutable once built.
+     */
+    struct Network::RequestDefaults {
+        neko::uint64 configVersion = 0;
+        std::string userAgent;
+        std::string protocol;
+        // Only set if the system proxy is a valid proxy address
+        std::optional<std::string> systemProxy;
+        // Empty if workPath/cacert.pem does not exist
+        std::string caPath;
+        HttpVersion httpVersion = HttpVersion::Default;
+    };
+
+    //=================================================
+    // Network Implementation
+    //=================================================
+
+    Network::Network(std::shared_ptr<executor::IAsyncExecutor> executor, std::shared_ptr<log::ILogger> logger)
+        : executor(std::move(executor)), logger(std::move(logger)) {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+        handlePool = std::make_unique<HandlePool>();
+        metricsRegistry = std::make_unique<Metrics>();
+        probeCache = std::make_unique<ProbeCache>();
+        timer = std::make_unique<Timer>();
+        tasks = std::make_unique<TaskGroup>();
+        retryLimiter = std::make_unique<RetryLimiter>();
+        hostTracker = std::make_unique<HostTracker>();
+        flights = std::make_unique<FlightGroup>();
+        bufferPool = std::make_shared<BufferPool>();
+
+        // Output libcurl version information, once per instance rather than per request
+        logLazy<log::Level::Info>([](std::ostream &ss) {
+            curl_version_info_data *ver = curl_version_info(CURLVERSION_NOW);
+            ss << "Network::Network() : "
+               << "libcurl version: " << ver->version
+               << ", SSL version: " << (ver->ssl_version ? ver->ssl_version : "none");
+        });
+    }
+    Network::~Network() {
+        // No retry or hedge starts after this, waiting retries complete with their last result
+        timer->stop();
+        // Requests on the executor use this instance until they complete
+        tasks->wait();
+        // Then stop the I/O threads, pending requests still hold handle leases
+        multiEngine.reset();
+        // Their completions may have started requests on the executor
+        tasks->wait();
+        // Pooled handles must be cleaned up before libcurl is deinitialized
+        handlePool.reset();
+        curl_global_cleanup();
+    }
+
+    Network &Network::setMaxPooledHandles(std::size_t maxHandles) {
+        handlePool->maxIdle.store(maxHandles, std::memory_order_relaxed);
+        handlePool->shrinkTo(maxHandles);
+        return *this;
+    }
+
+    std::size_t Network::getMaxPooledHandles() const {
+        return handlePool->maxIdle.load(std::memory_order_relaxed);
+    }
+
+    Network &Network::setShareScope(ShareScope scope, bool shareCookies) {
+        std::shared_ptr<SharedCache> share;
+        if (scope == ShareScope::Instance)
+            share = std::make_shared<SharedCache>(shareCookies);
+        else if (scope == ShareScope::Process)
+            share = SharedCache::process(shareCookies);
+
+        std::shared_ptr<SharedCache> previous;
+        {
+            std::lock_guard<std::mutex> lock(handlePool->mutex);
+            previous = std::exchange(handlePool->share, std::move(share));
+            shareScope = scope;
+        }
+        this->shareCookies.store(scope != ShareScope::None && shareCookies, std::memory_order_relaxed);
+        // Requests still running keep the previous share alive through their lease
+        return *this;
+    }
+
+    ShareScope Network::getShareScope() const {
+        std::lock_guard<std::mutex> lock(handlePool->mutex);
+        return shareScope;
+    }
+
+    MetricsSnapshot Network::metrics() const {
+        return metricsRegistry->snapshot();
+    }
+
+    void Network::resetMetrics() {
+        metricsRegistry->reset();
+    }
+
+    namespace {
+        // API calls rather than transfers: no file, no range (segments and adaptive ranges) and no bandwidth cap
+        bool isInteractive(const RequestConfig &config) {
+            return (config.method == RequestType::Get || config.method == RequestType::Post || config.method == RequestType::Head) &&
+                   config.range.empty() && !config.bandwidthLimiter;
+        }
+    } // namespace
+
+    void Network::recordRequestStart(const RequestConfig &config) {
+        metricsRegistry->type(config.method).inFlight.fetch_add(1, std::memory_order_relaxed);
+        hostTracker->started(hostOf(config.url));
+    }
+
+    template <typename T>
+    void Network::recordRequestEnd(const RequestConfig &config, const NetworkResult<T> &result) {
+        bool failed = result.hasError || result.statusCode >= 400;
+
+        auto &type = metricsRegistry->type(config.method);
+        type.inFlight.fetch_sub(1, std::memory_order_relaxed);
+        (failed ? type.failed : type.completed).fetch_add(1, std::memory_order_relaxed);
+
+        auto &host = metricsRegistry->host(hostOf(config.url));
+        host.requests.fetch_add(1, std::memory_order_relaxed);
+        if (failed)
+            host.failures.fetch_add(1, std::memory_order_relaxed);
+
+        if (result.timings) {
+            metricsRegistry->bytesSent.fetch_add(result.timings->bytesUploaded, std::memory_order_relaxed);
+            metricsRegistry->bytesReceived.fetch_add(result.timings->bytesDownloaded, std::memory_order_relaxed);
+            host.recordLatency(static_cast<neko::uint64>(result.timings->total.count()));
+            if (isInteractive(config))
+                metricsRegistry->interactive.recordLatency(static_cast<neko::uint64>(result.timings->total.count()));
+        }
+
+        // For health a 4xx is the client's fault, only missing responses and 5xx count against the host;
+        // a cancelled request says nothing about the host
+        bool hostFailed = result.statusCode == 0 || result.statusCode >= 500;
+        bool reached = result.timings.has_value() && !(config.cancellation && config.cancellation->isCancelled());
+        auto latency = result.timings ? result.timings->total : std::chrono::microseconds(0);
+        hostTracker->ended(hostOf(config.url), reached, hostFailed, latency, [&](CircuitState state) {
+            if (state == CircuitState::Open) {
+                logWarn("Network::recordRequestEnd() : Circuit breaker opened for host " + hostOf(config.url) + ", ID: " + config.requestId);
+            } else {
+                logInfo("Network::recordRequestEnd() : Circuit breaker closed for host " + hostOf(config.url) + ", ID: " + config.requestId);
+            }
+        });
+    }
+
+    std::optional<std::string> Network::circuitRejection(const RequestConfig &config) {
+        std::string host = hostOf(config.url);
+        if (hostTracker->admit(host))
+            return std::nullopt;
+        std::string detail = "Network::circuitRejection() : Circuit breaker open for host " + host + ", ID: " + config.requestId;
+        logLazy<log::Level::Info>([&](std::ostream &ss) { ss << detail; });
+        return detail;
+    }
+
+    Network &Network::setHostPolicy(std::optional<HostPolicy> policy) {
+        hostTracker->configure(policy);
+        return *this;
+    }
+
+    std::optional<HostPolicy> Network::getHostPolicy() const {
+        return hostTracker->getPolicy();
+    }
+
+    HostHealth Network::hostHealth(const std::string &host) const {
+        return hostTracker->health(hostOf(host));
+    }
+
+    std::string Network::selectHost(const std::vector<std::string> &hosts) {
+        if (hosts.size() <= 1)
+            return hosts.empty() ? std::string() : hosts.front();
+
+        // Hosts with a closed circuit; open ones only get their trial request when nothing else is left
+        std::vector<std::pair<std::size_t, HostHealth>> usable;
+        usable.reserve(hosts.size());
+        for (std::size_t i = 0; i < hosts.size(); ++i) {
+            auto health = hostTracker->health(hostOf(hosts[i]));
+            if (health.circuit == CircuitState::Closed)
+                usable.emplace_back(i, health);
+        }
+        if (usable.empty())
+            return hosts.front(); // All circuits open, the breaker decides whether it may be tried
+        if (usable.size() == 1)
+            return hosts[usable.front().first];
+
+        // Power of two choices avoids herding on the single best host
+        thread_local std::minstd_rand random(std::random_device{}());
+        std::uniform_int_distribution<std::size_t> pick(0, usable.size() - 1);
+        std::size_t a = pick(random);
+        std::size_t b = pick(random);
+        while (b == a) {
+            b = pick(random);
+        }
+        auto cost = [](const HostHealth &health) {
+            if (health.samples == 0)
+                return 0.0;
+            // A failing host often fails fast, so each failure weighs like a second of latency
+            double latency = static_cast<double>(health.latency.count()) + health.errorRate * 1e6;
+            return latency * static_cast<double>(health.inFlight + 1);
+        };
+        return hosts[(cost(usable[a].second) <= cost(usable[b].second) ? usable[a] : usable[b]).first];
+    }
+
+    std::string Network::selectHost() {
+        return selectHost(config::globalConfig.getAvailableHostList());
+    }
+
+    std::string Network::buildUrl(const std::string &path, const std::string &protocol) {
+        return network::buildUrl(path, selectHost(), protocol);
+    }
+
+    Network &Network::setDiagnosticsMode(DiagnosticsMode mode, std::size_t onErrorBudget) {
+        diagnosticsMode.store(mode, std::memory_order_relaxed);
+        diagnosticsBudget.store(onErrorBudget, std::memory_order_relaxed);
+        return *this;
+    }
+
+    DiagnosticsMode Network::getDiagnosticsMode() const {
+        return diagnosticsMode.load(std::memory_order_relaxed);
+    }
+
+    Network &Network::setAsyncEngine(AsyncEngine engine, std::size_t ioThreads) {
+        // Destroying the old engine fails its unfinished requests, so this is meant to be called before use
+        multiEngine.reset();
+        if (engine == AsyncEngine::Multi) {
+            multiEngine = std::make_unique<MultiEngine>(std::max<std::size_t>(1, ioThreads));
+        }
+        return *this;
+    }
+
+    AsyncEngine Network::getAsyncEngine() const {
+        return multiEngine ? AsyncEngine::Multi : AsyncEngine::Executor;
+    }
+
+    void Network::invalidateCachedDefaults() {
+        std::lock_guard<std::mutex> lock(defaultsMutex);
+        defaults.reset();
+    }
+
+    std::shared_ptr<const Network::RequestDefaults> Network::getRequestDefaults() {
+        // Read the version before the values, a concurrent change then just causes one more rebuild
+        neko::uint64 version = config::globalConfig.getVersion();
+
+        std::lock_guard<std::mutex> lock(defaultsMutex);
+        if (defaults && defaults->configVersion == version)
+            return defaults;
+
+        auto snapshot = std::make_shared<RequestDefaults>();
+        snapshot->configVersion = version;
+        snapshot->userAgent = config::globalConfig.getUserAgent();
+        snapshot->protocol = config::globalConfig.getProtocol();
+        snapshot->httpVersion = config::globalConfig.getHttpVersion();
+
+        auto sysProxy = helper::getSysProxy();
+        if (sysProxy && util::check::isProxyAddress(*sysProxy))
+            snapshot->systemProxy = std::move(sysProxy);
+
+        std::string caPath = system::workPath() + "/cacert.pem";
+        if (std::filesystem::exists(caPath)) {
+            snapshot->caPath = std::move(caPath);
+            logLazy<log::Level::Debug>([&](std::ostream &ss) {
+                ss << "Network::getRequestDefaults() : Using custom CA bundle at: " << snapshot->caPath;
+            });
+        }
+
+        defaults = std::move(snapshot);
+        return defaults;
+    }
+
+    bool Network::isLogEnabled(log::Level level) const {
+        return level >= log::compiledLevel && level != log::Level::Off && logger && logger->enabled(level);
+    }
+
+    void Network::logError(const std::string &msg) {
+        if (isLogEnabled(log::Level::Error))
+            logger->error("Network Error: " + msg);
+    }
+    void Network::logInfo(const std::string &msg) {
+        if (isLogEnabled(log::Level::Info))
+            logger->info("Network: " + msg);
+    }
+    void Network::logWarn(const std::string &msg) {
+        if (isLogEnabled(log::Level::Warn))
+            logger->warn("Network: " + msg);
+    }
+    void Network::logDebug(const std::string &msg) {
+        if (isLogEnabled(log::Level::Debug))
+            logger->debug("Network [Debug]: " + msg);
+    }
+
+    template <log::Level level, typename Format>
+    void Network::logLazy(Format &&format) {
+        if constexpr (level < log::compiledLevel || level == log::Level::Off) {
+            return;
+        } else {
+            if (!isLogEnabled(level))
+                return;
+
+            std::ostringstream ss;
+            if constexpr (level == log::Level::Error) {
+                ss << "Network Error: ";
+                format(ss);
+                logger->error(ss.str());
+            } else if constexpr (level == log::Level::Warn) {
+                ss << "Network: ";
+                format(ss);
+                logger->warn(ss.str());
+            } else if constexpr (level == log::Level::Info) {
+                ss << "Network: ";
+                format(ss);
+                logger->info(ss.str());
+            } else {
+                ss << "Network [Debug]: ";
+                format(ss);
+                logger->debug(ss.str());
+            }
+        }
+    }
+
+    void Network::logRequestInfo(const RequestConfig &config) {
+        if (!isLogEnabled(log::Level::Info) && !isLogEnabled(log::Level::Debug))
+            return;
+
+        neko::cstr methodStr;
         switch (config.method) {
             case RequestType::Get:
-                result = handleGetRequest<T>(curl, config);
+                methodStr = "GET";
                 break;
             case RequestType::Head:
-                result = handleHeadRequest<T>(curl, config);
+                methodStr = "HEAD";
                 break;
             case RequestType::Post:
-                result = handlePostRequest<T>(curl, config);
+                methodStr = "POST";
                 break;
             case RequestType::DownloadFile:
-                result = handleDownloadRequest<T>(curl, config);
+                methodStr = "DOWNLOAD";
                 break;
             case RequestType::UploadFile:
-                result.setError("Upload not implemented");
+                methodStr = "UPLOAD";
                 break;
             default:
-                result.setError("Unknown request type");
+                methodStr = "UNKNOWN";
                 break;
         }
 
-        curl_easy_cleanup(curl);
-        return result;
-    }
+        logLazy<log::Level::Info>([&](std::ostream &ss) {
+            auto requestDefaults = getRequestDefaults();
+            ss << "Network::logRequestInfo() : "
+               << "Request: URL: " << config.url
+               << ", Method: " << methodStr
+               << ", FileName: " << config.fileName
+               << ", Range: " << config.range
+               << ", Resumable: " << util::logic::boolTo(config.resumable)
+               << ", UserAgent: " << util::logic::boolTo(config.userAgent.empty(), requestDefaults->userAgent, config.userAgent)
+               << ", Global Protocol: " << requestDefaults->protocol
+               << ", Proxy: " << util::logic::boolTo<std::string>(config.proxy.empty(), "<none>", config.proxy)
+               << ", SysProxy: " << requestDefaults->systemProxy.value_or("<none>")
+               << ", ID: " << config.requestId;
+        });
+
+        // Header and body can be large, only format them when debug output is wanted
+        logLazy<log::Level::Debug>([&](std::ostream &ss) {
+            ss << "Network::logRequestInfo() : "
+               << "Header: " << util::logic::boolTo<std::string>(config.header.empty(), "<none>", config.header)
+               << ", Headers: " << config.headers.size()
+               << ", PostData: " << util::logic::boolTo<std::string>(config.postData.empty(), "<none>", config.postData)
+               << ", Body: " << (config.bodyReader ? "reader" : config.body ? std::to_string(config.body->size()) + " bytes shared" : "<none>")
+               << ", ProgressCallback: " << (config.progressCallback ? "set" : "not set");
+        });
+    }
+
+    namespace {
+        struct TransferControlContext {
+            const CancellationToken *cancellation = nullptr;
+            BandwidthLimiter *limiter = nullptr;
+            // Received bytes already taken from the limiter
+            curl_off_t counted = 0;
+        };
+
+        // libcurl calls this about once per second and whenever data moves, a non-zero return aborts the transfer.
+        // Over the bandwidth limit it waits here, which keeps libcurl from reading the socket
+        int transferControlCallback(void *clientp, curl_off_t, curl_off_t downloaded, curl_off_t, curl_off_t) {
+            auto *ctx = static_cast<TransferControlContext *>(clientp);
+            auto cancelled = [ctx]() { return ctx->cancellation && ctx->cancellation->isCancelled(); };
+            if (cancelled())
+                return 1;
+            if (!ctx->limiter)
+                return 0;
+
+            ctx->counted = std::min(ctx->counted, downloaded); // A redirect starts counting again
+            if (downloaded == ctx->counted)
+                return 0;
+            auto wait = ctx->limiter->consume(static_cast<neko::uint64>(downloaded - ctx->counted));
+            ctx->counted = downloaded;
+
+            // Wait in slices so that cancelling still aborts promptly
+            constexpr auto slice = std::chrono::milliseconds(50);
+            auto until = std::chrono::steady_clock::now() + wait;
+            for (auto now = std::chrono::steady_clock::now(); now < until; now = std::chrono::steady_clock::now()) {
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(until - now, slice));
+                if (cancelled())
+                    return 1;
+            }
+            return 0;
+        }
+
+        // Why a request must not be sent (again), if it was cancelled or its deadline passed
+        std::optional<std::string> stopReason(const RequestConfig &config) {
+            if (config.cancellation && config.cancellation->isCancelled())
+                return "Request cancelled";
+            if (config.deadline && std::chrono::steady_clock::now() >= *config.deadline)
+                return "Deadline exceeded";
+            return std::nullopt;
+        }
+    } // namespace
+
+    std::optional<std::string> Network::initCurl(CURL *curl, const RequestConfig &config) {
+        std::stringstream errorMsg;
+        if (!curl) {
+            errorMsg << "Failed to initialize curl. ID: " << config.requestId;
+            logError("Network::initCurl() : " + errorMsg.str());
+            return errorMsg.str();
+        }
+
+        auto requestDefaults = getRequestDefaults();
+
+        // Set CA certificate
+        // Use custom cacert.pem if available
+        if (!requestDefaults->caPath.empty())
+            curl_easy_setopt(curl, CURLOPT_CAINFO, requestDefaults->caPath.c_str());
+
+        curl_easy_setopt(curl, CURLOPT_SSL_OPTIONS, CURLSSLOPT_NO_REVOKE);
+        // Handles are used from executor and I/O threads, never let libcurl install signal handlers
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+        // proxy = "true" means use system proxy
+        if (config.proxy == "true" && requestDefaults->systemProxy) {
+            curl_easy_setopt(curl, CURLOPT_PROXY, requestDefaults->systemProxy->c_str());
+        } else if (!config.proxy.empty() && util::check::isProxyAddress(config.proxy)) {
+            curl_easy_setopt(curl, CURLOPT_PROXY, config.proxy.c_str());
+        } else {
+            curl_easy_setopt(curl, CURLOPT_PROXY, "");
+            if (!config.proxy.empty() && config.proxy != "false") {
+                errorMsg << "Invalid proxy address: " << config.proxy << ", ID: " << config.requestId;
+                logWarn("Network::initCurl() : " + errorMsg.str());
+                errorMsg.str("");
+            }
+        }
+
+        // Handle resumable downloads, positional writes always start at their offset
+        if (config.resumable && !config.fileName.empty() && !config.writeOffset.has_value()) {
+            std::fstream infile(config.fileName, std::ios::in | std::ios::binary);
+            if (!infile.is_open()) {
+                errorMsg << "Failed to open file for resuming: " << config.fileName << ", ID: " << config.requestId;
+                logError("Network::initCurl() : " + errorMsg.str());
+                return errorMsg.str();
+            }
+
+            infile.seekg(0, std::ios::end);
+            neko::uint64 fileSize = infile.tellg();
+            infile.close();
+
+            // If range download, resume from the specified range (file_size + range_start)
+            if (!config.range.empty()) {
+                neko::uint64 resumeOffset = fileSize + std::stoull(config.range.substr(0, config.range.find('-')));
+                curl_easy_setopt(curl, CURLOPT_RESUME_FROM, resumeOffset);
+            } else {
+                curl_easy_setopt(curl, CURLOPT_RESUME_FROM, fileSize);
+            }
+        }
+
+        // Set range, the request headers are owned by the request context (setupRequest)
+        if (!config.range.empty())
+            curl_easy_setopt(curl, CURLOPT_RANGE, config.range.c_str());
+
+        // Set user agent and URL
+        const std::string &userAgent = config.userAgent.empty() ? requestDefaults->userAgent : config.userAgent;
+        curl_easy_setopt(curl, CURLOPT_USERAGENT, userAgent.c_str());
+        curl_easy_setopt(curl, CURLOPT_URL, config.url.c_str());
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 5L);
+
+        // A cookie-sharing SharedCache only collects cookies if the cookie engine is enabled
+        if (shareCookies.load(std::memory_order_relaxed))
+            curl_easy_setopt(curl, CURLOPT_COOKIEFILE, "");
+
+        // Protocol version; for multiplexing versions, prefer waiting for a connection that can take another stream over opening a new one
+        HttpVersion httpVersion = config.httpVersion.value_or(requestDefaults->httpVersion);
+        if (httpVersion != HttpVersion::Default) {
+            if (curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, curlHttpVersion(httpVersion)) != CURLE_OK) {
+                logLazy<log::Level::Warn>([&](std::ostream &ss) {
+                    ss << "Network::initCurl() : "
+                       << "Requested HTTP version is not supported by libcurl, using the default. ID: " << config.requestId;
+                });
+            }
+        }
+        // Plain http:// only multiplexes with prior knowledge, elsewhere waiting would serialize requests until the first response
+        bool isHttps = config.url.size() >= 8 && std::equal(config.url.begin(), config.url.begin() + 8, "https://", [](char a, char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == b;
+        });
+        if (httpVersion == HttpVersion::Http2PriorKnowledge || (httpVersion != HttpVersion::Http1_1 && isHttps))
+            curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+
+        // Timeouts, the deadline caps whatever timeout is set
+        auto timeout = config.timeout;
+        if (config.deadline) {
+            auto left = std::chrono::ceil<std::chrono::milliseconds>(*config.deadline - std::chrono::steady_clock::now());
+            left = std::max(left, std::chrono::milliseconds(1));
+            timeout = timeout.count() > 0 ? std::min(timeout, left) : left;
+        }
+        if (timeout.count() > 0)
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout.count()));
+        if (config.connectTimeout.count() > 0)
+            curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(config.connectTimeout.count()));
+        if (config.lowSpeedLimit > 0 && config.lowSpeedTime.count() > 0) {
+            curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, static_cast<long>(config.lowSpeedLimit));
+            curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, static_cast<long>(config.lowSpeedTime.count()));
+        }
+
+        return std::nullopt; // No error
+    }
+
+    int Network::getHttpStatusCode(CURL *curl) {
+        long statusCode = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &statusCode);
+        return static_cast<int>(statusCode);
+    }
+
+    //=================================================
+    // Diagnostics capture
+    //=================================================
+
+    namespace {
+        /**
+         * Collects libcurl verbose output for one request.
+         * With a byte budget it is a ring buffer that keeps only the most recent output,
+         * so a long transfer cannot grow it; the storage is allocated on the first message.
+         */
+        class DiagnosticsBuffer {
+        public:
+            // budget 0 means unbounded
+            void enable(std::size_t budgetBytes, bool textOnly) {
+                enabled = true;
+                budget = budgetBytes;
+                onlyText = textOnly;
+            }
+
+            bool isEnabled() const { return enabled; }
+            bool captureOnlyText() const { return onlyText; }
+
+            void append(const char *data, std::size_t size) {
+                if (budget == 0) {
+                    text.append(data, size);
+                    return;
+                }
+                if (text.capacity() < budget)
+                    text.reserve(budget);
+
+                while (size > 0) {
+                    std::size_t n;
+                    if (text.size() < budget) {
+                        n = std::min(size, budget - text.size());
+                        text.append(data, n);
+                    } else {
+                        // Full: overwrite the oldest bytes, head is where the oldest byte starts
+                        wrapped = true;
+                        n = std::min(size, budget - head);
+                        std::memcpy(text.data() + head, data, n);
+                        head = (head + n) % budget;
+                    }
+                    data += n;
+                    size -= n;
+                }
+            }
+
+            // Writes each kept line prefixed with "\n[Debug] ", oldest first
+            void writeTo(std::ostream &os) const {
+                std::string linear = wrapped ? text.substr(head) + text.substr(0, head) : text;
+                std::string_view view(linear);
+                if (wrapped) {
+                    // The oldest line was cut by the ring, drop its remainder
+                    auto firstNewline = view.find('\n');
+                    view.remove_prefix(firstNewline == std::string_view::npos ? view.size() : firstNewline + 1);
+                    os << "\n[Debug] ... (earlier output truncated)";
+                }
+                while (!view.empty()) {
+                    auto end = view.find('\n');
+                    auto line = view.substr(0, end);
+                    if (!line.empty())
+                        os << "\n[Debug] " << line;
+                    if (end == std::string_view::npos)
+                        break;
+                    view.remove_prefix(end + 1);
+                }
+            }
+
+        private:
+            std::string text;
+            std::size_t budget = 0;
+            std::size_t head = 0;
+            bool wrapped = false;
+            bool enabled = false;
+            bool onlyText = true;
+        };
+
+        RequestTimings collectTimings(CURL *curl) {
+            RequestTimings timings;
+            auto getTime = [curl](CURLINFO info) {
+                curl_off_t value = 0;
+                curl_easy_getinfo(curl, info, &value);
+                return std::chrono::microseconds(value);
+            };
+            auto getSize = [curl](CURLINFO info) {
+                curl_off_t value = 0;
+                curl_easy_getinfo(curl, info, &value);
+                return static_cast<neko::uint64>(value);
+            };
+
+            timings.nameLookup = getTime(CURLINFO_NAMELOOKUP_TIME_T);
+            timings.connect = getTime(CURLINFO_CONNECT_TIME_T);
+            timings.appConnect = getTime(CURLINFO_APPCONNECT_TIME_T);
+            timings.preTransfer = getTime(CURLINFO_PRETRANSFER_TIME_T);
+            timings.startTransfer = getTime(CURLINFO_STARTTRANSFER_TIME_T);
+            timings.total = getTime(CURLINFO_TOTAL_TIME_T);
+            timings.redirect = getTime(CURLINFO_REDIRECT_TIME_T);
+
+            timings.bytesUploaded = getSize(CURLINFO_SIZE_UPLOAD_T);
+            timings.bytesDownloaded = getSize(CURLINFO_SIZE_DOWNLOAD_T);
+            timings.uploadSpeed = getSize(CURLINFO_SPEED_UPLOAD_T);
+            timings.downloadSpeed = getSize(CURLINFO_SPEED_DOWNLOAD_T);
+
+            long redirects = 0;
+            curl_easy_getinfo(curl, CURLINFO_REDIRECT_COUNT, &redirects);
+            timings.redirectCount = static_cast<int>(redirects);
+
+            char *ip = nullptr;
+            if (curl_easy_getinfo(curl, CURLINFO_PRIMARY_IP, &ip) == CURLE_OK && ip)
+                timings.primaryIp = ip;
+
+            // NUM_CONNECTS counts new connections, none means an existing one was reused
+            long connects = 0;
+            curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+            timings.connectionReused = connects == 0 && !timings.primaryIp.empty();
+
+            long httpVersion = CURL_HTTP_VERSION_NONE;
+            curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &httpVersion);
+            timings.httpVersion = httpVersionName(httpVersion);
+            return timings;
+        }
+
+        // This callback function is used to handle libcurl debug messages, called only for requests set up by Network::setupRequest.
+        int debugCallback(CURL *, curl_infotype type, char *data, std::size_t size, void *userptr) {
+            auto *buffer = static_cast<DiagnosticsBuffer *>(userptr);
+            if (!buffer)
+                return 0;
+            if (type == CURLINFO_TEXT || (!buffer->captureOnlyText() && (type == CURLINFO_SSL_DATA_IN || type == CURLINFO_SSL_DATA_OUT))) {
+                buffer->append(data, size);
+            }
+            return 0;
+        }
+    } // namespace
+
+    //=================================================
+    // Positional file writes
+    //=================================================
+
+    namespace {
+        /**
+         * Minimal file handle for writing at explicit offsets (pwrite / overlapped WriteFile).
+         * Several handles may write disjoint regions of the same file concurrently.
+         */
+        class PositionalFile {
+        public:
+            PositionalFile() = default;
+            ~PositionalFile() { close(); }
+
+            PositionalFile(const PositionalFile &) = delete;
+            PositionalFile &operator=(const PositionalFile &) = delete;
+
+            bool open(const std::string &path, bool truncate) {
+                close();
+#if defined(_WIN32)
+                handle = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                     truncate ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+                return handle != INVALID_HANDLE_VALUE;
+#else
+                fd = ::open(path.c_str(), O_WRONLY | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+                return fd >= 0;
+#endif
+            }
+
+            bool isOpen() const {
+#if defined(_WIN32)
+                return handle != INVALID_HANDLE_VALUE;
+#else
+                return fd >= 0;
+#endif
+            }
+
+            // Reserve the full file length up front so segments can be written in any order
+            bool preallocate(neko::uint64 size) {
+                if (!isOpen())
+                    return false;
+#if defined(_WIN32)
+                LARGE_INTEGER length;
+                length.QuadPart = static_cast<LONGLONG>(size);
+                return SetFilePointerEx(handle, length, nullptr, FILE_BEGIN) && SetEndOfFile(handle);
+#else
+#if defined(__linux__)
+                if (posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0)
+                    return true;
+#endif
+                return ftruncate(fd, static_cast<off_t>(size)) == 0;
+#endif
+            }
+
+            bool writeAt(neko::uint64 offset, const char *data, neko::uint64 size) {
+                while (size > 0) {
+#if defined(_WIN32)
+                    OVERLAPPED overlapped{};
+                    overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFull);
+                    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+                    DWORD chunk = static_cast<DWORD>(std::min<neko::uint64>(size, 1u << 30));
+                    DWORD written = 0;
+                    if (!WriteFile(handle, data, chunk, &written, &overlapped) || written == 0)
+                        return false;
+#else
+                    ssize_t written = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+                    if (written < 0 && errno == EINTR)
+                        continue;
+                    if (written <= 0)
+                        return false;
+#endif
+                    offset += static_cast<neko::uint64>(written);
+                    data += written;
+                    size -= static_cast<neko::uint64>(written);
+                }
+                return true;
+            }
+
+            void close() {
+#if defined(_WIN32)
+                if (handle != INVALID_HANDLE_VALUE) {
+                    CloseHandle(handle);
+                    handle = INVALID_HANDLE_VALUE;
+                }
+#else
+                if (fd >= 0) {
+                    ::close(fd);
+                    fd = -1;
+                }
+#endif
+            }
+
+        private:
+#if defined(_WIN32)
+            HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+            int fd = -1;
+#endif
+        };
+
+        struct PositionalWriteContext {
+            PositionalFile *file = nullptr;
+            neko::uint64 offset = 0;
+            // Maximum number of bytes this request may write, 0 means unlimited
+            neko::uint64 limit = 0;
+            neko::uint64 totalBytes = 0;
+            std::function<void(neko::uint64)> *progressCallback = nullptr;
+        };
+
+        neko::uint64 positionalWriteCallback(char *ptr, neko::uint64 size, neko::uint64 nmemb, void *userdata) {
+            auto *ctx = static_cast<PositionalWriteContext *>(userdata);
+            neko::uint64 written = size * nmemb;
+            if (ctx->limit != 0 && ctx->totalBytes + written > ctx->limit)
+                return 0; // More data than the requested range, abort instead of overwriting the next segment
+            if (!ctx->file->writeAt(ctx->offset + ctx->totalBytes, ptr, written))
+                return 0;
+            ctx->totalBytes += written;
+            if (ctx->progressCallback && *ctx->progressCallback) {
+                (*ctx->progressCallback)(ctx->totalBytes);
+            }
+            return written;
+        }
+
+        // Content-Length of the response being received, read before its first body chunk
+        std::optional<neko::uint64> expectedLength(const HeaderMap *headers) {
+            if (!headers)
+                return std::nullopt;
+            auto value = headers->find("Content-Length");
+            neko::uint64 length = 0;
+            if (!value || std::from_chars(value->data(), value->data() + value->size(), length).ec != std::errc() || length == 0)
+                return std::nullopt;
+            return length;
+        }
+
+        template <typename T>
+        struct SinkWriteContext {
+            T *sink = nullptr;
+            const HeaderMap *headers = nullptr;
+            std::function<void(neko::uint64)> *progressCallback = nullptr;
+            neko::uint64 totalBytes = 0;
+        };
+
+        // Writes the body into the content through ResponseSink<T>, reserving room for the Content-Length first
+        template <typename T>
+        neko::uint64 sinkWriteCallback(char *ptr, neko::uint64 size, neko::uint64 nmemb, void *userdata) {
+            auto *ctx = static_cast<SinkWriteContext<T> *>(userdata);
+            neko::uint64 written = size * nmemb;
+            // Exceptions must not unwind through libcurl, a failed allocation aborts the transfer
+            try {
+                if (ctx->totalBytes == 0) {
+                    if (auto length = expectedLength(ctx->headers))
+                        ResponseSink<T>::reserve(*ctx->sink, std::min(*length, maxSinkReserve));
+                }
+                if (!ResponseSink<T>::append(*ctx->sink, ptr, written))
+                    return 0;
+            } catch (...) {
+                return 0;
+            }
+            ctx->totalBytes += written;
+            if (ctx->progressCallback && *ctx->progressCallback) {
+                (*ctx->progressCallback)(ctx->totalBytes);
+            }
+            return written;
+        }
+
+        struct ChunkWriteContext {
+            const std::function<bool(std::string_view)> *chunkCallback = nullptr;
+            const std::function<void(neko::uint64)> *contentLengthCallback = nullptr;
+            const HeaderMap *headers = nullptr;
+            std::function<void(neko::uint64)> *progressCallback = nullptr;
+            neko::uint64 totalBytes = 0;
+            bool aborted = false;
+        };
+
+        // Hands every received chunk to RequestConfig::chunkCallback instead of buffering it
+        neko::uint64 chunkWriteCallback(char *ptr, neko::uint64 size, neko::uint64 nmemb, void *userdata) {
+            auto *ctx = static_cast<ChunkWriteContext *>(userdata);
+            neko::uint64 written = size * nmemb;
+            // Exceptions must not unwind through libcurl, a throwing callback aborts the transfer
+            try {
+                if (ctx->totalBytes == 0 && ctx->contentLengthCallback && *ctx->contentLengthCallback) {
+                    if (auto length = expectedLength(ctx->headers))
+                        (*ctx->contentLengthCallback)(*length);
+                }
+                if (!(*ctx->chunkCallback)(std::string_view(ptr, written))) {
+                    ctx->aborted = true;
+                    return 0;
+                }
+            } catch (...) {
+                ctx->aborted = true;
+                return 0;
+            }
+            ctx->totalBytes += written;
+            if (ctx->progressCallback && *ctx->progressCallback) {
+                (*ctx->progressCallback)(ctx->totalBytes);
+            }
+            return written;
+        }
+
+        struct ResponseHeaderContext {
+            HeaderMap *headers = nullptr;
+            // Raw header lines, only collected for Head
+            std::string *raw = nullptr;
+        };
+
+        // Parses each response header line into a HeaderMap; a status line starts a new response,
+        // so after redirects and interim (1xx) responses only the final one is left
+        neko::uint64 responseHeaderCallback(char *ptr, neko::uint64 size, neko::uint64 nmemb, void *userdata) {
+            auto *ctx = static_cast<ResponseHeaderContext *>(userdata);
+            neko::uint64 dataSize = size * nmemb;
+            std::string_view line(ptr, dataSize);
+            if (line.starts_with("HTTP/"))
+                ctx->headers->clear();
+            else
+                ctx->headers->addLine(line);
+            if (ctx->raw)
+                ctx->raw->append(ptr, dataSize);
+            return dataSize;
+        }
+
+        // Request header list from the newline-separated header string followed by the header map;
+        // a lone CR also ends a line, so no field reaches libcurl with a line break inside it
+        curl_slist *buildRequestHeaders(const RequestConfig &config) {
+            curl_slist *list = nullptr;
+            std::string_view block(config.header);
+            while (!block.empty()) {
+                auto end = block.find_first_of("\r\n");
+                auto line = block.substr(0, end);
+                block.remove_prefix(end == std::string_view::npos ? block.size() : end + 1);
+
+                auto first = line.find_first_not_of(" \t\r");
+                if (first == std::string_view::npos)
+                    continue;
+                auto last = line.find_last_not_of(" \t\r");
+                list = curl_slist_append(list, std::string(line.substr(first, last - first + 1)).c_str());
+            }
+            config.headers.forEachLine([&list](const std::string &line) {
+                list = curl_slist_append(list, line.c_str());
+            });
+            return list;
+        }
+
+        // Request body source for bodyReader and UploadFile
+        struct BodyReadContext {
+            const std::function<std::size_t(neko::uint64, char *, std::size_t)> *reader = nullptr;
+            std::ifstream *file = nullptr;
+            neko::uint64 offset = 0;
+            std::function<void(neko::uint64)> *progressCallback = nullptr;
+        };
+
+        std::size_t bodyReadCallback(char *buffer, std::size_t size, std::size_t nitems, void *userdata) {
+            auto *ctx = static_cast<BodyReadContext *>(userdata);
+            std::size_t capacity = size * nitems;
+            std::size_t read = 0;
+            // Exceptions must not unwind through libcurl, a throwing reader or progress callback aborts the transfer
+            try {
+                if (ctx->reader) {
+                    read = (*ctx->reader)(ctx->offset, buffer, capacity);
+                    if (read == RequestConfig::bodyReadAbort || read > capacity)
+                        return CURL_READFUNC_ABORT;
+                } else {
+                    ctx->file->read(buffer, static_cast<std::streamsize>(capacity));
+                    if (ctx->file->bad())
+                        return CURL_READFUNC_ABORT;
+                    read = static_cast<std::size_t>(ctx->file->gcount());
+                }
+                ctx->offset += read;
+                if (read > 0 && ctx->progressCallback && *ctx->progressCallback) {
+                    (*ctx->progressCallback)(ctx->offset);
+                }
+            } catch (...) {
+                return CURL_READFUNC_ABORT;
+            }
+            return read;
+        }
+
+        // libcurl rewinds the body when it has to send it again, e.g. after a redirect
+        int bodySeekCallback(void *userdata, curl_off_t offset, int origin) {
+            auto *ctx = static_cast<BodyReadContext *>(userdata);
+            if (origin != SEEK_SET || offset < 0)
+                return CURL_SEEKFUNC_CANTSEEK;
+            if (ctx->file) {
+                ctx->file->clear();
+                ctx->file->seekg(static_cast<std::streamoff>(offset));
+                if (!*ctx->file)
+                    return CURL_SEEKFUNC_FAIL;
+            }
+            ctx->offset = static_cast<neko::uint64>(offset);
+            return CURL_SEEKFUNC_OK;
+        }
+
+        // Length of a "start-end" range, or 0 if it is open-ended or malformed
+        neko::uint64 rangeLength(const std::string &range) {
+            auto dash = range.find('-');
+            if (dash == std::string::npos || dash + 1 >= range.size())
+                return 0;
+            try {
+                neko::uint64 start = std::stoull(range.substr(0, dash));
+                neko::uint64 end = std::stoull(range.substr(dash + 1));
+                return end >= start ? end - start + 1 : 0;
+            } catch (const std::exception &) {
+                return 0;
+            }
+        }
+    } // namespace
+
+    //=================================================
+    // Request body compression
+    //=================================================
+
+    namespace {
+        /**
+         * gzip a request body in one pass.
+         * @return The compressed body, or std::nullopt if zlib is not available, compression failed,
+         *         the result is not smaller than the input or the input does not fit zlib's 32-bit sizes.
+         */
+        std::optional<std::string> gzipCompress(std::string_view data) {
+#if defined(NEKO_NETWORK_USE_ZLIB)
+            // avail_in is 32 bits, a larger body would be cut silently
+            if (data.size() > std::numeric_limits<uInt>::max())
+                return std::nullopt;
+
+            z_stream stream{};
+            // windowBits 15 + 16 writes a gzip header and trailer instead of raw zlib
+            if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                return std::nullopt;
+
+            // Only a smaller result is used, so deflate never needs more room than the input; if it runs out it does not finish
+            std::string compressed(data.size(), '\0');
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+            stream.avail_in = static_cast<uInt>(data.size());
+            stream.next_out = reinterpret_cast<Bytef *>(compressed.data());
+            stream.avail_out = static_cast<uInt>(compressed.size());
+
+            int status = deflate(&stream, Z_FINISH);
+            compressed.resize(stream.total_out);
+            deflateEnd(&stream);
+
+            if (status != Z_STREAM_END || compressed.size() >= data.size())
+                return std::nullopt;
+            return compressed;
+#else
+            (void)data;
+            return std::nullopt;
+#endif
+        }
+    } // namespace
+
+    //=================================================
+    // Request pipeline
+    //=================================================
+
+    /**
+     * Per-request state that has to outlive curl_easy_perform or the multi loop.
+     * The buffers registered with libcurl (WRITEDATA, HEADERDATA, DEBUGDATA) point into this object.
+     */
+    template <typename T>
+    struct Network::RequestContext {
+        const RequestConfig &config;
+        NetworkResult<T> result;
+
+        // Response body for Get and Post, raw response headers for Head
+        T content{};
+        std::string headerContent;
+        HeaderMap responseHeaders;
+        ResponseHeaderContext responseHeaderContext;
+        SinkWriteContext<T> writeContext;
+
+        // Streaming sink for Get and Post with chunkCallback
+        ChunkWriteContext chunkWriteContext;
+
+        // Output file for DownloadFile
+        std::fstream file;
+        SinkWriteContext<std::fstream> fileWriteContext;
+
+        // Output file for DownloadFile with writeOffset
+        PositionalFile positionalFile;
+        PositionalWriteContext positionalWriteContext;
+
+        // Cancellation and bandwidth limit, checked on libcurl's progress ticks
+        TransferControlContext transferControl;
+
+        // libcurl verbose output, reported when the request fails
+        DiagnosticsBuffer diagnostics;
+
+        // Request header list, also carries Content-Encoding for a compressed body
+        std::unique_ptr<curl_slist, decltype(&curl_slist_free_all)> requestHeaders{nullptr, &curl_slist_free_all};
+
+        // Request body: a compressed copy of postData, or a streamed source
+        std::string compressedBody;
+        std::ifstream uploadFile;
+        BodyReadContext bodyReadContext;
+
+        explicit RequestContext(const RequestConfig &config) : config(config) {}
+    };
+
+    template <typename T>
+    bool Network::setupRequest(CURL *curl, RequestContext<T> &context) {
+        const RequestConfig &config = context.config;
+
+        if (auto reason = stopReason(config)) {
+            std::string detail = *reason + " before the request started, ID: " + config.requestId;
+            logLazy<log::Level::Info>([&](std::ostream &ss) { ss << "Network::setupRequest() : " << detail; });
+            context.result.setError(*reason, detail);
+            return false;
+        }
+
+        auto initError = initCurl(curl, config);
+        if (initError.has_value()) {
+            context.result.setError("Failed to initialize libcurl", initError.value());
+            return false;
+        }
+
+        // The token and the limiter outlive the transfer, the config holds references to them
+        if (config.cancellation || config.bandwidthLimiter) {
+            context.transferControl.cancellation = config.cancellation.get();
+            context.transferControl.limiter = config.bandwidthLimiter.get();
+            curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, &transferControlCallback);
+            curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &context.transferControl);
+            curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        }
+
+        context.requestHeaders.reset(buildRequestHeaders(config));
+        if (context.requestHeaders)
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, context.requestHeaders.get());
+
+        context.responseHeaderContext.headers = &context.responseHeaders;
+        if (config.method == RequestType::Head)
+            context.responseHeaderContext.raw = &context.headerContent;
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &responseHeaderCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &context.responseHeaderContext);
+
+        // Get and Post bodies either stream to chunkCallback or are collected into content
+        auto setBodySink = [&]() {
+            // Decoding would break byte offsets, so range requests always get the identity encoding
+            if (config.acceptEncoding && config.range.empty())
+                curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, ""); // Every encoding this libcurl supports
+
+            if (config.chunkCallback) {
+                context.chunkWriteContext.chunkCallback = &config.chunkCallback;
+                context.chunkWriteContext.contentLengthCallback = &config.contentLengthCallback;
+                context.chunkWriteContext.headers = &context.responseHeaders;
+                context.chunkWriteContext.progressCallback = const_cast<std::function<void(neko::uint64)> *>(&config.progressCallback);
+                curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &chunkWriteCallback);
+                curl_easy_setopt(curl, CURLOPT_WRITEDATA, &context.chunkWriteContext);
+            } else {
+                if constexpr (std::is_same_v<T, PooledBuffer>) {
+                    if (auto pool = getBufferPool())
+                        context.content = pool->acquire();
+                }
+                context.writeContext.sink = &context.content;
+                context.writeContext.headers = &context.responseHeaders;
+                context.writeContext.progressCallback = const_cast<std::function<void(neko::uint64)> *>(&config.progressCallback);
+                curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &sinkWriteCallback<T>);
+                curl_easy_setopt(curl, CURLOPT_WRITEDATA, &context.writeContext);
+            }
+        };
+
+        // Post and UploadFile bodies from bodyReader or a file, with rewinding for resends
+        auto setBodyReader = [&]() {
+            context.bodyReadContext.reader = config.bodyReader ? &config.bodyReader : nullptr;
+            if (config.method == RequestType::UploadFile)
+                context.bodyReadContext.progressCallback = const_cast<std::function<void(neko::uint64)> *>(&config.progressCallback);
+            curl_easy_setopt(curl, CURLOPT_READFUNCTION, &bodyReadCallback);
+            curl_easy_setopt(curl, CURLOPT_READDATA, &context.bodyReadContext);
+            curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, &bodySeekCallback);
+            curl_easy_setopt(curl, CURLOPT_SEEKDATA, &context.bodyReadContext);
+        };
+
+        switch (config.method) {
+            case RequestType::Get:
+                setBodySink();
+                break;
+            case RequestType::Head:
+                // HEAD requests don't have a response body, the raw headers become the content
+                curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+                break;
+            case RequestType::Post: {
+                curl_easy_setopt(curl, CURLOPT_POST, 1L);
+                if (config.bodyReader) {
+                    setBodyReader();
+                    if (config.bodySize)
+                        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(*config.bodySize));
+                    setBodySink();
+                    break;
+                }
+
+                // The config outlives the transfer, so the body is sent in place instead of being copied by libcurl
+                const std::string &postBody = config.body ? *config.body : config.postData;
+                std::optional<std::string> compressed;
+                if (config.compressPostData)
+                    compressed = gzipCompress(postBody);
+
+                if (compressed) {
+                    // Appending keeps the head of a non-empty list, an empty one gets a new head
+                    context.requestHeaders.reset(curl_slist_append(context.requestHeaders.release(), "Content-Encoding: gzip"));
+                    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, context.requestHeaders.get());
+                    logLazy<log::Level::Debug>([&](std::ostream &ss) {
+                        ss << "Network::setupRequest() : "
+                           << "Compressed request body from " << postBody.size() << " to " << compressed->size()
+                           << " bytes, ID: " << config.requestId;
+                    });
+                    context.compressedBody = std::move(*compressed);
+                }
+                const std::string &sentBody = compressed ? context.compressedBody : postBody;
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(sentBody.size()));
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDS, sentBody.data());
+                setBodySink();
+                break;
+            }
+            case RequestType::DownloadFile: {
+                if (config.writeOffset.has_value()) {
+                    // Write in place into an existing file, e.g. a multiThreadedDownload segment
+                    if (!context.positionalFile.open(config.fileName, false)) {
+                        std::string errorMsg = "Failed to open file for positional writing: " + config.fileName + ", ID: " + config.requestId;
+                        logError("Network::setupRequest() : " + errorMsg);
+                        context.result.setError("File operation error : ", errorMsg);
+                        return false;
+                    }
+                    context.positionalWriteContext.file = &context.positionalFile;
+                    context.positionalWriteContext.offset = *config.writeOffset;
+                    context.positionalWriteContext.limit = rangeLength(config.range);
+                    context.positionalWriteContext.progressCallback = const_cast<std::function<void(neko::uint64)> *>(&config.progressCallback);
+                    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &positionalWriteCallback);
+                    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &context.positionalWriteContext);
+                    break;
+                }
+                context.file.open(config.fileName, std::ios::out | std::ios::binary | (config.resumable ? std::ios::app : std::ios::trunc));
+                if (!context.file.is_open()) {
+                    std::string errorMsg = "Failed to open file for writing: " + config.fileName + ", ID: " + config.requestId;
+                    logError("Network::setupRequest() : " + errorMsg);
+                    context.result.setError("File operation error : ", errorMsg);
+                    return false;
+                }
+                context.fileWriteContext.sink = &context.file;
+                context.fileWriteContext.progressCallback = const_cast<std::function<void(neko::uint64)> *>(&config.progressCallback);
+                curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &sinkWriteCallback<std::fstream>);
+                curl_easy_setopt(curl, CURLOPT_WRITEDATA, &context.fileWriteContext);
+                break;
+            }
+            case RequestType::UploadFile: {
+                // PUT, the file is read in chunks as libcurl sends it
+                curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+                if (config.bodyReader) {
+                    setBodyReader();
+                    if (config.bodySize)
+                        curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(*config.bodySize));
+                } else {
+                    std::error_code ec;
+                    neko::uint64 fileSize = std::filesystem::file_size(config.fileName, ec);
+                    if (!ec)
+                        context.uploadFile.open(config.fileName, std::ios::in | std::ios::binary);
+                    if (ec || !context.uploadFile.is_open()) {
+                        std::string errorMsg = "Failed to open file for uploading: " + config.fileName + ", ID: " + config.requestId;
+                        logError("Network::setupRequest() : " + errorMsg);
+                        context.result.setError("File operation error : ", errorMsg);
+                        return false;
+                    }
+                    context.bodyReadContext.file = &context.uploadFile;
+                    setBodyReader();
+                    curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(fileSize));
+                }
+                setBodySink();
+                // progressCallback reports the upload, not the response
+                context.writeContext.progressCallback = nullptr;
+                context.chunkWriteContext.progressCallback = nullptr;
+                break;
+            }
+            default:
+                context.result.setError("Unknown request type");
+                return false;
+        }
+
+        logLazy<log::Level::Info>([&](std::ostream &ss) {
+            ss << "Network::setupRequest() : "
+               << "Performing request, URL: " << config.url
+               << ", Method: " << static_cast<int>(config.method)
+               << ", ID: " << config.requestId;
+        });
+
+        // Verbose output is only captured when diagnostics are wanted
+        DiagnosticsMode diagnostics = config.diagnostics.value_or(diagnosticsMode.load(std::memory_order_relaxed));
+        if (diagnostics != DiagnosticsMode::Off) {
+            if (diagnostics == DiagnosticsMode::Full) {
+                context.diagnostics.enable(0, false);
+            } else {
+                context.diagnostics.enable(std::max<std::size_t>(1, diagnosticsBudget.load(std::memory_order_relaxed)), true);
+            }
+            curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+            curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION, &debugCallback);
+            curl_easy_setopt(curl, CURLOPT_DEBUGDATA, &context.diagnostics);
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    NetworkResult<T> Network::completeRequest(CURL *curl, int code, RequestContext<T> &context) {
+        const RequestConfig &config = context.config;
+        NetworkResult<T> &result = context.result;
+        CURLcode res = static_cast<CURLcode>(code);
+        std::stringstream ss;
+
+        // Get connection IP
+        char *ip = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_PRIMARY_IP, &ip);
+
+        // Set status code
+        result.statusCode = getHttpStatusCode(curl);
+        result.timings = collectTimings(curl);
+        result.headers = std::move(context.responseHeaders);
+
+        if (res != CURLE_OK && context.chunkWriteContext.aborted) {
+            ss << "Transfer aborted by chunkCallback after " << context.chunkWriteContext.totalBytes
+               << " bytes, ID: " << config.requestId;
+            logLazy<log::Level::Info>([&](std::ostream &os) {
+                os << "Network::completeRequest() : " << ss.str();
+            });
+            result.setError("Transfer aborted by chunkCallback", ss.str());
+            return std::move(result);
+        }
+
+        if (res != CURLE_OK && config.cancellation && config.cancellation->isCancelled()) {
+            ss << "Transfer cancelled after " << (result.timings ? result.timings->bytesDownloaded : 0)
+               << " bytes, ID: " << config.requestId;
+            logLazy<log::Level::Info>([&](std::ostream &os) {
+                os << "Network::completeRequest() : " << ss.str();
+            });
+            result.setError("Request cancelled", ss.str());
+            return std::move(result);
+        }
+
+        if (res == CURLE_OPERATION_TIMEDOUT && config.deadline && std::chrono::steady_clock::now() >= *config.deadline) {
+            ss << "Deadline exceeded after " << (result.timings ? result.timings->bytesDownloaded : 0)
+               << " bytes, ID: " << config.requestId;
+            logLazy<log::Level::Info>([&](std::ostream &os) {
+                os << "Network::completeRequest() : " << ss.str();
+            });
+            result.setError("Deadline exceeded", ss.str());
+            return std::move(result);
+        }
+
+        if (res != CURLE_OK) {
+            // Handle error
+            ss << "Failed to get network req: " << std::string(curl_easy_strerror(res)) << ", ID: " << config.requestId << ", IP: " << (ip ? ip : "N/A");
+
+            std::string basicMsg = ss.str();
+            logError(basicMsg);
+            ss.str("");
+
+            // Add debug messages
+            context.diagnostics.writeTo(ss);
+
+            // Add certificate information
+            struct curl_certinfo *ci = nullptr;
+            if (curl_easy_getinfo(curl, CURLINFO_CERTINFO, &ci) == CURLE_OK && ci) {
+                for (int i = 0; i < ci->num_of_certs; i++) {
+                    struct curl_slist *slist = ci->certinfo[i];
+                    for (; slist; slist = slist->next) {
+                        ss << "\n[CERT] " << slist->data;
+                    }
+                }
+            }
+
+            std::string details = ss.str();
+            if (!details.empty())
+                logDebug(details);
+            result.setError(basicMsg, details);
+            return std::move(result);
+        }
+        logLazy<log::Level::Info>([&](std::ostream &os) {
+            os << "Network::completeRequest() : "
+               << "Request completed successfully, ID: " << config.requestId
+               << ", Status Code: " << result.statusCode;
+        });
+        // DiagnosticsMode::Full, the only mode that also keeps TLS data
+        if (context.diagnostics.isEnabled() && !context.diagnostics.captureOnlyText()) {
+            logLazy<log::Level::Debug>([&](std::ostream &os) {
+                os << "Network::completeRequest() : Diagnostics, ID: " << config.requestId;
+                context.diagnostics.writeTo(os);
+            });
+        }
+
+        switch (config.method) {
+            case RequestType::Get:
+            case RequestType::Post:
+            case RequestType::UploadFile:
+                if (!config.chunkCallback)
+                    ResponseSink<T>::finalize(context.content);
+                result.content = std::move(context.content);
+                break;
+            case RequestType::Head:
+                // Convert headerContent to the appropriate type T
+                if constexpr (std::is_same_v<T, std::string>) {
+                    result.content = std::move(context.headerContent);
+                } else if constexpr (std::is_same_v<T, std::vector<char>>) {
+                    result.content = std::vector<char>(context.headerContent.begin(), context.headerContent.end());
+                } else if constexpr (std::is_same_v<T, PooledBuffer>) {
+                    if (auto pool = getBufferPool())
+                        context.content = pool->acquire();
+                    context.content.append(context.headerContent.data(), context.headerContent.size());
+                    result.content = std::move(context.content);
+                }
+                // For other types like std::fstream, headers are not typically stored
+                break;
+            default:
+                break;
+        }
+
+        return std::move(result);
+    }
+
+    //=================================================
+    // Response cache
+    //=================================================
+
+    namespace {
+        // Freshness of a response per RFC 9111: whether it may be stored and how long it is fresh
+        struct CachePolicy {
+            bool storable = true;
+            std::chrono::seconds lifetime{0};
+        };
+
+        CachePolicy cachePolicyOf(const HeaderMap &headers) {
+            CachePolicy policy;
+            bool noCache = false;
+            std::optional<std::chrono::seconds> maxAge;
+
+            for (auto value : headers.getAll("Cache-Control")) {
+                while (!value.empty()) {
+                    auto comma = value.find(',');
+                    auto directive = value.substr(0, comma);
+                    value.remove_prefix(comma == std::string_view::npos ? value.size() : comma + 1);
+
+                    auto first = directive.find_first_not_of(" \t");
+                    if (first == std::string_view::npos)
+                        continue;
+                    directive.remove_prefix(first);
+                    directive = directive.substr(0, directive.find_last_not_of(" \t") + 1);
+
+                    auto equals = directive.find('=');
+                    auto name = directive.substr(0, equals);
+                    if (HeaderMap::equalNames(name, "no-store")) {
+                        policy.storable = false;
+                    } else if (HeaderMap::equalNames(name, "no-cache")) {
+                        noCache = true;
+                    } else if (HeaderMap::equalNames(name, "max-age") && equals != std::string_view::npos) {
+                        auto number = directive.substr(equals + 1);
+                        if (number.size() >= 2 && number.front() == '"' && number.back() == '"')
+                            number = number.substr(1, number.size() - 2);
+                        neko::uint64 seconds = 0;
+                        auto [end, ec] = std::from_chars(number.data(), number.data() + number.size(), seconds);
+                        if (ec == std::errc() && end == number.data() + number.size())
+                            maxAge = std::chrono::seconds(seconds);
+                    }
+                }
+            }
+            // Without the request headers the variants cannot be told apart
+            if (auto vary = headers.find("Vary"); vary && vary->find('*') != std::string_view::npos)
+                policy.storable = false;
+
+            if (noCache) {
+                policy.lifetime = std::chrono::seconds(0);
+            } else if (maxAge) {
+                policy.lifetime = *maxAge;
+            } else if (auto expires = headers.get("Expires")) {
+                std::time_t expiresAt = curl_getdate(expires->c_str(), nullptr);
+                auto date = headers.get("Date");
+                std::time_t now = date ? curl_getdate(date->c_str(), nullptr) : -1;
+                if (now == -1)
+                    now = std::time(nullptr);
+                // An invalid Expires, e.g. "0", means already expired
+                if (expiresAt != -1 && expiresAt > now)
+                    policy.lifetime = std::chrono::seconds(expiresAt - now);
+            }
+
+            // Time the response already spent in caches on the way
+            neko::uint64 age = 0;
+            auto ageHeader = headers.find("Age").value_or("");
+            auto [end, ec] = std::from_chars(ageHeader.data(), ageHeader.data() + ageHeader.size(), age);
+            if (!ageHeader.empty() && ec == std::errc())
+                policy.lifetime = std::max(std::chrono::seconds(0), policy.lifetime - std::chrono::seconds(age));
+            return policy;
+        }
+
+        // The URL and all request headers: a response for one credential or representation
+        // (Authorization, Cookie, Accept, ...) is never served for another, whatever the response's Vary says
+        std::string cacheKeyOf(const RequestConfig &config) {
+            std::string key = config.url;
+            key += '\0';
+            key += config.header;
+            config.headers.forEachLine([&key](const std::string &line) {
+                key += '\0';
+                key += line;
+            });
+            return key;
+        }
+
+        // Only in-memory bodies are cached; file streams are written as they arrive
+        template <typename T>
+        constexpr bool isCacheableContent = std::is_same_v<T, std::string> || std::is_same_v<T, std::vector<char>>;
+
+        template <typename T>
+        std::shared_ptr<const std::string> cacheBodyOf(const T &content) {
+            if constexpr (std::is_same_v<T, std::string>) {
+                return std::make_shared<const std::string>(content);
+            } else {
+                return std::make_shared<const std::string>(content.begin(), content.end());
+            }
+        }
+    } // namespace
+
+    /**
+     * An immutable cached response; revalidation replaces it with a new one.
+     */
+    struct Network::CachedResponse {
+        int statusCode = 200;
+        std::shared_ptr<const std::string> body;
+        HeaderMap headers;
+        std::chrono::steady_clock::time_point freshUntil;
+
+        // Returns nullptr if the response must not be stored
+        static std::shared_ptr<const CachedResponse> create(int statusCode, HeaderMap headers, std::shared_ptr<const std::string> body) {
+            auto policy = cachePolicyOf(headers);
+            bool validators = headers.contains("ETag") || headers.contains("Last-Modified");
+            // Nothing to gain from an entry that is never fresh and cannot be revalidated
+            if (!policy.storable || (policy.lifetime.count() == 0 && !validators))
+                return nullptr;
+
+            auto entry = std::make_shared<CachedResponse>();
+            entry->statusCode = statusCode;
+            entry->body = std::move(body);
+            entry->headers = std::move(headers);
+            entry->freshUntil = std::chrono::steady_clock::now() + policy.lifetime;
+            return entry;
+        }
+
+        // The entry after a 304: header fields from the 304 replace the stored ones (RFC 9111 4.3.4)
+        std::shared_ptr<const CachedResponse> revalidated(const HeaderMap &notModified) const {
+            // These describe the stored body, not the empty 304
+            auto replaces = [](std::string_view name) {
+                for (std::string_view kept : {"Content-Length", "Content-Encoding", "Transfer-Encoding", "Content-Range"}) {
+                    if (HeaderMap::equalNames(name, kept))
+                        return false;
+                }
+                return true;
+            };
+            HeaderMap merged = headers;
+            notModified.forEach([&merged, &replaces](std::string_view name, std::string_view) {
+                if (replaces(name))
+                    merged.remove(name);
+            });
+            // Every line, so repeated fields such as Link keep all their values
+            notModified.forEach([&merged, &replaces](std::string_view name, std::string_view value) {
+                if (replaces(name))
+                    merged.add(name, value);
+            });
+            return create(statusCode, std::move(merged), body);
+        }
+
+        bool isFresh() const {
+            return std::chrono::steady_clock::now() < freshUntil;
+        }
+
+        bool canRevalidate() const {
+            return headers.contains("ETag") || headers.contains("Last-Modified");
+        }
+
+        void addValidators(RequestConfig &config) const {
+            if (auto etag = headers.find("ETag"))
+                config.headers.set("If-None-Match", *etag);
+            if (auto lastModified = headers.find("Last-Modified"))
+                config.headers.set("If-Modified-Since", *lastModified);
+        }
+
+        std::size_t size() const {
+            std::size_t bytes = sizeof(CachedResponse) + body->size();
+            headers.forEachLine([&bytes](const std::string &line) { bytes += line.size() + sizeof(std::string); });
+            return bytes;
+        }
+
+        template <typename T>
+        NetworkResult<T> toResult() const {
+            NetworkResult<T> result;
+            result.statusCode = statusCode;
+            if constexpr (std::is_same_v<T, std::string>) {
+                result.content = *body;
+            } else {
+                result.content = T(body->begin(), body->end());
+            }
+            result.headers = headers;
+            result.fromCache = true;
+            return result;
+        }
+    };
+
+    /**
+     * Byte-bounded LRU of CachedResponse by cache key (the URL and request headers), split into shards that are locked independently.
+     */
+    class Network::ResponseCache {
+    public:
+        explicit ResponseCache(const ResponseCacheOptions &options)
+            : shards(std::max<std::size_t>(1, options.shards)),
+              shardBudget(options.maxBytes / std::max<std::size_t>(1, options.shards)) {}
+
+        std::shared_ptr<const CachedResponse> find(const std::string &key) {
+            Shard &shard = shardFor(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.index.find(key);
+            if (it == shard.index.end())
+                return nullptr;
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return it->second->entry;
+        }
+
+        void store(const std::string &key, std::shared_ptr<const CachedResponse> entry) {
+            std::size_t bytes = entry->size() + key.size();
+            Shard &shard = shardFor(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            eraseLocked(shard, key);
+            if (bytes > shardBudget)
+                return;
+            while (shard.bytes + bytes > shardBudget && !shard.lru.empty()) {
+                eraseLocked(shard, shard.lru.back().key);
+            }
+            shard.lru.push_front(Node{key, std::move(entry), bytes});
+            shard.index.emplace(key, shard.lru.begin());
+            shard.bytes += bytes;
+        }
+
+        void erase(const std::string &key) {
+            Shard &shard = shardFor(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            eraseLocked(shard, key);
+        }
+
+        void clear() {
+            for (auto &shard : shards) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.lru.clear();
+                shard.index.clear();
+                shard.bytes = 0;
+            }
+        }
+
+    private:
+        struct Node {
+            std::string key;
+            std::shared_ptr<const CachedResponse> entry;
+            std::size_t bytes;
+        };
+        struct Shard {
+            std::mutex mutex;
+            std::list<Node> lru; // Most recently used first
+            std::unordered_map<std::string, std::list<Node>::iterator> index;
+            std::size_t bytes = 0;
+        };
+
+        Shard &shardFor(const std::string &key) {
+            return shards[std::hash<std::string>{}(key) % shards.size()];
+        }
+
+        static void eraseLocked(Shard &shard, const std::string &key) {
+            auto it = shard.index.find(key);
+            if (it == shard.index.end())
+                return;
+            shard.bytes -= it->second->bytes;
+            auto node = it->second;
+            shard.index.erase(it);
+            shard.lru.erase(node);
+        }
+
+        std::vector<Shard> shards;
+        std::size_t shardBudget;
+    };
+
+    Network &Network::setResponseCache(std::optional<ResponseCacheOptions> options) {
+        auto cache = options ? std::make_shared<ResponseCache>(*options) : nullptr;
+        std::lock_guard<std::mutex> lock(responseCacheMutex);
+        responseCache = std::move(cache);
+        return *this;
+    }
+
+    void Network::clearResponseCache() {
+        std::shared_ptr<ResponseCache> cache;
+        {
+            std::lock_guard<std::mutex> lock(responseCacheMutex);
+            cache = responseCache;
+        }
+        if (cache)
+            cache->clear();
+    }
+
+    template <typename T>
+    std::shared_ptr<Network::ResponseCache> Network::cacheFor(const RequestConfig &config) const {
+        if constexpr (isCacheableContent<T>) {
+            if (!config.useCache || config.method != RequestType::Get || !config.range.empty() || config.chunkCallback)
+                return nullptr;
+            std::lock_guard<std::mutex> lock(responseCacheMutex);
+            return responseCache;
+        } else {
+            return nullptr;
+        }
+    }
+
+    template <typename T>
+    NetworkResult<T> Network::cacheResponse(ResponseCache &cache, const std::string &key,
+                                            const std::shared_ptr<const CachedResponse> &stale, NetworkResult<T> result) {
+        if (stale && !result.hasError && result.statusCode == 304) {
+            metricsRegistry->cacheRevalidated.fetch_add(1, std::memory_order_relaxed);
+            auto refreshed = stale->revalidated(result.headers);
+            const CachedResponse &current = refreshed ? *refreshed : *stale;
+            if (refreshed)
+                cache.store(key, refreshed);
+            else
+                cache.erase(key);
+            logLazy<log::Level::Debug>([&](std::ostream &ss) {
+                ss << "Network::cacheResponse() : Not modified, using cached response, URL: " << key.substr(0, key.find('\0'));
+            });
+            auto cached = current.template toResult<T>();
+            cached.timings = std::move(result.timings);
+            return cached;
+        }
+
+        metricsRegistry->cacheMisses.fetch_add(1, std::memory_order_relaxed);
+        if (!result.hasError && result.statusCode == 200) {
+            if (auto entry = CachedResponse::create(result.statusCode, result.headers, cacheBodyOf(result.content)))
+                cache.store(key, std::move(entry));
+            else
+                cache.erase(key);
+        }
+        return result;
+    }
+
+    //=================================================
+    // Request coalescing
+    //=================================================
+
+    /**
+     * Identical requests in flight by key. The first request of a key leads the flight;
+     * requests that join while it runs wait for its result instead of sending their own.
+     */
+    class Network::FlightGroup {
+    public:
+        template <typename T>
+        using Waiter = std::function<void(NetworkResult<T>)>;
+
+        // Returns true if the caller leads and must call land; otherwise waiter is moved in
+        template <typename T>
+        bool join(const std::string &key, Waiter<T> &waiter) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto [it, leader] = flights.try_emplace(key);
+            if (leader)
+                return true;
+            if (!it->second)
+                it->second = std::make_shared<std::vector<Waiter<T>>>();
+            static_cast<std::vector<Waiter<T>> *>(it->second.get())->push_back(std::move(waiter));
+            return false;
+        }
+
+        // Ends the flight and hands a copy of the result to every waiter, returns how many there were
+        template <typename T>
+        std::size_t land(const std::string &key, const NetworkResult<T> &result) {
+            std::shared_ptr<void> waiting;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = flights.find(key);
+                if (it == flights.end())
+                    return 0;
+                waiting = std::move(it->second);
+                flights.erase(it);
+            }
+            if (!waiting)
+                return 0;
+            auto &waiters = *static_cast<std::vector<Waiter<T>> *>(waiting.get());
+            for (auto &waiter : waiters) {
+                NetworkResult<T> copy = result;
+                copy.coalesced = true;
+                waiter(std::move(copy));
+            }
+            return waiters.size();
+        }
+
+        // The leader's side of a flight; if it is destroyed before it landed, the waiters get an error
+        template <typename T>
+        class Leader {
+        public:
+            Leader(FlightGroup &group, std::string key) : group(group), key(std::move(key)) {}
+            Leader(const Leader &) = delete;
+            Leader &operator=(const Leader &) = delete;
+            ~Leader() {
+                if (landed)
+                    return;
+                // Unwinding from an exception, the next identical request must not join this flight
+                try {
+                    NetworkResult<T> result;
+                    result.setError("Unexpected exception", "The request this one waited for failed");
+                    group.land<T>(key, result);
+                } catch (...) {
+                }
+            }
+
+            std::size_t land(const NetworkResult<T> &result) {
+                landed = true;
+                return group.land<T>(key, result);
+            }
+
+        private:
+            FlightGroup &group;
+            const std::string key;
+            bool landed = false;
+        };
+
+    private:
+        std::mutex mutex;
+        // The waiters of a flight, a std::vector<Waiter<T>> for the T in the key; null until one joins
+        std::unordered_map<std::string, std::shared_ptr<void>> flights;
+    };
+
+    Network &Network::setRequestCoalescing(bool enable) {
+        coalescing.store(enable, std::memory_order_relaxed);
+        return *this;
+    }
+
+    bool Network::getRequestCoalescing() const {
+        return coalescing.load(std::memory_order_relaxed);
+    }
+
+    Network &Network::setBufferPool(std::shared_ptr<BufferPool> pool) {
+        std::lock_guard<std::mutex> lock(bufferPoolMutex);
+        bufferPool = std::move(pool);
+        return *this;
+    }
+
+    std::shared_ptr<BufferPool> Network::getBufferPool() const {
+        std::lock_guard<std::mutex> lock(bufferPoolMutex);
+        return bufferPool;
+    }
+
+    template <typename T>
+    std::optional<std::string> Network::flightKey(const RequestConfig &config) const {
+        if constexpr (isCacheableContent<T>) {
+            if (!coalescing.load(std::memory_order_relaxed) ||
+                (config.method != RequestType::Get && config.method != RequestType::Head) ||
+                config.chunkCallback || config.progressCallback)
+                return std::nullopt;
+            // A follower cannot cancel or time out on its own while it waits for the leader
+            if (config.cancellation || config.deadline)
+                return std::nullopt;
+
+            // Everything that can change the response, separated by a character that cannot occur in them
+            std::string key;
+            key += std::is_same_v<T, std::string> ? 's' : 'v';
+            key += static_cast<char>('0' + static_cast<int>(config.method));
+            key += static_cast<char>('0' + static_cast<int>(config.httpVersion.value_or(config::globalConfig.getHttpVersion())));
+            key += config.acceptEncoding ? '1' : '0';
+            for (neko::uint64 limit : {static_cast<neko::uint64>(config.timeout.count()), static_cast<neko::uint64>(config.connectTimeout.count()),
+                                       static_cast<neko::uint64>(config.lowSpeedLimit), static_cast<neko::uint64>(config.lowSpeedTime.count())}) {
+                key += std::to_string(limit);
+                key += ',';
+            }
+            for (const std::string *part : {&config.url, &config.range, &config.userAgent, &config.proxy, &config.header}) {
+                key += '\0';
+                key += *part;
+            }
+            config.headers.forEachLine([&key](const std::string &line) {
+                key += '\0';
+                key += line;
+            });
+            return key;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    template <typename T>
+    NetworkResult<T> Network::doExecute(const RequestConfig &config, bool admitted) {
+        if (!admitted) {
+            if (auto rejection = circuitRejection(config)) {
+                NetworkResult<T> result;
+                result.setError("Circuit breaker open", *rejection);
+                return result;
+            }
+            auto wait = hostTracker->reserve(hostOf(config.url));
+            if (wait > std::chrono::steady_clock::duration::zero())
+                std::this_thread::sleep_for(wait);
+        }
+
+        logRequestInfo(config);
+
+        // The lease hands the handle back to the pool (reset, connections kept) on every return path
+        HandlePool::Lease lease(*handlePool);
+        RequestContext<T> context(config);
+        recordRequestStart(config);
+
+        if (!setupRequest(lease.handle, context)) {
+            recordRequestEnd(config, context.result);
+            return std::move(context.result);
+        }
+
+        CURLcode res = curl_easy_perform(lease.handle);
+        auto result = completeRequest(lease.handle, res, context);
+        recordRequestEnd(config, result);
+        return result;
+    }
+
+    template <typename T>
+    NetworkResult<T> Network::execute(const RequestConfig &config) {
+        if constexpr (isCacheableContent<T>) {
+            auto cache = cacheFor<T>(config);
+            std::string cacheKey = cache ? cacheKeyOf(config) : std::string();
+            auto cached = cache ? cache->find(cacheKey) : nullptr;
+            if (cached && cached->isFresh()) {
+                metricsRegistry->cacheHits.fetch_add(1, std::memory_order_relaxed);
+                return cached->template toResult<T>();
+            }
+
+            // An identical request in flight answers this one too
+            std::optional<FlightGroup::Leader<T>> leader;
+            if (auto key = flightKey<T>(config)) {
+                auto shared = std::make_shared<std::promise<NetworkResult<T>>>();
+                auto future = shared->get_future();
+                std::function<void(NetworkResult<T>)> waiter = [shared](NetworkResult<T> result) {
+                    shared->set_value(std::move(result));
+                };
+                if (!flights->join<T>(*key, waiter))
+                    return future.get();
+                leader.emplace(*flights, std::move(*key));
+            }
+
+            NetworkResult<T> result;
+            if (!cache) {
+                result = doExecute<T>(config);
+            } else if (cached && cached->canRevalidate()) {
+                RequestConfig conditional = config;
+                cached->addValidators(conditional);
+                result = cacheResponse(*cache, cacheKey, cached, doExecute<T>(conditional));
+            } else {
+                result = cacheResponse<T>(*cache, cacheKey, nullptr, doExecute<T>(config));
+            }
+            if (leader)
+                metricsRegistry->coalesced.fetch_add(leader->land(result), std::memory_order_relaxed);
+            return result;
+        } else {
+            return doExecute<T>(config);
+        }
+    }
+
+    /**
+     * A request driven by the multi engine. It owns its copy of the config and its handle lease,
+     * and lives until the engine reports the transfer as done.
+     */
+    template <typename T>
+    struct Network::AsyncRequest {
+        RequestConfig config;
+        RequestContext<T> context{config};
+        HandlePool::Lease lease;
+        std::function<void(NetworkResult<T>)> onComplete;
+
+        AsyncRequest(RequestConfig &&config, HandlePool &pool, std::function<void(NetworkResult<T>)> onComplete)
+            : config(std::move(config)), lease(pool), onComplete(std::move(onComplete)) {}
+    };
+
+    // The request needs its own copy of the config, the rvalue overloads take it without a further copy
+    template <typename T>
+    std::future<NetworkResult<T>> Network::executeAsync(const RequestConfig &config) {
+        return executeAsync<T>(RequestConfig(config));
+    }
+
+    template <typename T>
+    void Network::executeAsync(const RequestConfig &config, std::type_identity_t<std::function<void(NetworkResult<T>)>> onComplete) {
+        executeAsync<T>(RequestConfig(config), std::move(onComplete));
+    }
+
+    template <typename T>
+    std::future<NetworkResult<T>> Network::executeAsync(RequestConfig &&config) {
+        // Through the callback overload, so that circuit breaker and rate limit apply the same way for every engine
+        auto promise = std::make_shared<std::promise<NetworkResult<T>>>();
+        auto future = promise->get_future();
+        executeAsync<T>(std::move(config), [promise](NetworkResult<T> result) {
+            promise->set_value(std::move(result));
+        });
+        return future;
+    }
+
+    template <typename T>
+    void Network::executeAsync(RequestConfig &&config, std::type_identity_t<std::function<void(NetworkResult<T>)>> onComplete) {
+        if constexpr (isCacheableContent<T>) {
+            auto cache = cacheFor<T>(config);
+            std::string cacheKey = cache ? cacheKeyOf(config) : std::string();
+            auto cached = cache ? cache->find(cacheKey) : nullptr;
+            if (cached && cached->isFresh()) {
+                metricsRegistry->cacheHits.fetch_add(1, std::memory_order_relaxed);
+                onComplete(cached->template toResult<T>());
+                return;
+            }
+
+            // The key is taken before the validators are added, the followers get the result after the cache
+            if (auto key = flightKey<T>(config)) {
+                if (!flights->join<T>(*key, onComplete))
+                    return;
+                // Shared, std::function copies the callback; lands an error if the callback is dropped without a result
+                auto leader = std::make_shared<FlightGroup::Leader<T>>(*flights, std::move(*key));
+                onComplete = [this, leader, onComplete = std::move(onComplete)](NetworkResult<T> result) {
+                    metricsRegistry->coalesced.fetch_add(leader->land(result), std::memory_order_relaxed);
+                    onComplete(std::move(result));
+                };
+            }
+
+            if (cache) {
+                if (cached && cached->canRevalidate())
+                    cached->addValidators(config);
+                else
+                    cached.reset();
+                onComplete = [this, cache, cached, cacheKey = std::move(cacheKey), onComplete = std::move(onComplete)](NetworkResult<T> result) {
+                    onComplete(cacheResponse(*cache, cacheKey, cached, std::move(result)));
+                };
+            }
+        }
+
+        if (auto rejection = circuitRejection(config)) {
+            NetworkResult<T> result;
+            result.setError("Circuit breaker open", *rejection);
+            onComplete(std::move(result));
+            return;
+        }
 
-    template <typename T>
-    NetworkResult<T> Network::execute(const RequestConfig &config) {
-        return doExecute<T>(config);
+        // A rate-limited request waits on the timer instead of holding a thread
+        auto wait = hostTracker->reserve(hostOf(config.url));
+        if (wait > std::chrono::steady_clock::duration::zero()) {
+            auto pending = std::make_shared<std::pair<RequestConfig, std::function<void(NetworkResult<T>)>>>(std::move(config), std::move(onComplete));
+            timer->schedule(wait, [this, pending](bool cancelled) {
+                if (cancelled) {
+                    NetworkResult<T> result;
+                    result.setError("Request cancelled", "Network::executeAsync() : Network is shutting down, ID: " + pending->first.requestId);
+                    pending->second(std::move(result));
+                    return;
+                }
+                startAsync<T>(std::move(pending->first), std::move(pending->second));
+            });
+            return;
+        }
+        startAsync<T>(std::move(config), std::move(onComplete));
     }
 
     template <typename T>
-    std::future<NetworkResult<T>> Network::executeAsync(const RequestConfig &config) {
-        if (executor) {
-            return executor->submit([this, config]() {
-                return this->execute<T>(config);
+    void Network::startAsync(RequestConfig &&config, std::function<void(NetworkResult<T>)> onComplete) {
+        // An exception escaping the request is reported as an error result, the callback is always invoked
+        auto guarded = [this](auto &&run) {
+            NetworkResult<T> result;
+            try {
+                return run();
+            } catch (const std::exception &e) {
+                logError("Network::executeAsync() : Unexpected exception: " + std::string(e.what()));
+                result.setError("Unexpected exception", e.what());
+            } catch (...) {
+                logError("Network::executeAsync() : Unexpected unknown exception");
+                result.setError("Unexpected exception");
+            }
+            return result;
+        };
+
+        // Waiting for a bandwidth limiter would stall every transfer of an I/O thread
+        if (multiEngine && !config.bandwidthLimiter) {
+            auto request = std::make_shared<AsyncRequest<T>>(std::move(config), *handlePool, std::move(onComplete));
+
+            logRequestInfo(request->config);
+            recordRequestStart(request->config);
+            if (!setupRequest(request->lease.handle, request->context)) {
+                recordRequestEnd(request->config, request->context.result);
+                request->onComplete(std::move(request->context.result));
+                return;
+            }
+
+            // Cancelling wakes the I/O threads so the transfer is aborted now, not at the next poll timeout
+            std::size_t wakeSubscription = 0;
+            if (request->config.cancellation)
+                wakeSubscription = request->config.cancellation->subscribe([engine = multiEngine.get()]() { engine->wakeAll(); });
+
+            multiEngine->submit(request->lease.handle, hostOf(request->config.url), [this, request, guarded, wakeSubscription](int code) {
+                if (request->config.cancellation)
+                    request->config.cancellation->unsubscribe(wakeSubscription);
+                auto result = guarded([&]() {
+                    auto result = completeRequest(request->lease.handle, code, request->context);
+                    recordRequestEnd(request->config, result);
+                    return result;
+                });
+                request->onComplete(std::move(result));
             });
+            return;
+        }
+
+        // Released once the task is destroyed, after onComplete has returned
+        auto task = [this, running = tasks->hold(), config = std::move(config), guarded, onComplete = std::move(onComplete)]() {
+            onComplete(guarded([&]() { return this->doExecute<T>(config, true); }));
+        };
+        if (executor) {
+            executor->post(std::move(task));
         } else {
-            // fallback: std::async
-            return std::async(std::launch::async, [this, config]() {
-                return this->execute<T>(config);
+            std::thread(std::move(task)).detach();
+        }
+    }
+
+    //=================================================
+    // Batch execution
+    //=================================================
+
+    /**
+     * Keeps at most maxConcurrency requests in flight, and at most maxPerHost to one host.
+     * Waiting requests are queued per host in input order; hosts are served round-robin
+     * so that one saturated host does not hold back the others.
+     * With cancelOnError, every request also listens to a token of the batch, cancelled by the first failure.
+     */
+    template <typename T>
+    struct Network::BatchState {
+        struct HostQueue {
+            std::deque<std::size_t> pending;
+            std::size_t active = 0;
+        };
+
+        BatchState(const std::vector<RequestConfig> &requests, const BatchOptions &options)
+            : requests(requests),
+              maxConcurrency(options.maxConcurrency == 0 ? requests.size() : options.maxConcurrency),
+              maxPerHost(options.maxPerHost == 0 ? requests.size() : options.maxPerHost),
+              cancellation(options.cancelOnError ? std::make_shared<CancellationToken>() : nullptr) {
+            std::unordered_map<std::string, std::size_t> hostIndex;
+            requestHost.reserve(requests.size());
+            for (std::size_t i = 0; i < requests.size(); ++i) {
+                auto [it, inserted] = hostIndex.try_emplace(hostOf(requests[i].url), hosts.size());
+                if (inserted)
+                    hosts.emplace_back();
+                hosts[it->second].pending.push_back(i);
+                requestHost.push_back(it->second);
+            }
+        }
+
+        const std::vector<RequestConfig> &requests;
+        const std::size_t maxConcurrency;
+        const std::size_t maxPerHost;
+        const std::shared_ptr<CancellationToken> cancellation;
+        std::function<void(std::size_t, NetworkResult<T>)> onComplete;
+
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::vector<HostQueue> hosts;
+        // Index into hosts for every request
+        std::vector<std::size_t> requestHost;
+        std::size_t nextHost = 0;
+        std::size_t inFlight = 0;
+        std::size_t completed = 0;
+
+        // Picks the requests that may start now, call with mutex held
+        std::vector<std::size_t> takeReady() {
+            std::vector<std::size_t> ready;
+            std::size_t idleHosts = 0;
+            while (inFlight < maxConcurrency && idleHosts < hosts.size()) {
+                HostQueue &host = hosts[nextHost];
+                nextHost = (nextHost + 1) % hosts.size();
+                if (host.pending.empty() || host.active >= maxPerHost) {
+                    ++idleHosts;
+                    continue;
+                }
+                idleHosts = 0;
+                ready.push_back(host.pending.front());
+                host.pending.pop_front();
+                ++host.active;
+                ++inFlight;
+            }
+            return ready;
+        }
+    };
+
+    template <typename T>
+    void Network::launchBatch(const std::shared_ptr<BatchState<T>> &state, const std::vector<std::size_t> &ready) {
+        for (std::size_t index : ready) {
+            RequestConfig config = state->requests[index];
+            if (state->cancellation) {
+                // A request with a token of its own listens to both
+                config.cancellation = config.cancellation
+                                          ? std::make_shared<CancellationToken>(std::vector<std::shared_ptr<CancellationToken>>{state->cancellation, config.cancellation})
+                                          : state->cancellation;
+            }
+            executeAsync<T>(std::move(config), [this, state, index](NetworkResult<T> result) {
+                if (state->cancellation && (result.hasError || result.statusCode >= 400) && !state->cancellation->isCancelled()) {
+                    logLazy<log::Level::Info>([&](std::ostream &ss) {
+                        ss << "Network::executeBatch() : "
+                           << "Request " << index << " failed, cancelling the rest of the batch";
+                    });
+                    state->cancellation->cancel();
+                }
+                try {
+                    state->onComplete(index, std::move(result));
+                } catch (const std::exception &e) {
+                    logError("Network::executeBatch() : Completion callback threw: " + std::string(e.what()));
+                } catch (...) {
+                    logError("Network::executeBatch() : Completion callback threw an unknown exception");
+                }
+
+                std::vector<std::size_t> next;
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    --state->hosts[state->requestHost[index]].active;
+                    --state->inFlight;
+                    if (++state->completed == state->requests.size()) {
+                        state->finished.notify_all();
+                        return;
+                    }
+                    next = state->takeReady();
+                }
+                launchBatch(state, next);
             });
         }
     }
 
     template <typename T>
-    NetworkResult<T> Network::executeWithRetry(const RetryConfig &retryConfig) {
-        std::string expectCodes;
-        for (auto code : retryConfig.successCodes) {
-            expectCodes.append(std::to_string(code) + std::string(","));
+    void Network::executeBatch(const std::vector<RequestConfig> &requests, const BatchOptions &options, std::type_identity_t<std::function<void(std::size_t, NetworkResult<T>)>> onComplete) {
+        if (requests.empty())
+            return;
+
+        logLazy<log::Level::Info>([&](std::ostream &ss) {
+            ss << "Network::executeBatch() : "
+               << "Executing " << requests.size() << " requests, Max concurrency: " << options.maxConcurrency
+               << ", Max per host: " << options.maxPerHost;
+        });
+
+        auto state = std::make_shared<BatchState<T>>(requests, options);
+        state->onComplete = std::move(onComplete);
+
+        std::vector<std::size_t> ready;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            ready = state->takeReady();
         }
-        if (!expectCodes.empty()) {
-            expectCodes.pop_back(); // Remove the trailing comma
+        launchBatch(state, ready);
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&state]() { return state->completed == state->requests.size(); });
+    }
+
+    template <typename T>
+    std::vector<NetworkResult<T>> Network::executeBatch(const std::vector<RequestConfig> &requests, const BatchOptions &options) {
+        std::vector<NetworkResult<T>> results(requests.size());
+        // Every index is written exactly once, by one thread, before executeBatch returns
+        executeBatch<T>(requests, options, [&results](std::size_t index, NetworkResult<T> result) {
+            results[index] = std::move(result);
+        });
+        return results;
+    }
+
+    namespace {
+        bool isSuccessCode(const RetryConfig &config, int statusCode) {
+            return std::find(config.successCodes.begin(), config.successCodes.end(), statusCode) != config.successCodes.end();
         }
-        std::stringstream ss;
-        ss << "Network::executeWithRetry() : "
-           << "Executing request with retry, URL: " << retryConfig.config.url
-           << ", Expected codes: " << expectCodes
-           << ", Delay: " << retryConfig.retryDelay.count()
-           << ", Max attempts: " << retryConfig.maxRetries
-           << ", ID: " << retryConfig.config.requestId;
 
-        logInfo(ss.str());
-        ss.str("");
+        std::string joinCodes(const std::vector<int> &codes) {
+            std::string joined;
+            for (auto code : codes) {
+                joined.append(std::to_string(code) + std::string(","));
+            }
+            if (!joined.empty()) {
+                joined.pop_back(); // Remove the trailing comma
+            }
+            return joined;
+        }
 
-        NetworkResult<T> result;
+        // Retry-After is either delay-seconds or an HTTP-date (RFC 9110 10.2.3)
+        std::optional<std::chrono::milliseconds> parseRetryAfter(std::string_view value) {
+            neko::uint64 seconds = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), seconds);
+            if (ec == std::errc() && end == value.data() + value.size())
+                return std::chrono::seconds(seconds);
+
+            std::time_t date = curl_getdate(std::string(value).c_str(), nullptr);
+            if (date == -1)
+                return std::nullopt;
+            return std::chrono::seconds(std::max<std::time_t>(0, date - std::time(nullptr)));
+        }
 
-        for (int attempt = 0; attempt < retryConfig.maxRetries; ++attempt) {
-            result = execute<T>(retryConfig.config);
+        // Exponential backoff for the given retry (0-based), with full jitter if enabled
+        std::chrono::milliseconds backoffDelay(const RetryConfig &config, int retry) {
+            double delay = static_cast<double>(config.retryDelay.count()) * std::pow(std::max(1.0, config.backoffMultiplier), retry);
+            delay = std::min(delay, static_cast<double>(config.maxDelay.count()));
+            if (config.jitter && delay > 0) {
+                thread_local std::minstd_rand random(std::random_device{}());
+                delay = std::uniform_real_distribution<double>(0.0, delay)(random);
+            }
+            return std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(delay));
+        }
+    } // namespace
 
-            ss << "Network::executeWithRetry() : "
-               << "Attempt " << (attempt + 1) << " status code: " << result.statusCode
-               << ", ID: " << retryConfig.config.requestId;
-            logInfo(ss.str());
-            ss.str("");
+    template <typename T>
+    std::optional<std::chrono::milliseconds> Network::nextRetryDelay(const RetryConfig &config, int attempt, const NetworkResult<T> &result) {
+        const std::string &requestId = config.config.requestId;
+        if (attempt + 1 >= config.maxRetries)
+            return std::nullopt;
 
-            for (auto code : retryConfig.successCodes) {
-                if (result.statusCode == code) {
-                    return result;
+        // No response at all is always worth another try, an HTTP status only if it is listed
+        bool gotResponse = result.statusCode != 0;
+        if (gotResponse && std::find(config.retryableCodes.begin(), config.retryableCodes.end(), result.statusCode) == config.retryableCodes.end()) {
+            logLazy<log::Level::Info>([&](std::ostream &ss) {
+                ss << "Network::executeWithRetry() : "
+                   << "Status code " << result.statusCode << " is not retryable, ID: " << requestId;
+            });
+            return std::nullopt;
+        }
+
+        auto delay = backoffDelay(config, attempt);
+        if (auto retryAfter = result.headers.find("Retry-After"); config.honorRetryAfter && retryAfter) {
+            if (auto wait = parseRetryAfter(*retryAfter)) {
+                if (*wait > config.maxDelay) {
+                    logLazy<log::Level::Warn>([&](std::ostream &ss) {
+                        ss << "Network::executeWithRetry() : "
+                           << "Retry-After of " << wait->count() << "ms exceeds the maximum delay, not retrying, ID: " << requestId;
+                    });
+                    return std::nullopt;
                 }
+                delay = *wait;
+            }
+        }
+
+        if (config.config.deadline && std::chrono::steady_clock::now() + delay >= *config.config.deadline) {
+            logLazy<log::Level::Info>([&](std::ostream &ss) {
+                ss << "Network::executeWithRetry() : "
+                   << "Deadline would pass before the next attempt, not retrying, ID: " << requestId;
+            });
+            return std::nullopt;
+        }
+
+        if (!retryLimiter->withdraw()) {
+            logLazy<log::Level::Warn>([&](std::ostream &ss) {
+                ss << "Network::executeWithRetry() : "
+                   << "Retry budget exhausted, not retrying, ID: " << requestId;
+            });
+            return std::nullopt;
+        }
+        return delay;
+    }
+
+    std::optional<std::chrono::milliseconds> Network::hedgeDelayFor(const RetryConfig &config) {
+        constexpr neko::uint64 minHedgeSamples = 20;
+
+        const RequestConfig &request = config.config;
+        bool idempotent = request.method == RequestType::Get || request.method == RequestType::Head;
+        if (!config.hedge || !idempotent || request.chunkCallback)
+            return std::nullopt;
+        if (config.hedgeDelay.count() > 0)
+            return config.hedgeDelay;
+
+        auto latency = metricsRegistry->host(hostOf(request.url)).latency();
+        if (latency.count < minHedgeSamples)
+            return std::nullopt;
+        return std::max(std::chrono::milliseconds(1), std::chrono::duration_cast<std::chrono::milliseconds>(latency.percentile(0.95)));
+    }
+
+    /**
+     * Shared by the copies of a hedged request. The first usable result wins; a failure
+     * only wins once no other copy can still deliver something better. The copies share
+     * a token, cancelled by the winner to abort the copy that is still running.
+     */
+    template <typename T>
+    struct Network::HedgeState {
+        explicit HedgeState(const std::shared_ptr<CancellationToken> &cancellation)
+            : losers(std::make_shared<CancellationToken>(std::vector<std::shared_ptr<CancellationToken>>{cancellation})) {}
+
+        std::mutex mutex;
+        bool done = false;
+        int pending = 1;
+        std::function<void(NetworkResult<T>)> onComplete;
+        std::shared_ptr<CancellationToken> losers;
+
+        void complete(NetworkResult<T> result) {
+            std::function<void(NetworkResult<T>)> deliver;
+            bool running;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (done)
+                    return;
+                --pending;
+                bool usable = !result.hasError && result.statusCode < 500;
+                if (!usable && pending > 0)
+                    return;
+                done = true;
+                running = pending > 0;
+                deliver = std::move(onComplete);
+            }
+            if (running)
+                losers->cancel();
+            deliver(std::move(result));
+        }
+    };
+
+    template <typename T>
+    void Network::executeHedged(const RequestConfig &config, std::chrono::milliseconds delay, std::function<void(NetworkResult<T>)> onComplete) {
+        auto state = std::make_shared<HedgeState<T>>(config.cancellation);
+        state->onComplete = std::move(onComplete);
+
+        RequestConfig primaryConfig = config;
+        primaryConfig.cancellation = state->losers;
+        executeAsync<T>(std::move(primaryConfig), [state](NetworkResult<T> result) {
+            state->complete(std::move(result));
+        });
+
+        RequestConfig hedgeConfig = config;
+        hedgeConfig.requestId = config.requestId + "-hedge";
+        hedgeConfig.cancellation = state->losers;
+        timer->schedule(delay, [this, state, hedgeConfig = std::move(hedgeConfig), delay](bool cancelled) mutable {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (cancelled || state->done)
+                    return;
+                ++state->pending;
             }
+            logLazy<log::Level::Info>([&](std::ostream &ss) {
+                ss << "Network::executeHedged() : "
+                   << "No response after " << delay.count() << "ms, sending hedged request, ID: " << hedgeConfig.requestId;
+            });
+            executeAsync<T>(std::move(hedgeConfig), [state](NetworkResult<T> result) {
+                state->complete(std::move(result));
+            });
+        });
+    }
+
+    template <typename T>
+    NetworkResult<T> Network::executeWithRetry(const RetryConfig &retryConfig) {
+        logLazy<log::Level::Info>([&](std::ostream &ss) {
             ss << "Network::executeWithRetry() : "
-               << "Attempt " << (attempt + 1) << " failed, status code: " << result.statusCode
+               << "Executing request with retry, URL: " << retryConfig.config.url
+               << ", Expected codes: " << joinCodes(retryConfig.successCodes)
+               << ", Delay: " << retryConfig.retryDelay.count()
+               << ", Max attempts: " << retryConfig.maxRetries
                << ", ID: " << retryConfig.config.requestId;
-            logWarn(ss.str());
-            ss.str("");
+        });
+
+        retryLimiter->deposit();
+        const auto hedgeDelay = hedgeDelayFor(retryConfig);
+        NetworkResult<T> result;
+
+        for (int attempt = 0; attempt < retryConfig.maxRetries; ++attempt) {
+            if (attempt > 0)
+                metricsRegistry->retries.fetch_add(1, std::memory_order_relaxed);
+            if (hedgeDelay) {
+                std::promise<NetworkResult<T>> promise;
+                auto future = promise.get_future();
+                executeHedged<T>(retryConfig.config, *hedgeDelay, [&promise](NetworkResult<T> hedged) {
+                    promise.set_value(std::move(hedged));
+                });
+                result = future.get();
+            } else {
+                result = execute<T>(retryConfig.config);
+            }
+
+            logLazy<log::Level::Info>([&](std::ostream &ss) {
+                ss << "Network::executeWithRetry() : "
+                   << "Attempt " << (attempt + 1) << " status code: " << result.statusCode
+                   << ", ID: " << retryConfig.config.requestId;
+            });
 
-            if (attempt < retryConfig.maxRetries - 1) {
-                std::this_thread::sleep_for(retryConfig.retryDelay);
+            if (isSuccessCode(retryConfig, result.statusCode)) {
+                return result;
+            }
+            if (auto reason = stopReason(retryConfig.config)) {
+                logInfo("Network::executeWithRetry() : " + *reason + ", not retrying, ID: " + retryConfig.config.requestId);
+                if (!result.hasError)
+                    result.setError(*reason);
+                return result;
             }
+            logLazy<log::Level::Warn>([&](std::ostream &ss) {
+                ss << "Network::executeWithRetry() : "
+                   << "Attempt " << (attempt + 1) << " failed, status code: " << result.statusCode
+                   << ", ID: " << retryConfig.config.requestId;
+            });
+
+            auto delay = nextRetryDelay(retryConfig, attempt, result);
+            if (!delay)
+                break;
+            std::this_thread::sleep_for(*delay);
         }
 
+        std::stringstream ss;
         ss << "Network::executeWithRetry() : "
            << "All retry attempts failed, ID: " << retryConfig.config.requestId
-           << ", Expected codes: " << expectCodes
+           << ", Expected codes: " << joinCodes(retryConfig.successCodes)
            << ", Last status code: " << result.statusCode;
         logError(ss.str());
         result.setError("All retry attempts failed", ss.str());
@@ -515,68 +3561,526 @@ namespace neko::network {
     }
 
     template <typename T>
-    std::optional<T> Network::findUrlHeader(const std::string &url, const std::string &headerName) {
+    struct Network::RetryState {
+        RetryConfig config;
+        std::function<void(NetworkResult<T>)> onComplete;
+        std::optional<std::chrono::milliseconds> hedgeDelay;
+        int attempt = 0;
+
+        void fail(NetworkResult<T> result, const std::string &reason) {
+            std::stringstream ss;
+            ss << "Network::executeWithRetryAsync() : "
+               << reason << ", ID: " << config.config.requestId
+               << ", Expected codes: " << joinCodes(config.successCodes)
+               << ", Last status code: " << result.statusCode;
+            result.setError(reason, ss.str());
+            onComplete(std::move(result));
+        }
+    };
+
+    template <typename T>
+    void Network::attemptWithRetry(const std::shared_ptr<RetryState<T>> &state) {
+        auto onAttempt = [this, state](NetworkResult<T> result) {
+            const int attempt = state->attempt;
+            if (isSuccessCode(state->config, result.statusCode)) {
+                state->onComplete(std::move(result));
+                return;
+            }
+            if (auto reason = stopReason(state->config.config)) {
+                logInfo("Network::executeWithRetryAsync() : " + *reason + ", not retrying, ID: " + state->config.config.requestId);
+                if (!result.hasError)
+                    result.setError(*reason);
+                state->onComplete(std::move(result));
+                return;
+            }
+            logLazy<log::Level::Warn>([&](std::ostream &ss) {
+                ss << "Network::executeWithRetryAsync() : "
+                   << "Attempt " << (attempt + 1) << " failed, status code: " << result.statusCode
+                   << ", ID: " << state->config.config.requestId;
+            });
+
+            auto delay = nextRetryDelay(state->config, attempt, result);
+            if (!delay) {
+                logError("Network::executeWithRetryAsync() : All retry attempts failed, ID: " + state->config.config.requestId);
+                state->fail(std::move(result), "All retry attempts failed");
+                return;
+            }
+
+            ++state->attempt;
+            auto last = std::make_shared<NetworkResult<T>>(std::move(result));
+            timer->schedule(*delay, [this, state, last](bool cancelled) {
+                if (cancelled) {
+                    state->fail(std::move(*last), "Retry cancelled, Network is shutting down");
+                    return;
+                }
+                metricsRegistry->retries.fetch_add(1, std::memory_order_relaxed);
+                attemptWithRetry(state);
+            });
+        };
+
+        if (state->hedgeDelay)
+            executeHedged<T>(state->config.config, *state->hedgeDelay, std::move(onAttempt));
+        else
+            executeAsync<T>(state->config.config, std::move(onAttempt));
+    }
+
+    template <typename T>
+    void Network::executeWithRetryAsync(const RetryConfig &config, std::type_identity_t<std::function<void(NetworkResult<T>)>> onComplete) {
+        logLazy<log::Level::Info>([&](std::ostream &ss) {
+            ss << "Network::executeWithRetryAsync() : "
+               << "Executing request with retry, URL: " << config.config.url
+               << ", Expected codes: " << joinCodes(config.successCodes)
+               << ", Max attempts: " << config.maxRetries
+               << ", ID: " << config.config.requestId;
+        });
+
+        retryLimiter->deposit();
+        auto state = std::make_shared<RetryState<T>>();
+        state->config = config;
+        state->onComplete = std::move(onComplete);
+        state->hedgeDelay = hedgeDelayFor(config);
+        attemptWithRetry(state);
+    }
+
+    template <typename T>
+    std::future<NetworkResult<T>> Network::executeWithRetryAsync(const RetryConfig &config) {
+        auto promise = std::make_shared<std::promise<NetworkResult<T>>>();
+        auto future = promise->get_future();
+        executeWithRetryAsync<T>(config, [promise](NetworkResult<T> result) {
+            promise->set_value(std::move(result));
+        });
+        return future;
+    }
+
+    Network &Network::setRetryBudget(std::optional<RetryBudget> budget) {
+        retryLimiter->configure(budget);
+        return *this;
+    }
+
+    std::optional<RetryBudget> Network::getRetryBudget() const {
+        return retryLimiter->get();
+    }
+
+    //=================================================
+    // Resource probing
+    //=================================================
+
+    /**
+     * Successful probe results by URL, each valid until its expiry.
+     * Size-bounded: a full cache first drops expired entries, then the one expiring soonest.
+     */
+    struct Network::ProbeCache {
+        static constexpr std::size_t maxEntries = 256;
+
+        struct Entry {
+            ResourceInfo info;
+            std::chrono::steady_clock::time_point expiry;
+        };
+
+        std::atomic<std::chrono::milliseconds::rep> ttlMs{0};
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+
+        std::chrono::milliseconds ttl() const {
+            return std::chrono::milliseconds(ttlMs.load(std::memory_order_relaxed));
+        }
+
+        std::optional<ResourceInfo> get(const std::string &url) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(url);
+            if (it == entries.end())
+                return std::nullopt;
+            if (it->second.expiry <= std::chrono::steady_clock::now()) {
+                entries.erase(it);
+                return std::nullopt;
+            }
+            return it->second.info;
+        }
+
+        void put(const std::string &url, const ResourceInfo &info, std::chrono::milliseconds ttl) {
+            auto now = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (entries.size() >= maxEntries && !entries.contains(url)) {
+                std::erase_if(entries, [now](const auto &entry) { return entry.second.expiry <= now; });
+                if (entries.size() >= maxEntries) {
+                    entries.erase(std::min_element(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+                        return a.second.expiry < b.second.expiry;
+                    }));
+                }
+            }
+            entries.insert_or_assign(url, Entry{info, now + ttl});
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex);
+            entries.clear();
+        }
+    };
+
+    namespace {
+        // Metadata from the headers of a HEAD response or a range probe
+        ResourceInfo resourceInfoFrom(int statusCode, HeaderMap headers) {
+            ResourceInfo info;
+            info.statusCode = statusCode;
+
+            if (statusCode == 206) {
+                // "Content-Range: bytes 0-0/<total>", the total may be "*" if unknown
+                info.acceptsRanges = true;
+                auto range = headers.find("Content-Range").value_or("");
+                auto slash = range.rfind('/');
+                neko::uint64 total = 0;
+                if (slash != std::string_view::npos) {
+                    auto digits = range.substr(slash + 1);
+                    auto [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), total);
+                    if (ec == std::errc() && end == digits.data() + digits.size()) {
+                        info.contentLength = total;
+                        headers.set("Content-Length", std::to_string(total));
+                    }
+                }
+            } else {
+                auto length = headers.find("Content-Length").value_or("");
+                neko::uint64 value = 0;
+                auto [end, ec] = std::from_chars(length.data(), length.data() + length.size(), value);
+                if (!length.empty() && ec == std::errc() && end == length.data() + length.size())
+                    info.contentLength = value;
+                // "none" is the only other registered value
+                auto ranges = headers.find("Accept-Ranges").value_or("");
+                info.acceptsRanges = ranges.find("bytes") != std::string_view::npos;
+            }
+
+            info.contentType = headers.get("Content-Type").value_or("");
+            info.etag = headers.get("ETag").value_or("");
+            info.lastModified = headers.get("Last-Modified").value_or("");
+            info.headers = std::move(headers);
+            return info;
+        }
+    } // namespace
+
+    std::optional<ResourceInfo> Network::probe(const std::string &url) {
         RequestConfig config;
         config.url = url;
-        config.method = RequestType::Head;
+        return probe(config);
+    }
 
-        auto result = execute<std::string>(config);
-        if (!result.isSuccess()) {
-            return std::nullopt;
+    std::optional<ResourceInfo> Network::probe(const RequestConfig &config) {
+        const auto ttl = probeCache->ttl();
+        if (ttl.count() > 0) {
+            if (auto cached = probeCache->get(config.url)) {
+                logLazy<log::Level::Debug>([&](std::ostream &ss) {
+                    ss << "Network::probe() : "
+                       << "Using cached result, URL: " << config.url << ", ID: " << config.requestId;
+                });
+                return cached;
+            }
         }
 
-        // Find the specified header in the response (case-insensitive)
-        std::string headers = result.content;
-        std::string lowerHeaders = headers;
-        std::string lowerHeaderName = headerName;
-        std::transform(lowerHeaders.begin(), lowerHeaders.end(), lowerHeaders.begin(), ::tolower);
-        std::transform(lowerHeaderName.begin(), lowerHeaderName.end(), lowerHeaderName.begin(), ::tolower);
+        // Only what identifies and authorizes the request is kept
+        RequestConfig probeConfig;
+        probeConfig.url = config.url;
+        probeConfig.userAgent = config.userAgent;
+        probeConfig.proxy = config.proxy;
+        probeConfig.requestId = config.requestId + "-probe";
+        probeConfig.header = config.header;
+        probeConfig.headers = config.headers;
+        probeConfig.diagnostics = config.diagnostics;
+        probeConfig.httpVersion = config.httpVersion;
+        probeConfig.method = RequestType::Head;
+
+        auto result = execute<std::string>(probeConfig);
+        std::optional<ResourceInfo> info;
+        if (result.isSuccess()) {
+            info = resourceInfoFrom(result.statusCode, std::move(result.headers));
+        } else if (!result.hasError && result.statusCode >= 400 && result.statusCode != 404 && result.statusCode != 410) {
+            logLazy<log::Level::Info>([&](std::ostream &ss) {
+                ss << "Network::probe() : "
+                   << "HEAD rejected with status " << result.statusCode << ", probing with a range request, URL: " << config.url
+                   << ", ID: " << config.requestId;
+            });
+
+            // A server that ignores the range would send everything, stop after the first byte either way
+            neko::uint64 received = 0;
+            bool stopped = false;
+            probeConfig.method = RequestType::Get;
+            probeConfig.range = "0-0";
+            probeConfig.chunkCallback = [&received, &stopped](std::string_view chunk) {
+                received += chunk.size();
+                stopped = received > 1;
+                return !stopped;
+            };
+            auto rangeResult = execute<std::string>(probeConfig);
+            bool ok = rangeResult.statusCode >= 200 && rangeResult.statusCode < 300 && (!rangeResult.hasError || stopped);
+            if (ok)
+                info = resourceInfoFrom(rangeResult.statusCode, std::move(rangeResult.headers));
+            result = std::move(rangeResult);
+        }
 
-        std::size_t pos = lowerHeaders.find(lowerHeaderName + ":");
-        if (pos == std::string::npos) {
+        if (!info) {
+            logLazy<log::Level::Warn>([&](std::ostream &ss) {
+                ss << "Network::probe() : "
+                   << "Failed to probe resource, Status code: " << result.statusCode
+                   << ", URL: " << config.url << ", ID: " << config.requestId;
+            });
             return std::nullopt;
         }
 
-        // Extract the header value from the original headers (preserving case)
-        std::size_t start = pos + headerName.length() + 1; // Skip "headerName: "
-        std::size_t end = headers.find_first_of("\r\n", start);
-        std::string headerValue = headers.substr(start, end - start);
+        if (ttl.count() > 0)
+            probeCache->put(config.url, *info, ttl);
+        return info;
+    }
 
-        // Trim whitespace
-        headerValue.erase(0, headerValue.find_first_not_of(" \t"));
-        headerValue.erase(headerValue.find_last_not_of(" \t") + 1);
+    Network &Network::setProbeCacheTtl(std::chrono::milliseconds ttl) {
+        probeCache->ttlMs.store(std::max<std::chrono::milliseconds::rep>(0, ttl.count()), std::memory_order_relaxed);
+        if (ttl.count() <= 0)
+            probeCache->clear();
+        return *this;
+    }
 
-        return headerValue;
+    std::chrono::milliseconds Network::getProbeCacheTtl() const {
+        return probeCache->ttl();
     }
 
-    std::optional<neko::uint64> Network::getContentSize(const std::string &url) {
-        auto contentLength = findUrlHeader<std::string>(url, "Content-Length");
-        std::stringstream ss;
-        if (!contentLength.has_value()) {
-            ss << "Network::getContentSize() : "
-               << "Failed to find Content-Length header, URL: " << url;
-            logError(ss.str());
+    void Network::clearProbeCache() {
+        probeCache->clear();
+    }
+
+    template <typename T>
+    std::optional<T> Network::findUrlHeader(const std::string &url, const std::string &headerName) {
+        auto info = probe(url);
+        if (!info) {
             return std::nullopt;
         }
-        try {
-            return std::stoull(*contentLength);
-        } catch (const std::invalid_argument &e) {
-            ss << "Network::getContentSize() : "
-               << "Invalid Content-Length value: " << *contentLength << ", URL: " << url
-               << ", Error: " << e.what();
-            logError(ss.str());
-        } catch (const std::out_of_range &e) {
-            ss << "Network::getContentSize() : "
-               << "Content-Length value out of range: " << *contentLength << ", URL: " << url
-               << ", Error: " << e.what();
-            logError(ss.str());
+
+        auto value = info->headers.find(headerName);
+        if (!value) {
+            return std::nullopt;
         }
+        return T(value->begin(), value->end());
+    }
 
-        return std::nullopt;
+    std::optional<neko::uint64> Network::getContentSize(const std::string &url) {
+        auto info = probe(url);
+        if (!info || !info->contentLength) {
+            logError("Network::getContentSize() : Failed to find Content-Length header, URL: " + url);
+            return std::nullopt;
+        }
+        return info->contentLength;
+    }
+
+    std::optional<std::string> Network::getContentType(const std::string &url) {
+        auto info = probe(url);
+        if (!info || !info->headers.contains("Content-Type")) {
+            return std::nullopt;
+        }
+        return info->contentType;
     }
 
-    std::optional<std::string> Network::getContentType(const std::string &url) {
-        return findUrlHeader<std::string>(url, "Content-Type");
+    //=================================================
+    // Download manifest
+    //=================================================
+
+    /**
+     * Sidecar file (<fileName>.nekopart) of a resumable multiThreadedDownload.
+     * It records the validators the download was started against and the byte ranges already written,
+     * so a restarted download only fetches the missing ranges of an unchanged resource.
+     *
+     * Format, one entry per line:
+     *     nekopart 1
+     *     url <url>
+     *     size <bytes>
+     *     etag <etag>
+     *     last-modified <date>
+     *     done <begin> <end>      (zero or more, end exclusive)
+     */
+    struct Network::DownloadManifest {
+        using Range = std::pair<neko::uint64, neko::uint64>;
+
+        std::string path;
+        std::string url;
+        neko::uint64 size = 0;
+        std::string etag;
+        std::string lastModified;
+
+        static std::string pathFor(const std::string &fileName) {
+            return fileName + ".nekopart";
+        }
+
+        static std::unique_ptr<DownloadManifest> load(const std::string &path) {
+            std::ifstream in(path);
+            if (!in.is_open())
+                return nullptr;
+
+            auto manifest = std::make_unique<DownloadManifest>();
+            manifest->path = path;
+            std::string line;
+            if (!std::getline(in, line) || line != "nekopart 1")
+                return nullptr;
+            while (std::getline(in, line)) {
+                auto space = line.find(' ');
+                std::string key = line.substr(0, space);
+                std::string value = space == std::string::npos ? std::string() : line.substr(space + 1);
+                try {
+                    if (key == "url") {
+                        manifest->url = value;
+                    } else if (key == "size") {
+                        manifest->size = std::stoull(value);
+                    } else if (key == "etag") {
+                        manifest->etag = value;
+                    } else if (key == "last-modified") {
+                        manifest->lastModified = value;
+                    } else if (key == "done") {
+                        std::istringstream range(value);
+                        neko::uint64 begin = 0, end = 0;
+                        if (range >> begin >> end)
+                            manifest->markDone(begin, end);
+                    }
+                } catch (const std::exception &) {
+                    return nullptr;
+                }
+            }
+            return manifest;
+        }
+
+        /**
+         * The saved progress can only be reused for the same resource. A weak ETag does not guarantee
+         * byte-identical content, so it only counts if Last-Modified matches as well.
+         */
+        bool sameResource(const DownloadManifest &current) const {
+            if (url != current.url || size != current.size)
+                return false;
+            bool strongEtag = !etag.empty() && etag.rfind("W/", 0) != 0;
+            if (strongEtag)
+                return etag == current.etag;
+            return !lastModified.empty() && lastModified == current.lastModified && etag == current.etag;
+        }
+
+        bool canResume() const {
+            return (!etag.empty() && etag.rfind("W/", 0) != 0) || !lastModified.empty();
+        }
+
+        // Records [begin, end) as written and persists the manifest.
+        void complete(neko::uint64 begin, neko::uint64 end) {
+            std::lock_guard<std::mutex> lock(mutex);
+            markDone(begin, end);
+            saveLocked();
+        }
+
+        bool save() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return saveLocked();
+        }
+
+        void remove() {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+
+        std::vector<Range> missing() const {
+            std::vector<Range> result;
+            neko::uint64 position = 0;
+            for (const auto &[begin, end] : done) {
+                if (begin > position)
+                    result.emplace_back(position, begin);
+                position = std::max(position, end);
+            }
+            if (position < size)
+                result.emplace_back(position, size);
+            return result;
+        }
+
+        neko::uint64 doneBytes() const {
+            neko::uint64 total = 0;
+            for (const auto &[begin, end] : done) {
+                total += end - begin;
+            }
+            return total;
+        }
+
+    private:
+        // Sorted, non-overlapping and non-adjacent
+        std::vector<Range> done;
+        std::mutex mutex;
+
+        void markDone(neko::uint64 begin, neko::uint64 end) {
+            end = std::min(end, size);
+            if (begin >= end)
+                return;
+            auto it = std::lower_bound(done.begin(), done.end(), Range{begin, end});
+            it = done.insert(it, {begin, end});
+            // Merge with the previous range if they touch
+            if (it != done.begin() && std::prev(it)->second >= it->first) {
+                --it;
+                it->second = std::max(it->second, std::next(it)->second);
+                done.erase(std::next(it));
+            }
+            // Merge following ranges that touch
+            while (std::next(it) != done.end() && std::next(it)->first <= it->second) {
+                it->second = std::max(it->second, std::next(it)->second);
+                done.erase(std::next(it));
+            }
+        }
+
+        // Writes to a temporary file first, so a crash never leaves a truncated manifest
+        bool saveLocked() {
+            std::string tempPath = path + ".tmp";
+            {
+                std::ofstream out(tempPath, std::ios::trunc);
+                if (!out.is_open())
+                    return false;
+                out << "nekopart 1\n"
+                    << "url " << url << "\n"
+                    << "size " << size << "\n"
+                    << "etag " << etag << "\n"
+                    << "last-modified " << lastModified << "\n";
+                for (const auto &[begin, end] : done) {
+                    out << "done " << begin << " " << end << "\n";
+                }
+                if (!out.good())
+                    return false;
+            }
+            std::error_code ec;
+            std::filesystem::rename(tempPath, path, ec);
+            return !ec;
+        }
+    };
+
+    std::unique_ptr<Network::DownloadManifest> Network::openManifest(const MultiDownloadConfig &config, const ResourceInfo &info) {
+        std::stringstream ss;
+        const neko::uint64 fileSize = info.contentLength.value_or(0);
+
+        auto current = std::make_unique<DownloadManifest>();
+        current->path = DownloadManifest::pathFor(config.config.fileName);
+        current->url = config.config.url;
+        current->size = fileSize;
+        current->etag = info.etag;
+        current->lastModified = info.lastModified;
+
+        if (!current->canResume()) {
+            ss << "Network::openManifest() : "
+               << "Server sent neither a strong ETag nor Last-Modified, the download cannot be resumed safely, ID: " << config.config.requestId;
+            logWarn(ss.str());
+            // A manifest from an earlier attempt cannot be trusted either
+            current->remove();
+            return nullptr;
+        }
+
+        auto saved = DownloadManifest::load(current->path);
+        std::error_code ec;
+        bool fileIntact = std::filesystem::exists(config.config.fileName, ec) &&
+                          std::filesystem::file_size(config.config.fileName, ec) == fileSize && !ec;
+        if (saved && fileIntact && saved->sameResource(*current)) {
+            ss << "Network::openManifest() : "
+               << "Resuming download, " << saved->doneBytes() << " of " << fileSize
+               << " bytes already written, ID: " << config.config.requestId;
+            logInfo(ss.str());
+            return saved;
+        }
+
+        if (saved) {
+            ss << "Network::openManifest() : "
+               << "Discarding " << current->path << ", the resource or the output file changed, ID: " << config.config.requestId;
+            logInfo(ss.str());
+        }
+        return current;
     }
 
     bool Network::multiThreadedDownload(const MultiDownloadConfig &config) {
@@ -592,8 +4096,9 @@ namespace neko::network {
         logInfo(ss.str());
         ss.str("");
 
-        // Get file size first
-        auto fileSize = getContentSize(config.config.url);
+        // Size and validators from one probe, or from the probe cache
+        auto info = probe(config.config);
+        auto fileSize = info ? info->contentLength : std::nullopt;
         if (fileSize.value_or(0) == 0) {
             ss << "Network::multiThreadedDownload() : "
                << "Failed to get file size or file is empty, URL: " << config.config.url
@@ -602,11 +4107,56 @@ namespace neko::network {
             return false;
         }
 
+        // The adaptive scheduler always writes in place
+        const bool adaptive = config.approach == MultiDownloadConfig::Approach::Adaptive;
+        const bool directWrite = adaptive || config.writeMode == MultiDownloadConfig::WriteMode::Direct;
+
+        // Resumable in-place downloads keep their progress in a manifest next to the output file
+        std::unique_ptr<DownloadManifest> manifest;
+        if (config.config.resumable && directWrite) {
+            manifest = openManifest(config, *info);
+        } else if (config.config.resumable) {
+            logWarn("Network::multiThreadedDownload() : Resuming is only supported with WriteMode::Direct, downloading from scratch, ID: " + config.config.requestId);
+        }
+        const bool resuming = manifest && manifest->doneBytes() > 0;
+
+        if (manifest && manifest->missing().empty()) {
+            ss << "Network::multiThreadedDownload() : "
+               << "Download already complete according to " << manifest->path
+               << ", ID: " << config.config.requestId;
+            logInfo(ss.str());
+            manifest->remove();
+            return true;
+        }
+
         // Create output file
-        std::fstream outputFile(config.config.fileName,
-                                std::ios::out | std::ios::binary | std::ios::trunc);
+        std::fstream outputFile;
+        if (directWrite) {
+            // Preallocate the whole file, the segments write straight to their offsets
+            PositionalFile preallocated;
+            if (!preallocated.open(config.config.fileName, !resuming) || !preallocated.preallocate(*fileSize)) {
+                ss << "Network::multiThreadedDownload() : "
+                   << "Failed to create and preallocate output file: " << config.config.fileName
+                   << ", Size: " << *fileSize
+                   << ", ID: " << config.config.requestId;
+                logError(ss.str());
+                ss.str("");
+                return false;
+            }
+        } else {
+            outputFile.open(config.config.fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+        }
+
+        if (manifest && !manifest->save()) {
+            logWarn("Network::multiThreadedDownload() : Failed to write download manifest " + manifest->path + ", progress will not be resumable, ID: " + config.config.requestId);
+            manifest.reset();
+        }
+
+        if (adaptive) {
+            return adaptiveDownload(config, *fileSize, manifest.get());
+        }
 
-        if (!outputFile.is_open()) {
+        if (!directWrite && !outputFile.is_open()) {
             ss << "Network::multiThreadedDownload() : "
                << "Failed to open output file for merging: " << config.config.fileName
                << ", ID: " << config.config.requestId;
@@ -725,148 +4275,185 @@ namespace neko::network {
             std::string range;
             std::string tempFile;
             std::string segmentId;
-            std::future<NetworkResult<std::string>> result;
+            neko::uint64 offset;
+            neko::uint64 length;
+            // Set once the segment and its retry are finished, true if it was downloaded
+            std::future<bool> done;
             bool success;
         };
 
         std::vector<DownloadSegment> segments;
-        segments.reserve(numSegments);
 
-        // Create and submit download tasks
-        for (neko::uint64 i = 0; i < numSegments; ++i) {
-            // Calculate start and end positions for current segment
-            neko::uint64 startByte = i * chunkSize;
-            neko::uint64 endByte = (i == numSegments - 1) ? *fileSize - 1 : (i + 1) * chunkSize - 1;
+        // Byte ranges still to download, [begin, end); only a resumed download has gaps
+        std::vector<DownloadManifest::Range> spans = manifest ? manifest->missing() : std::vector<DownloadManifest::Range>{{0, *fileSize}};
 
-            // Ensure not exceeding file size
-            if (startByte >= fileSize.value()) {
-                ss << "Network::multiThreadedDownload() : "
-                   << "Segment " << i << " starts beyond file size, skipping";
-                logWarn(ss.str());
-                ss.str("");
-                continue;
+        // Split every span into segments, a span covering the whole file gets exactly numSegments
+        std::vector<std::pair<neko::uint64, neko::uint64>> segmentBounds;
+        for (const auto &[spanBegin, spanEnd] : spans) {
+            neko::uint64 spanSize = spanEnd - spanBegin;
+            neko::uint64 spanSegments = (spanSize == *fileSize) ? numSegments : (spanSize + chunkSize - 1) / chunkSize;
+            for (neko::uint64 s = 0; s < spanSegments; ++s) {
+                neko::uint64 startByte = spanBegin + s * chunkSize;
+                neko::uint64 endByte = (s == spanSegments - 1) ? spanEnd - 1 : spanBegin + (s + 1) * chunkSize - 1;
+
+                // Ensure not exceeding the span
+                if (startByte >= spanEnd) {
+                    ss << "Network::multiThreadedDownload() : "
+                       << "Segment " << segmentBounds.size() << " starts beyond file size, skipping";
+                    logWarn(ss.str());
+                    ss.str("");
+                    continue;
+                }
+                segmentBounds.emplace_back(startByte, std::min(endByte, spanEnd - 1));
             }
+        }
 
-            if (endByte >= fileSize.value()) {
-                endByte = fileSize.value() - 1;
+        // Once a segment failed for good the file cannot be completed, the segments share a token
+        // to abort the others; it is also cancelled with the caller's token
+        auto cancelSegments = std::make_shared<CancellationToken>(std::vector<std::shared_ptr<CancellationToken>>{config.config.cancellation});
+
+        // Segments only differ in range, target and ID; everything a download does not use is left out
+        // so that the per-segment copies stay small
+        RequestConfig segmentBase = config.config;
+        segmentBase.method = RequestType::DownloadFile;
+        segmentBase.postData.clear();
+        segmentBase.body.reset();
+        segmentBase.bodyReader = nullptr;
+        segmentBase.chunkCallback = nullptr;
+        segmentBase.progressCallback = nullptr;
+        segmentBase.cancellation = cancelSegments;
+
+        // Each segment counts its own bytes, progressCallback gets their sum, including what was resumed
+        neko::uint64 missingBytes = 0;
+        for (const auto &[begin, end] : segmentBounds) {
+            missingBytes += end - begin + 1;
+        }
+        std::vector<std::atomic<neko::uint64>> segmentBytes(segmentBounds.size());
+        std::atomic<neko::uint64> downloadedBytes{*fileSize - std::min(missingBytes, *fileSize)};
+        const neko::uint64 totalBytes = *fileSize;
+
+        auto makeSegmentConfig = [&segmentBase, &config, &segmentBytes, &downloadedBytes, totalBytes, directWrite](neko::uint64 index, std::string range, std::string requestId, neko::uint64 offset, const std::string &tempFile) {
+            RequestConfig segmentConfig = segmentBase;
+            segmentConfig.range = std::move(range);
+            segmentConfig.requestId = std::move(requestId);
+            if (config.config.progressCallback) {
+                segmentConfig.progressCallback = [&config, &segmentBytes, &downloadedBytes, totalBytes, index](neko::uint64 bytes) {
+                    neko::uint64 previous = segmentBytes[index].exchange(bytes, std::memory_order_relaxed);
+                    neko::uint64 total = downloadedBytes.fetch_add(bytes - previous, std::memory_order_relaxed) + (bytes - previous);
+                    // Concurrent segments may report out of order, never more than the file
+                    config.config.progressCallback(std::min(total, totalBytes));
+                };
             }
+            if (directWrite) {
+                segmentConfig.writeOffset = offset;
+            } else {
+                segmentConfig.fileName = tempFile;
+            }
+            return segmentConfig;
+        };
+
+        // A transfer error (e.g. more data than the range) fails the segment too
+        auto segmentSucceeded = [&config](const NetworkResult<std::string> &result) {
+            return !result.hasError && std::find(config.successCodes.begin(), config.successCodes.end(), result.statusCode) != config.successCodes.end();
+        };
+
+        // Create all segments before any starts, the callbacks refer to them
+        segments.reserve(segmentBounds.size());
+        for (neko::uint64 i = 0; i < segmentBounds.size(); ++i) {
+            auto [startByte, endByte] = segmentBounds[i];
 
             std::string range = std::to_string(startByte) + "-" + std::to_string(endByte);
-            // Use more identifiable temporary filename, including part of original filename
-            std::string baseName = std::filesystem::path(config.config.fileName).filename().string();
-            std::string tempFileName = system::tempFolder() + baseName + "." +
-                                       config.config.requestId.substr(0, 8) + "." +
-                                       std::to_string(i);
             std::string segmentId = config.config.requestId + "-" + std::to_string(i);
 
-            // Configure request for current segment
-            RequestConfig segmentConfig = config.config;
-            segmentConfig.range = range;
-            segmentConfig.fileName = tempFileName;
-            segmentConfig.requestId = segmentId;
-            segmentConfig.method = RequestType::DownloadFile;
-
-            ss << "Network::multiThreadedDownload() : "
-               << "Creating segment " << i
-               << ", Range: " << range
-               << ", Temp file: " << tempFileName
-               << ", ID: " << segmentId;
-            logDebug(ss.str());
-            ss.str("");
+            std::string tempFileName;
+            if (!directWrite) {
+                // Use more identifiable temporary filename, including part of original filename
+                std::string baseName = std::filesystem::path(config.config.fileName).filename().string();
+                tempFileName = system::tempFolder() + baseName + "." +
+                               config.config.requestId.substr(0, 8) + "." +
+                               std::to_string(i);
+            }
 
-            // Submit download task to async executor
-            segments.push_back({
-                range,
-                tempFileName,
-                segmentId,
-                executeAsync(segmentConfig),
-                false // Initialize as not successful
+            logLazy<log::Level::Debug>([&](std::ostream &os) {
+                os << "Network::multiThreadedDownload() : "
+                   << "Creating segment " << i
+                   << ", Range: " << range
+                   << ", Target: " << (directWrite ? config.config.fileName + " @" + std::to_string(startByte) : tempFileName)
+                   << ", ID: " << segmentId;
             });
+
+            segments.push_back({range, tempFileName, segmentId, startByte, endByte - startByte + 1, {}, false});
         }
 
-        // Wait for all segments to complete and process results
+        // Submit the segments; a failed one is retried at once, and if its retry fails too the others are cancelled.
+        // Every callback finishes by fulfilling its promise, nothing here is touched after that
+        for (neko::uint64 i = 0; i < segments.size(); ++i) {
+            auto done = std::make_shared<std::promise<bool>>();
+            segments[i].done = done->get_future();
+            const DownloadSegment &segment = segments[i];
+
+            executeAsync<std::string>(makeSegmentConfig(i, segment.range, segment.segmentId, segment.offset, segment.tempFile), [this, &segment, &makeSegmentConfig, &segmentSucceeded, &segmentBytes, &downloadedBytes, cancelSegments, i, done](NetworkResult<std::string> result) {
+                if (segmentSucceeded(result)) {
+                    done->set_value(true);
+                    return;
+                }
+                if (cancelSegments->isCancelled()) {
+                    logLazy<log::Level::Info>([&](std::ostream &os) {
+                        os << "Network::multiThreadedDownload() : "
+                           << "Segment " << i << " cancelled, ID: " << segment.segmentId;
+                    });
+                    done->set_value(false);
+                    return;
+                }
+                logLazy<log::Level::Error>([&](std::ostream &os) {
+                    os << "Network::multiThreadedDownload() : "
+                       << "Segment " << i << " failed, status code: " << result.statusCode
+                       << ", ID: " << segment.segmentId;
+                });
+
+                logLazy<log::Level::Warn>([&](std::ostream &os) {
+                    os << "Network::multiThreadedDownload() : "
+                       << "Retrying segment " << i << ", Range: " << segment.range
+                       << ", ID: " << segment.segmentId;
+                });
+                metricsRegistry->retries.fetch_add(1, std::memory_order_relaxed);
+                // The retry downloads the whole segment again
+                downloadedBytes.fetch_sub(segmentBytes[i].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+                executeAsync<std::string>(makeSegmentConfig(i, segment.range, segment.segmentId + "-retry", segment.offset, segment.tempFile), [this, &segment, &segmentSucceeded, cancelSegments, i, done](NetworkResult<std::string> retried) {
+                    bool success = segmentSucceeded(retried);
+                    if (!success) {
+                        logLazy<log::Level::Error>([&](std::ostream &os) {
+                            os << "Network::multiThreadedDownload() : "
+                               << "Segment " << i << " failed after retry, status code: " << retried.statusCode
+                               << ", Range: " << segment.range
+                               << ", ID: " << segment.segmentId;
+                        });
+                        if (!cancelSegments->isCancelled()) {
+                            logLazy<log::Level::Warn>([&](std::ostream &os) {
+                                os << "Network::multiThreadedDownload() : "
+                                   << "Cancelling the remaining segments, ID: " << segment.segmentId;
+                            });
+                            cancelSegments->cancel();
+                        }
+                    }
+                    done->set_value(success);
+                });
+            });
+        }
 
         ss << "Network::multiThreadedDownload() : "
            << "Waiting for " << segments.size() << " segments to complete";
         logInfo(ss.str());
         ss.str("");
 
-        // First round: wait for all tasks to complete and record results
-        for (neko::uint64 i = 0; i < segments.size(); ++i) {
-            auto result = segments[i].result.get();
-
-            // Check if successful
-            segments[i].success = false;
-            for (auto code : config.successCodes) {
-                if (result.statusCode == code) {
-                    segments[i].success = true;
-                    break;
-                }
-            }
-
-            if (!segments[i].success) {
-                ss << "Network::multiThreadedDownload() : "
-                   << "Segment " << i << " failed, status code: " << result.statusCode
-                   << ", ID: " << segments[i].segmentId;
-                logError(ss.str());
-                ss.str("");
-            }
-        }
-
-        // Second round: retry failed segments
-        std::vector<std::future<NetworkResult<std::string>>> retryResults;
+        // Wait for every segment, including its retry, and record the results
         bool anyFailed = false;
-
-        for (size_t i = 0; i < segments.size(); ++i) {
-            if (!segments[i].success) {
-                ss << "Network::multiThreadedDownload() : "
-                   << "Segment " << i << " failed, retrying"
-                   << ", Range: " << segments[i].range
-                   << ", ID: " << segments[i].segmentId;
-                logError(ss.str());
-                ss.str("");
-
-                RequestConfig retryConfig = config.config;
-                retryConfig.range = segments[i].range;
-                retryConfig.fileName = segments[i].tempFile;
-                retryConfig.requestId = segments[i].segmentId + "-retry";
-                retryConfig.method = RequestType::DownloadFile;
-
-                retryResults.push_back(executeAsync(retryConfig));
-            }
-        }
-
-        // Process retry results
-        if (!retryResults.empty()) {
-            ss << "Network::multiThreadedDownload() : "
-               << "Retrying " << retryResults.size() << " failed segments";
-            logInfo(ss.str());
-            ss.str("");
-
-            neko::uint64 retryIndex = 0;
-            for (neko::uint64 i = 0; i < segments.size(); ++i) {
-                if (!segments[i].success) {
-                    auto result = retryResults[retryIndex++].get();
-
-                    // Re-check if successful
-                    segments[i].success = false;
-                    for (auto code : config.successCodes) {
-                        if (result.statusCode == code) {
-                            segments[i].success = true;
-                            break;
-                        }
-                    }
-
-                    if (!segments[i].success) {
-                        ss << "Network::multiThreadedDownload() : "
-                           << "Segment " << i << " failed after retry, status code: " << result.statusCode
-                           << ", Range: " << segments[i].range
-                           << ", ID: " << segments[i].segmentId;
-                        logError(ss.str());
-                        ss.str("");
-                        anyFailed = true;
-                    }
-                }
+        for (auto &segment : segments) {
+            segment.success = segment.done.get();
+            if (!segment.success) {
+                anyFailed = true;
+            } else if (manifest) {
+                manifest->complete(segment.offset, segment.offset + segment.length);
             }
         }
 
@@ -877,7 +4464,22 @@ namespace neko::network {
             logError(ss.str());
             ss.str("");
 
+            if (manifest) {
+                // Keep the written segments, the next call fetches only what is missing
+                ss << "Network::multiThreadedDownload() : "
+                   << "Progress kept in " << manifest->path << " (" << manifest->doneBytes() << " of " << *fileSize
+                   << " bytes), ID: " << config.config.requestId;
+                logInfo(ss.str());
+                ss.str("");
+            } else if (directWrite) {
+                // The preallocated file has the final size but holes, do not leave it looking complete
+                std::error_code ec;
+                std::filesystem::remove(config.config.fileName, ec);
+            }
+
             for (const auto &segment : segments) {
+                if (segment.tempFile.empty())
+                    continue;
                 try {
                     std::filesystem::remove(segment.tempFile);
                 } catch (const std::exception &e) {
@@ -893,6 +4495,16 @@ namespace neko::network {
             return false;
         }
 
+        if (directWrite) {
+            if (manifest)
+                manifest->remove();
+            ss << "Network::multiThreadedDownload() : "
+               << "All segments written in place, total size: " << *fileSize
+               << " bytes, ID: " << config.config.requestId;
+            logInfo(ss.str());
+            return true;
+        }
+
         // Merge all file segments
         ss << "Network::multiThreadedDownload() : "
            << "All segments downloaded successfully, merging files, ID: " << config.config.requestId;
@@ -903,7 +4515,9 @@ namespace neko::network {
 
             neko::uint64 totalBytesWritten = 0;
             constexpr neko::uint64 bufferSize = 256 * 1024;
-            std::vector<char> buffer(bufferSize);
+            auto pool = getBufferPool();
+            PooledBuffer buffer = pool ? pool->acquire(bufferSize) : PooledBuffer();
+            buffer.reserve(bufferSize);
 
             // Merge each segment in order
             for (neko::uint64 i = 0; i < segments.size(); ++i) {
@@ -971,38 +4585,720 @@ namespace neko::network {
             return false;
         }
     }
+    //=================================================
+    // Adaptive download scheduler
+    //=================================================
+
+    namespace {
+        /**
+         * Hands out byte ranges of one file to a fixed set of workers.
+         *
+         * Unassigned bytes are handed out front to back; each range is a share of what is left,
+         * so ranges shrink towards the end of the file (guided scheduling). When nothing is left
+         * to hand out, an idle worker steals the second half of the range that will take longest
+         * to finish. Failed transfers put their unwritten remainder back into the queue.
+         */
+        class RangeScheduler {
+        public:
+            // A range being downloaded by one worker. The owner advances next, a thief may lower end.
+            struct Slot {
+                neko::uint64 begin = 0;
+                std::atomic<neko::uint64> next{0};
+                std::atomic<neko::uint64> end{0};
+                std::chrono::steady_clock::time_point started;
+            };
+
+            // spans are the [begin, end) ranges to download, in file order
+            RangeScheduler(std::vector<std::pair<neko::uint64, neko::uint64>> spans, neko::uint64 workers, neko::uint64 minRange, neko::uint64 minSteal, neko::uint64 maxFailures)
+                : unassigned(spans.begin(), spans.end()), workers(workers), minRange(minRange), minSteal(minSteal), maxFailures(maxFailures) {
+                for (const auto &[begin, end] : spans) {
+                    unassignedBytes += end - begin;
+                }
+            }
+
+            // Returns the next range to download, or nullptr once there is nothing left for this worker.
+            std::shared_ptr<Slot> acquire() {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (failed)
+                    return nullptr;
+
+                if (!requeued.empty()) {
+                    auto [begin, end] = requeued.front();
+                    requeued.pop_front();
+                    return activate(begin, end);
+                }
+
+                if (!unassigned.empty()) {
+                    auto &[spanBegin, spanEnd] = unassigned.front();
+                    neko::uint64 spanRemaining = spanEnd - spanBegin;
+                    neko::uint64 size = std::min(spanRemaining, std::max(minRange, unassignedBytes / (2 * workers)));
+                    // Do not leave a tail shorter than minRange behind
+                    if (spanRemaining - size < minRange)
+                        size = spanRemaining;
+                    neko::uint64 begin = spanBegin;
+                    spanBegin += size;
+                    unassignedBytes -= size;
+                    if (spanBegin >= spanEnd)
+                        unassigned.pop_front();
+                    return activate(begin, begin + size);
+                }
+
+                return steal();
+            }
+
+            void release(const std::shared_ptr<Slot> &slot) {
+                std::lock_guard<std::mutex> lock(mutex);
+                active.erase(std::remove(active.begin(), active.end(), slot), active.end());
+            }
+
+            // Gives the unwritten part of a failed range back. Returns false once the failure budget is used up.
+            bool requeue(neko::uint64 begin, neko::uint64 end) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (++failures > maxFailures) {
+                    failed = true;
+                    return false;
+                }
+                requeued.emplace_back(begin, end);
+                return true;
+            }
+
+            void fail() {
+                std::lock_guard<std::mutex> lock(mutex);
+                failed = true;
+            }
+
+            bool hasFailed() {
+                std::lock_guard<std::mutex> lock(mutex);
+                return failed;
+            }
+
+        private:
+            std::shared_ptr<Slot> activate(neko::uint64 begin, neko::uint64 end) {
+                auto slot = std::make_shared<Slot>();
+                slot->begin = begin;
+                slot->next.store(begin, std::memory_order_relaxed);
+                slot->end.store(end, std::memory_order_relaxed);
+                slot->started = std::chrono::steady_clock::now();
+                active.push_back(slot);
+                return slot;
+            }
+
+            std::shared_ptr<Slot> steal() {
+                auto now = std::chrono::steady_clock::now();
+                std::shared_ptr<Slot> victim;
+                double longest = 0;
+                for (const auto &slot : active) {
+                    neko::uint64 next = slot->next.load(std::memory_order_acquire);
+                    neko::uint64 end = slot->end.load(std::memory_order_acquire);
+                    if (end <= next || end - next < 2 * minSteal)
+                        continue;
+                    // Estimated time to finish at the rate seen so far, a range without progress counts as slowest
+                    double elapsed = std::chrono::duration<double>(now - slot->started).count();
+                    double rate = (next - slot->begin) / std::max(elapsed, 1e-3);
+                    double remainingTime = rate > 0 ? (end - next) / rate : std::numeric_limits<double>::max();
+                    if (!victim || remainingTime > longest) {
+                        victim = slot;
+                        longest = remainingTime;
+                    }
+                }
+                if (!victim)
+                    return nullptr;
+
+                // The owner stops once it reaches the new end. Bytes it had already written beyond it
+                // are identical to what the thief downloads, so a racing write is harmless.
+                neko::uint64 next = victim->next.load(std::memory_order_acquire);
+                neko::uint64 end = victim->end.load(std::memory_order_acquire);
+                neko::uint64 split = next + (end - next) / 2;
+                victim->end.store(split, std::memory_order_release);
+                return activate(split, end);
+            }
+
+            std::mutex mutex;
+            std::deque<std::pair<neko::uint64, neko::uint64>> unassigned;
+            neko::uint64 unassignedBytes = 0;
+            const neko::uint64 workers;
+            const neko::uint64 minRange;
+            const neko::uint64 minSteal;
+            const neko::uint64 maxFailures;
+            neko::uint64 failures = 0;
+            bool failed = false;
+            std::deque<std::pair<neko::uint64, neko::uint64>> requeued;
+            std::vector<std::shared_ptr<Slot>> active;
+        };
+    } // namespace
+
+    bool Network::adaptiveDownload(const MultiDownloadConfig &config, neko::uint64 fileSize, DownloadManifest *manifest) {
+        constexpr const neko::uint64 defaultWorkers = 8;
+        constexpr const neko::uint64 minRange = 256 * 1024; // Smallest range handed out (256KB)
+        constexpr const neko::uint64 minSteal = 64 * 1024;  // Smallest half split off a straggler (64KB)
+        constexpr const neko::uint64 manifestInterval = 4 * 1024 * 1024; // Record progress of long ranges every 4MB
+
+        auto spans = manifest ? manifest->missing() : std::vector<DownloadManifest::Range>{{0, fileSize}};
+        neko::uint64 missingBytes = 0;
+        for (const auto &[begin, end] : spans) {
+            missingBytes += end - begin;
+        }
+
+        neko::uint64 workers = (config.segmentParam > 0) ? config.segmentParam : defaultWorkers;
+        if (config.maxConnectionsPerHost > 0)
+            workers = std::min(workers, config.maxConnectionsPerHost);
+        workers = std::clamp<neko::uint64>((missingBytes + minRange - 1) / minRange, 1, workers);
+
+        std::stringstream ss;
+        ss << "Network::adaptiveDownload() : "
+           << "Workers: " << workers
+           << ", File size: " << fileSize << " bytes"
+           << ", Missing: " << missingBytes << " bytes"
+           << ", Download URL: " << config.config.url
+           << ", Output file: " << config.config.fileName
+           << ", ID: " << config.config.requestId;
+        logInfo(ss.str());
+        ss.str("");
+
+        PositionalFile output;
+        if (!output.open(config.config.fileName, false)) {
+            ss << "Network::adaptiveDownload() : "
+               << "Failed to open output file: " << config.config.fileName
+               << ", ID: " << config.config.requestId;
+            logError(ss.str());
+            return false;
+        }
+
+        RangeScheduler scheduler(spans, workers, minRange, minSteal, workers * 2);
+        // Counts resumed bytes too, so progress covers the whole file
+        std::atomic<neko::uint64> bytesWritten{fileSize - missingBytes};
+        // Aborts the other workers' transfers once the download cannot complete, or the caller cancels it
+        auto abort = std::make_shared<CancellationToken>(std::vector<std::shared_ptr<CancellationToken>>{config.config.cancellation});
+
+        auto worker = [this, &config, &scheduler, &output, &bytesWritten, &abort, fileSize, manifest](neko::uint64 index) {
+            // One handle per worker, so consecutive ranges reuse its connection
+            HandlePool::Lease lease(*handlePool);
+            neko::uint64 rangeCount = 0;
+
+            while (auto slot = scheduler.acquire()) {
+                RequestConfig rangeConfig = config.config;
+                rangeConfig.method = RequestType::Get;
+                rangeConfig.range = std::to_string(slot->begin) + "-" + std::to_string(slot->end.load(std::memory_order_acquire) - 1);
+                rangeConfig.requestId = config.config.requestId + "-w" + std::to_string(index) + "." + std::to_string(rangeCount++);
+                rangeConfig.progressCallback = nullptr;
+                rangeConfig.resumable = false;
+                rangeConfig.cancellation = abort;
+
+                bool statusChecked = false;
+                bool rangeRejected = false;
+                bool writeFailed = false;
+                // Start of the written bytes not yet recorded in the manifest
+                neko::uint64 recorded = slot->begin;
+                rangeConfig.chunkCallback = [&](std::string_view data) {
+                    if (!statusChecked) {
+                        // A server that ignores the Range header sends the file from byte 0
+                        long statusCode = 0;
+                        curl_easy_getinfo(lease.handle, CURLINFO_RESPONSE_CODE, &statusCode);
+                        if (statusCode != 206 && !(statusCode == 200 && slot->begin == 0)) {
+                            rangeRejected = true;
+                            return false;
+                        }
+                        statusChecked = true;
+                    }
+
+                    neko::uint64 next = slot->next.load(std::memory_order_relaxed);
+                    neko::uint64 end = slot->end.load(std::memory_order_acquire);
+                    if (next >= end)
+                        return false; // The rest of the range was stolen
+                    neko::uint64 size = std::min<neko::uint64>(data.size(), end - next);
+                    if (!output.writeAt(next, data.data(), size)) {
+                        writeFailed = true;
+                        return false;
+                    }
+                    slot->next.store(next + size, std::memory_order_release);
+                    if (manifest && next + size - recorded >= manifestInterval) {
+                        manifest->complete(recorded, next + size);
+                        recorded = next + size;
+                    }
+
+                    // A write racing with a steal may be counted twice, never report more than the file
+                    neko::uint64 total = bytesWritten.fetch_add(size, std::memory_order_relaxed) + size;
+                    if (config.config.progressCallback)
+                        config.config.progressCallback(std::min(total, fileSize));
+                    return next + size < end;
+                };
+
+                // Drop the options of the previous range, the connection is kept
+                curl_easy_reset(lease.handle);
+                auto wait = hostTracker->reserve(hostOf(rangeConfig.url));
+                if (wait > std::chrono::steady_clock::duration::zero())
+                    std::this_thread::sleep_for(wait);
+                logRequestInfo(rangeConfig);
+                RequestContext<std::string> context(rangeConfig);
+                recordRequestStart(rangeConfig);
+                NetworkResult<std::string> result;
+                if (setupRequest(lease.handle, context)) {
+                    CURLcode res = curl_easy_perform(lease.handle);
+                    result = completeRequest(lease.handle, res, context);
+                } else {
+                    result = std::move(context.result);
+                }
+
+                bool done = slot->next.load(std::memory_order_acquire) >= slot->end.load(std::memory_order_acquire);
+                if (done) {
+                    // Stopping at the end of a shortened range aborts the transfer, that is not an error
+                    result.hasError = false;
+                }
+                recordRequestEnd(rangeConfig, result);
+                scheduler.release(slot);
+                if (manifest) {
+                    neko::uint64 written = std::min(slot->next.load(std::memory_order_acquire), slot->end.load(std::memory_order_acquire));
+                    if (written > recorded)
+                        manifest->complete(recorded, written);
+                }
+
+                if (abort->isCancelled()) {
+                    logLazy<log::Level::Info>([&](std::ostream &os) {
+                        os << "Network::adaptiveDownload() : Download cancelled, worker " << index << " stops, ID: " << config.config.requestId;
+                    });
+                    scheduler.fail();
+                    return;
+                }
+                if (done)
+                    continue;
+
+                if (rangeRejected || writeFailed) {
+                    logError(std::string("Network::adaptiveDownload() : ") +
+                             (rangeRejected ? "Server did not return 206 Partial Content for range " : "Failed to write range ") +
+                             rangeConfig.range + ", ID: " + rangeConfig.requestId);
+                    scheduler.fail();
+                    abort->cancel();
+                    return;
+                }
+
+                neko::uint64 next = slot->next.load(std::memory_order_acquire);
+                neko::uint64 end = slot->end.load(std::memory_order_acquire);
+                logWarn("Network::adaptiveDownload() : Range " + rangeConfig.range + " stopped at " + std::to_string(next) +
+                        ", status code: " + std::to_string(result.statusCode) + ", retrying the remainder, ID: " + rangeConfig.requestId);
+                metricsRegistry->retries.fetch_add(1, std::memory_order_relaxed);
+                if (!scheduler.requeue(next, end)) {
+                    logError("Network::adaptiveDownload() : Too many failed ranges, giving up, ID: " + config.config.requestId);
+                    abort->cancel();
+                    return;
+                }
+            }
+        };
+
+        std::vector<std::future<void>> running;
+        running.reserve(workers);
+        for (neko::uint64 i = 0; i < workers; ++i) {
+            if (executor) {
+                running.push_back(executor->submit([worker, i]() { worker(i); }));
+            } else {
+                running.push_back(std::async(std::launch::async, worker, i));
+            }
+        }
+        for (auto &future : running) {
+            future.get();
+        }
+        output.close();
+
+        if (scheduler.hasFailed() || bytesWritten.load() < fileSize) {
+            ss << "Network::adaptiveDownload() : "
+               << "Download incomplete, written: " << bytesWritten.load() << " of " << fileSize
+               << " bytes, ID: " << config.config.requestId;
+            logError(ss.str());
+            ss.str("");
+            if (manifest) {
+                // Keep the written ranges, the next call fetches only what is missing
+                ss << "Network::adaptiveDownload() : "
+                   << "Progress kept in " << manifest->path << " (" << manifest->doneBytes() << " of " << fileSize
+                   << " bytes), ID: " << config.config.requestId;
+                logInfo(ss.str());
+            } else {
+                // The preallocated file has the final size but holes, do not leave it looking complete
+                std::error_code ec;
+                std::filesystem::remove(config.config.fileName, ec);
+            }
+            return false;
+        }
+
+        if (manifest)
+            manifest->remove();
+        ss << "Network::adaptiveDownload() : "
+           << "All ranges written in place, total size: " << fileSize
+           << " bytes, ID: " << config.config.requestId;
+        logInfo(ss.str());
+        return true;
+    }
+
+    //=================================================
+    // Download manager
+    //=================================================
+
+    struct DownloadManager::State {
+        struct Worker {
+            std::shared_ptr<DownloadJob> job;
+            std::thread thread;
+            bool done = false;
+        };
+
+        // Backing off never holds the jobs below this rate
+        static constexpr neko::uint64 minBackoffRate = 16 * 1024;
+
+        explicit State(const DownloadManagerOptions &options)
+            : options(options), limiter(std::make_shared<BandwidthLimiter>(options.bandwidthLimit)),
+              minConcurrency(std::max<std::size_t>(options.minConcurrentJobs, 1)),
+              maxConcurrency(std::max(options.maxConcurrentJobs, minConcurrency)),
+              concurrency(maxConcurrency), bandwidthLimit(options.bandwidthLimit) {}
+
+        const DownloadManagerOptions options;
+        // Parent of every job's limiter
+        const std::shared_ptr<BandwidthLimiter> limiter;
+        const std::size_t minConcurrency;
+        const std::size_t maxConcurrency;
+
+        mutable std::mutex mutex;
+        // Something for the scheduler to do: a job was added, finished or cancelled, or the manager stops
+        std::condition_variable changed;
+        std::condition_variable idle;
+        bool dirty = false;
+        bool stopping = false;
+        std::size_t concurrency;
+        // The cap set by the user, and the lower rate of a backoff (0 if none); the limiter runs at the lower one
+        neko::uint64 bandwidthLimit;
+        neko::uint64 backoffRate = 0;
+        // The rate when the backoff started, which backoffRate is restored to by steps, an eighth of it each
+        neko::uint64 backoffFrom = 0;
+        neko::uint64 backoffStep = 0;
+        neko::uint64 nextSequence = 0;
+        std::vector<std::shared_ptr<DownloadJob>> queue;
+        // Stable addresses, each job's thread marks its own entry done
+        std::list<Worker> running;
+
+        // Only used by the scheduler thread
+        LatencyHistogram lastLatency;
+        neko::uint64 lastConsumed = 0;
+        std::chrono::steady_clock::time_point lastAdjust = std::chrono::steady_clock::now();
+        std::thread scheduler;
+
+        // Called with the mutex held
+        void applyRate() {
+            neko::uint64 rate = bandwidthLimit;
+            if (backoffRate > 0)
+                rate = rate > 0 ? std::min(rate, backoffRate) : backoffRate;
+            limiter->setRate(rate);
+        }
+
+        void notify() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                dirty = true;
+            }
+            changed.notify_all();
+        }
+    };
+
+    DownloadManager::DownloadManager(Network &network, DownloadManagerOptions options)
+        : network(network), state(std::make_shared<State>(options)) {
+        state->lastLatency = network.metrics().interactiveLatency;
+        state->scheduler = std::thread([this]() { schedule(); });
+    }
+
+    DownloadManager::~DownloadManager() {
+        std::vector<std::shared_ptr<DownloadJob>> jobs;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->stopping = true;
+            jobs = state->queue;
+            for (const auto &worker : state->running) {
+                jobs.push_back(worker.job);
+            }
+        }
+        // Outside the lock, cancelling notifies the scheduler
+        for (const auto &job : jobs) {
+            job->cancel();
+        }
+        state->changed.notify_all();
+        state->scheduler.join();
+    }
+
+    std::shared_ptr<DownloadJob> DownloadManager::enqueue(MultiDownloadConfig config, int priority, neko::uint64 bandwidthLimit) {
+        auto limiter = std::make_shared<BandwidthLimiter>(bandwidthLimit, state->limiter);
+        auto cancellation = std::make_shared<CancellationToken>(std::vector<std::shared_ptr<CancellationToken>>{config.config.cancellation});
+        config.config.bandwidthLimiter = limiter;
+        config.config.cancellation = cancellation;
+
+        neko::uint64 sequence;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            sequence = state->nextSequence++;
+        }
+        std::shared_ptr<DownloadJob> job(new DownloadJob(std::move(config), priority, sequence, std::move(limiter), std::move(cancellation)));
+
+        // The callback lives in the job's own config, so the job outlives every call.
+        // Segments may report out of order, only the largest count is kept and passed on
+        DownloadJob *raw = job.get();
+        job->config.config.progressCallback = [raw, callback = std::move(job->config.config.progressCallback)](neko::uint64 bytes) {
+            neko::uint64 previous = raw->downloaded.load(std::memory_order_relaxed);
+            while (previous < bytes && !raw->downloaded.compare_exchange_weak(previous, bytes, std::memory_order_relaxed)) {
+            }
+            if (callback)
+                callback(std::max(previous, bytes));
+        };
+
+        // A cancelled job leaves the queue at once instead of when it would have started
+        job->cancellation->subscribe([weak = std::weak_ptr<State>(state)]() {
+            if (auto shared = weak.lock())
+                shared->notify();
+        });
+
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->queue.push_back(job);
+            state->dirty = true;
+        }
+        state->changed.notify_all();
+        return job;
+    }
+
+    void DownloadManager::setBandwidthLimit(neko::uint64 bytesPerSecond) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->bandwidthLimit = bytesPerSecond;
+        state->applyRate();
+    }
+
+    neko::uint64 DownloadManager::getBandwidthLimit() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->bandwidthLimit;
+    }
+
+    neko::uint64 DownloadManager::getBackoffRate() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->backoffRate;
+    }
+
+    std::size_t DownloadManager::getConcurrency() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->concurrency;
+    }
+
+    std::size_t DownloadManager::queuedJobs() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->queue.size();
+    }
+
+    std::size_t DownloadManager::runningJobs() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return static_cast<std::size_t>(std::count_if(state->running.begin(), state->running.end(),
+                                                      [](const State::Worker &worker) { return !worker.done; }));
+    }
+
+    void DownloadManager::waitIdle() {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->idle.wait(lock, [this]() { return state->queue.empty() && state->running.empty(); });
+    }
+
+    void DownloadManager::schedule() {
+        const bool adjusting = state->options.latencyTarget.count() > 0;
+        auto nextAdjust = std::chrono::steady_clock::now() + state->options.adjustInterval;
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        while (true) {
+            auto wake = [this]() { return state->dirty || state->stopping; };
+            if (adjusting) {
+                state->changed.wait_until(lock, nextAdjust, wake);
+            } else {
+                state->changed.wait(lock, wake);
+            }
+            state->dirty = false;
+
+            if (adjusting && std::chrono::steady_clock::now() >= nextAdjust) {
+                lock.unlock();
+                adjustConcurrency();
+                lock.lock();
+                nextAdjust = std::chrono::steady_clock::now() + state->options.adjustInterval;
+            }
+
+            // A finished job's thread is about to return
+            for (auto it = state->running.begin(); it != state->running.end();) {
+                if (it->done) {
+                    it->thread.join();
+                    it = state->running.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            std::erase_if(state->queue, [](const std::shared_ptr<DownloadJob> &job) {
+                if (!job->cancellation->isCancelled())
+                    return false;
+                job->finish(DownloadState::Cancelled, false);
+                return true;
+            });
+
+            // Highest priority first, then in the order they were added
+            while (!state->stopping && state->running.size() < state->concurrency && !state->queue.empty()) {
+                auto next = std::max_element(state->queue.begin(), state->queue.end(), [](const auto &a, const auto &b) {
+                    int priorityA = a->getPriority();
+                    int priorityB = b->getPriority();
+                    return priorityA != priorityB ? priorityA < priorityB : a->sequence > b->sequence;
+                });
+                auto job = std::move(*next);
+                state->queue.erase(next);
+
+                job->state.store(DownloadState::Running, std::memory_order_release);
+                State::Worker &worker = state->running.emplace_back();
+                worker.job = job;
+                // Still under the lock, so the thread sees its entry complete
+                worker.thread = std::thread([this, &worker]() {
+                    run(worker.job);
+                    std::lock_guard<std::mutex> guard(state->mutex);
+                    worker.done = true;
+                    state->dirty = true;
+                    state->changed.notify_all();
+                });
+            }
+
+            if (state->queue.empty() && state->running.empty()) {
+                state->idle.notify_all();
+                if (state->stopping)
+                    return;
+            }
+        }
+    }
+
+    void DownloadManager::adjustConcurrency() {
+        // The histogram counts since the start, the difference to the last one covers the interval
+        LatencyHistogram latency = network.metrics().interactiveLatency;
+        LatencyHistogram window = latency;
+        if (latency.count >= state->lastLatency.count) {
+            for (std::size_t i = 0; i < LatencyHistogram::bucketCount; ++i) {
+                window.buckets[i] -= std::min(window.buckets[i], state->lastLatency.buckets[i]);
+            }
+            window.count -= state->lastLatency.count;
+            window.sumMicroseconds -= std::min(window.sumMicroseconds, state->lastLatency.sumMicroseconds);
+        } // Otherwise the metrics were reset, all of them are new
+        state->lastLatency = latency;
+
+        bool slow = window.count > 0 && window.percentile(state->options.latencyPercentile) > state->options.latencyTarget;
+
+        // What the jobs received over the interval
+        auto now = std::chrono::steady_clock::now();
+        neko::uint64 consumed = state->limiter->getConsumedBytes();
+        double seconds = std::chrono::duration<double>(now - state->lastAdjust).count();
+        auto throughput = static_cast<neko::uint64>(seconds > 0 ? static_cast<double>(consumed - state->lastConsumed) / seconds : 0.0);
+        state->lastConsumed = consumed;
+        state->lastAdjust = now;
+
+        std::size_t previous, current;
+        neko::uint64 previousRate, currentRate;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            previous = state->concurrency;
+            previousRate = state->backoffRate;
+            // Halve quickly while interactive requests suffer, recover one job at a time.
+            // Fewer jobs only help once one ends, so the rate of the running ones is halved too
+            if (slow) {
+                state->concurrency = std::max(state->concurrency / 2, state->minConcurrency);
+                // Received bytes come in bursts, what was measured may lie above the rate in force
+                neko::uint64 rate = state->backoffRate > 0 ? state->backoffRate : state->bandwidthLimit;
+                if (throughput > 0)
+                    rate = rate > 0 ? std::min(rate, throughput) : throughput;
+                if (rate > 0) {
+                    if (state->backoffRate == 0) {
+                        state->backoffFrom = rate;
+                        state->backoffStep = std::max(rate / 8, State::minBackoffRate);
+                    }
+                    state->backoffRate = std::max(rate / 2, State::minBackoffRate);
+                }
+            } else {
+                state->concurrency = std::min(state->concurrency + 1, state->maxConcurrency);
+                if (state->backoffRate > 0) {
+                    state->backoffRate += state->backoffStep;
+                    if (state->backoffRate >= state->backoffFrom)
+                        state->backoffRate = 0;
+                }
+            }
+            if (state->backoffRate != previousRate)
+                state->applyRate();
+            current = state->concurrency;
+            currentRate = state->backoffRate;
+        }
+        if (current != previous || currentRate != previousRate) {
+            network.logLazy<log::Level::Debug>([&](std::ostream &os) {
+                os << "DownloadManager::adjustConcurrency() : Running up to " << current << " jobs"
+                   << ", backoff rate: " << currentRate << " bytes/s, received: " << throughput << " bytes/s"
+                   << ", interactive latency: " << window.percentile(state->options.latencyPercentile).count() << "us"
+                   << " over " << window.count << " requests";
+            });
+        }
+    }
+
+    void DownloadManager::run(std::shared_ptr<DownloadJob> job) {
+        bool success = false;
+        try {
+            success = network.multiThreadedDownload(job->config);
+        } catch (...) {
+            // Counts as failed, the job's thread must not terminate the process
+        }
+        if (success) {
+            job->finish(DownloadState::Completed, true);
+        } else {
+            job->finish(job->cancellation->isCancelled() ? DownloadState::Cancelled : DownloadState::Failed, false);
+        }
+    }
+
     // Explicit template instantiation for the types we want to use
 
     // Sync template instantiations
     template NetworkResult<std::string> Network::execute(const RequestConfig &);
     template NetworkResult<std::vector<char>> Network::execute(const RequestConfig &);
     template NetworkResult<std::fstream> Network::execute(const RequestConfig &);
+    template NetworkResult<PooledBuffer> Network::execute(const RequestConfig &);
 
     // Async template instantiations
     template std::future<NetworkResult<std::string>> Network::executeAsync(const RequestConfig &);
     template std::future<NetworkResult<std::vector<char>>> Network::executeAsync(const RequestConfig &);
     template std::future<NetworkResult<std::fstream>> Network::executeAsync(const RequestConfig &);
+    template std::future<NetworkResult<PooledBuffer>> Network::executeAsync(const RequestConfig &);
+
+    template void Network::executeAsync<std::string>(const RequestConfig &, std::function<void(NetworkResult<std::string>)>);
+    template void Network::executeAsync<std::vector<char>>(const RequestConfig &, std::function<void(NetworkResult<std::vector<char>>)>);
+    template void Network::executeAsync<std::fstream>(const RequestConfig &, std::function<void(NetworkResult<std::fstream>)>);
+    template void Network::executeAsync<PooledBuffer>(const RequestConfig &, std::function<void(NetworkResult<PooledBuffer>)>);
+
+    template std::future<NetworkResult<std::string>> Network::executeAsync(RequestConfig &&);
+    template std::future<NetworkResult<std::vector<char>>> Network::executeAsync(RequestConfig &&);
+    template std::future<NetworkResult<std::fstream>> Network::executeAsync(RequestConfig &&);
+    template std::future<NetworkResult<PooledBuffer>> Network::executeAsync(RequestConfig &&);
+
+    template void Network::executeAsync<std::string>(RequestConfig &&, std::function<void(NetworkResult<std::string>)>);
+    template void Network::executeAsync<std::vector<char>>(RequestConfig &&, std::function<void(NetworkResult<std::vector<char>>)>);
+    template void Network::executeAsync<std::fstream>(RequestConfig &&, std::function<void(NetworkResult<std::fstream>)>);
+    template void Network::executeAsync<PooledBuffer>(RequestConfig &&, std::function<void(NetworkResult<PooledBuffer>)>);
+
+    template std::vector<NetworkResult<std::string>> Network::executeBatch(const std::vector<RequestConfig> &, const BatchOptions &);
+    template std::vector<NetworkResult<std::vector<char>>> Network::executeBatch(const std::vector<RequestConfig> &, const BatchOptions &);
+    template std::vector<NetworkResult<std::fstream>> Network::executeBatch(const std::vector<RequestConfig> &, const BatchOptions &);
+    template std::vector<NetworkResult<PooledBuffer>> Network::executeBatch(const std::vector<RequestConfig> &, const BatchOptions &);
+    template void Network::executeBatch<std::string>(const std::vector<RequestConfig> &, const BatchOptions &, std::function<void(std::size_t, NetworkResult<std::string>)>);
+    template void Network::executeBatch<std::vector<char>>(const std::vector<RequestConfig> &, const BatchOptions &, std::function<void(std::size_t, NetworkResult<std::vector<char>>)>);
+    template void Network::executeBatch<std::fstream>(const std::vector<RequestConfig> &, const BatchOptions &, std::function<void(std::size_t, NetworkResult<std::fstream>)>);
+    template void Network::executeBatch<PooledBuffer>(const std::vector<RequestConfig> &, const BatchOptions &, std::function<void(std::size_t, NetworkResult<PooledBuffer>)>);
 
     // Retry template instantiations
     template NetworkResult<std::string> Network::executeWithRetry(const RetryConfig &);
     template NetworkResult<std::vector<char>> Network::executeWithRetry(const RetryConfig &);
     template NetworkResult<std::fstream> Network::executeWithRetry(const RetryConfig &);
+    template NetworkResult<PooledBuffer> Network::executeWithRetry(const RetryConfig &);
 
-    // IAsyncExecutor template instantiations
-    template std::future<NetworkResult<std::string>> executor::IAsyncExecutor::submitImpl(std::function<NetworkResult<std::string>()> f);
-    template std::future<NetworkResult<std::vector<char>>> executor::IAsyncExecutor::submitImpl(std::function<NetworkResult<std::vector<char>>()> f);
-    template std::future<NetworkResult<std::fstream>> executor::IAsyncExecutor::submitImpl(std::function<NetworkResult<std::fstream>()> f);
-
-    // StdAsyncExecutor template instantiations
-    template std::future<NetworkResult<std::string>> executor::StdAsyncExecutor::submitImpl(std::function<NetworkResult<std::string>()> f);
-    template std::future<NetworkResult<std::vector<char>>> executor::StdAsyncExecutor::submitImpl(std::function<NetworkResult<std::vector<char>>()> f);
-    template std::future<NetworkResult<std::fstream>> executor::StdAsyncExecutor::submitImpl(std::function<NetworkResult<std::fstream>()> f);
-
-#if defined(NEKO_IMPORT_THREAD_BUS)
-    // BusThreadExecutor template instantiations
-    template std::future<NetworkResult<std::string>> executor::BusThreadExecutor::submitImpl(std::function<NetworkResult<std::string>()> f);
-    template std::future<NetworkResult<std::vector<char>>> executor::BusThreadExecutor::submitImpl(std::function<NetworkResult<std::vector<char>>()> f);
-    template std::future<NetworkResult<std::fstream>> executor::BusThreadExecutor::submitImpl(std::function<NetworkResult<std::fstream>()> f);
-#endif
+    template std::future<NetworkResult<std::string>> Network::executeWithRetryAsync(const RetryConfig &);
+    template std::future<NetworkResult<std::vector<char>>> Network::executeWithRetryAsync(const RetryConfig &);
+    template std::future<NetworkResult<std::fstream>> Network::executeWithRetryAsync(const RetryConfig &);
+    template std::future<NetworkResult<PooledBuffer>> Network::executeWithRetryAsync(const RetryConfig &);
+
+    template void Network::executeWithRetryAsync<std::string>(const RetryConfig &, std::function<void(NetworkResult<std::string>)>);
+    template void Network::executeWithRetryAsync<std::vector<char>>(const RetryConfig &, std::function<void(NetworkResult<std::vector<char>>)>);
+    template void Network::executeWithRetryAsync<std::fstream>(const RetryConfig &, std::function<void(NetworkResult<std::fstream>)>);
+    template void Network::executeWithRetryAsync<PooledBuffer>(const RetryConfig &, std::function<void(NetworkResult<PooledBuffer>)>);
+
+    // Header lookup template instantiations
+    template std::optional<std::string> Network::findUrlHeader(const std::string &, const std::string &);
 
 } // namespace neko::network
@@ -7,10 +7,22 @@
  */
 
 #include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <thread>
 #include <neko/network/network.hpp>
 #include <neko/network/networkCommon.hpp>
+#include <neko/network/networkDownload.hpp>
 #include <neko/network/networkTypes.hpp>
 
+#include "../benchmarks/loopbackServer.hpp"
+
 using namespace neko::network;
 
 /**
@@ -79,6 +91,27 @@ TEST(NetworkResultTest, HasContentReturnsFalseForEmptyContent) {
     EXPECT_FALSE(result.hasContent());
 }
 
+TEST(NetworkResultTest, TimingsAreUnsetByDefault) {
+    NetworkResult<std::string> result;
+
+    EXPECT_FALSE(result.timings.has_value());
+}
+
+TEST(LatencyHistogramTest, PercentileReturnsBucketUpperBound) {
+    LatencyHistogram histogram;
+    // 90 values in [64, 128) and 10 values in [1024, 2048)
+    histogram.buckets[7] = 90;
+    histogram.buckets[11] = 10;
+    histogram.count = 100;
+    histogram.sumMicroseconds = 90 * 100 + 10 * 1500;
+    histogram.maxMicroseconds = 1500;
+
+    EXPECT_EQ(histogram.percentile(0.5).count(), 128);
+    EXPECT_EQ(histogram.percentile(0.99).count(), 1500);
+    EXPECT_EQ(histogram.mean().count(), 240);
+    EXPECT_EQ(LatencyHistogram().percentile(0.5).count(), 0);
+}
+
 TEST(NetworkResultTest, SetErrorSetsErrorStateCorrectly) {
     NetworkResult<std::string> result;
     result.setError("Test error", "Detailed test error");
@@ -88,6 +121,45 @@ TEST(NetworkResultTest, SetErrorSetsErrorStateCorrectly) {
     EXPECT_EQ(result.detailedErrorMessage, "Detailed test error");
 }
 
+// ============================================================================
+// HeaderMap tests
+// ============================================================================
+
+TEST(HeaderMapTest, LookupIsCaseInsensitive) {
+    HeaderMap headers{{"Content-Type", "application/json"}, {"Set-Cookie", "a=1"}};
+    headers.add("set-cookie", "b=2");
+
+    EXPECT_EQ(headers.get("content-type").value_or(""), "application/json");
+    EXPECT_TRUE(headers.contains("CONTENT-TYPE"));
+    EXPECT_FALSE(headers.contains("Content"));
+    EXPECT_EQ(headers.getAll("Set-Cookie"), (std::vector<std::string_view>{"a=1", "b=2"}));
+
+    headers.set("SET-COOKIE", "c=3");
+    EXPECT_EQ(headers.getAll("set-cookie"), (std::vector<std::string_view>{"c=3"}));
+    EXPECT_EQ(headers.remove("Content-Type"), 1u);
+    EXPECT_EQ(headers.size(), 1u);
+}
+
+TEST(HeaderMapTest, ParseSkipsStatusLineAndTrimsValues) {
+    auto headers = HeaderMap::parse("HTTP/1.1 200 OK\r\nContent-Length:  42 \r\nETag: \"v1\"\r\n\r\n");
+
+    EXPECT_EQ(headers.size(), 2u);
+    EXPECT_EQ(headers.get("content-length").value_or(""), "42");
+    EXPECT_EQ(headers.get("etag").value_or(""), "\"v1\"");
+
+    std::vector<std::string> lines;
+    headers.forEachLine([&lines](const std::string &line) { lines.push_back(line); });
+    EXPECT_EQ(lines, (std::vector<std::string>{"Content-Length: 42", "ETag: \"v1\""}));
+}
+
+TEST(HeaderMapTest, FieldsWithLineBreaksAreIgnored) {
+    HeaderMap headers;
+    headers.add("X-Injected", "a\r\nX-Evil: 1").add("X-Bad\n", "b").add("X-Good", "c");
+    headers.set("X-Good", "d\re");
+    EXPECT_EQ(headers.size(), 1u);
+    EXPECT_EQ(headers.get("X-Good"), "c");
+}
+
 // ============================================================================
 // RequestConfig tests
 // ============================================================================
@@ -118,6 +190,164 @@ TEST(RequestConfigTest, CanSetCustomValues) {
     EXPECT_EQ(config.postData, "{\"key\":\"value\"}");
 }
 
+TEST_F(NetworkTest, ChunkCallbackStreamsTheBody) {
+    bench::LoopbackServer server(0);
+    constexpr neko::uint64 size = 1024 * 1024;
+    RequestConfig config;
+    EXPECT_FALSE(config.chunkCallback);
+    config.url = server.url("/bytes/" + std::to_string(size));
+
+    int chunks = 0;
+    neko::uint64 received = 0, announced = 0;
+    config.chunkCallback = [&](std::string_view chunk) {
+        ++chunks;
+        received += chunk.size();
+        return true;
+    };
+    config.contentLengthCallback = [&announced](neko::uint64 length) { announced = length; };
+    auto result = network->execute(config);
+    EXPECT_EQ(result.statusCode, 200);
+    EXPECT_GT(chunks, 1);
+    EXPECT_EQ(received, size);
+    EXPECT_EQ(announced, size);
+    EXPECT_TRUE(result.content.empty());
+
+    // Streamed responses are neither cached nor shared
+    network->setResponseCache(ResponseCacheOptions{});
+    network->setRequestCoalescing(true);
+    config.url = server.url("/cached/60");
+    neko::uint64 before = server.requests();
+    EXPECT_FALSE(network->execute(config).fromCache);
+    EXPECT_FALSE(network->execute(config).fromCache);
+    EXPECT_EQ(server.requests() - before, 2u);
+
+    config.url = server.url("/slow/200");
+    before = server.requests();
+    std::vector<std::future<NetworkResult<std::string>>> futures;
+    for (int i = 0; i < 4; ++i) {
+        futures.push_back(std::async(std::launch::async, [this, &config]() { return network->execute(config); }));
+    }
+    for (auto &future : futures) {
+        EXPECT_FALSE(future.get().coalesced);
+    }
+    EXPECT_EQ(server.requests() - before, 4u);
+    EXPECT_EQ(network->metrics().coalesced, 0u);
+
+    // Returning false aborts the transfer
+    config.url = server.url("/bytes/" + std::to_string(size));
+    config.chunkCallback = [](std::string_view) { return false; };
+    result = network->execute(config);
+    EXPECT_TRUE(result.hasError);
+    EXPECT_EQ(result.errorMessage, "Transfer aborted by chunkCallback");
+}
+
+TEST(RequestConfigTest, CompressionDefaults) {
+    RequestConfig config;
+    EXPECT_TRUE(config.acceptEncoding);
+    EXPECT_FALSE(config.compressPostData);
+}
+
+TEST_F(NetworkTest, CompressedResponsesAreDecoded) {
+    bench::LoopbackServer server(0);
+    RequestConfig config;
+    config.url = server.url("/gzip");
+
+    auto result = network->execute(config);
+    ASSERT_EQ(result.statusCode, 200);
+    EXPECT_EQ(result.headers.get("Content-Encoding"), "gzip");
+    EXPECT_EQ(result.content, bench::LoopbackServer::gzipBody);
+
+    config.acceptEncoding = false;
+    result = network->execute(config);
+    EXPECT_FALSE(result.headers.contains("Content-Encoding"));
+    EXPECT_EQ(result.content, bench::LoopbackServer::gzipBody);
+}
+
+TEST_F(NetworkTest, CompressPostDataSendsGzip) {
+    bench::LoopbackServer server(0);
+    RequestConfig config;
+    config.url = server.url("/echo");
+    config.method = RequestType::Post;
+    for (int i = 0; i < 1000; ++i) {
+        config.postData += "{\"key\":\"value " + std::to_string(i % 10) + "\"},";
+    }
+    config.compressPostData = true;
+
+    auto result = network->execute(config);
+    ASSERT_EQ(result.statusCode, 200);
+    auto received = HeaderMap::parse(result.content);
+#if defined(NEKO_NETWORK_USE_ZLIB)
+    EXPECT_EQ(received.get("Content-Encoding"), "gzip");
+    EXPECT_LT(server.requestBodyBytes(), config.postData.size() / 4);
+    EXPECT_EQ(received.get("Content-Length"), std::to_string(server.requestBodyBytes()));
+#else
+    // Built without zlib: sent unchanged
+    EXPECT_FALSE(received.contains("Content-Encoding"));
+    EXPECT_EQ(server.requestBodyBytes(), config.postData.size());
+#endif
+}
+
+TEST(RequestConfigTest, TimeoutsAndCancellationAreUnsetByDefault) {
+    RequestConfig config;
+    EXPECT_EQ(config.timeout.count(), 0);
+    EXPECT_EQ(config.connectTimeout.count(), 0);
+    EXPECT_EQ(config.lowSpeedLimit, 0u);
+    EXPECT_FALSE(config.deadline.has_value());
+    EXPECT_EQ(config.cancellation, nullptr);
+    EXPECT_FALSE(BatchOptions{}.cancelOnError);
+}
+
+TEST(CancellationTokenTest, CancelRunsCallbacksOnceAndReachesChildren) {
+    auto parent = std::make_shared<CancellationToken>();
+    auto child = std::make_shared<CancellationToken>(std::vector<std::shared_ptr<CancellationToken>>{parent, nullptr});
+
+    int calls = 0;
+    child->subscribe([&calls]() { ++calls; });
+    auto removed = child->subscribe([&calls]() { calls += 100; });
+    child->unsubscribe(removed);
+
+    parent->cancel();
+    parent->cancel();
+    EXPECT_TRUE(parent->isCancelled());
+    EXPECT_TRUE(child->isCancelled());
+    EXPECT_EQ(calls, 1);
+
+    // Subscribing to a cancelled token runs the callback at once
+    EXPECT_EQ(child->subscribe([&calls]() { ++calls; }), 0u);
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(CancellationTokenTest, CallbacksMayUnsubscribeAndDestroyTokens) {
+    auto parent = std::make_shared<CancellationToken>();
+    auto child = std::make_shared<CancellationToken>(std::vector<std::shared_ptr<CancellationToken>>{parent});
+
+    // Destroying the child unsubscribes it from the parent whose callback is running
+    int calls = 0;
+    std::size_t later = 0;
+    parent->subscribe([&]() {
+        child.reset();
+        parent->unsubscribe(later);
+        ++calls;
+    });
+    later = parent->subscribe([&calls]() { calls += 100; });
+    parent->cancel();
+    EXPECT_EQ(child, nullptr);
+    EXPECT_EQ(calls, 1);
+
+    // Unsubscribing on another thread waits for the running callback
+    CancellationToken token;
+    std::atomic<bool> finished{false};
+    auto id = token.subscribe([&finished]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        finished = true;
+    });
+    std::thread canceller([&token]() { token.cancel(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    token.unsubscribe(id);
+    EXPECT_TRUE(finished.load());
+    canceller.join();
+}
+
 // ============================================================================
 // RetryConfig tests
 // ============================================================================
@@ -130,6 +360,12 @@ TEST(RetryConfigTest, DefaultValuesAreSetCorrectly) {
     EXPECT_EQ(config.successCodes.size(), 2);
     EXPECT_EQ(config.successCodes[0], 200);
     EXPECT_EQ(config.successCodes[1], 204);
+    EXPECT_DOUBLE_EQ(config.backoffMultiplier, 2.0);
+    EXPECT_TRUE(config.jitter);
+    EXPECT_TRUE(config.honorRetryAfter);
+    EXPECT_FALSE(config.hedge);
+    EXPECT_NE(std::find(config.retryableCodes.begin(), config.retryableCodes.end(), 503), config.retryableCodes.end());
+    EXPECT_EQ(std::find(config.retryableCodes.begin(), config.retryableCodes.end(), 404), config.retryableCodes.end());
 }
 
 TEST(RetryConfigTest, CanSetCustomRetryValues) {
@@ -155,6 +391,8 @@ TEST(MultiDownloadConfigTest, DefaultValuesAreSetCorrectly) {
     EXPECT_EQ(config.successCodes.size(), 2);
     EXPECT_EQ(config.successCodes[0], 200);
     EXPECT_EQ(config.successCodes[1], 206);
+    EXPECT_EQ(config.writeMode, MultiDownloadConfig::WriteMode::Direct);
+    EXPECT_FALSE(config.config.writeOffset.has_value());
 }
 
 TEST(MultiDownloadConfigTest, CanSetThreadApproach) {
@@ -175,6 +413,26 @@ TEST(MultiDownloadConfigTest, CanSetSizeApproach) {
     EXPECT_EQ(config.segmentParam, 1024 * 1024 * 10);
 }
 
+TEST(MultiDownloadConfigTest, CanSetAdaptiveApproach) {
+    MultiDownloadConfig config;
+    EXPECT_EQ(config.maxConnectionsPerHost, 8);
+
+    config.approach = MultiDownloadConfig::Adaptive;
+    config.segmentParam = 4;
+    config.maxConnectionsPerHost = 2;
+
+    EXPECT_EQ(config.approach, MultiDownloadConfig::Adaptive);
+    EXPECT_EQ(config.segmentParam, 4);
+    EXPECT_EQ(config.maxConnectionsPerHost, 2);
+}
+
+TEST(MultiDownloadConfigTest, CanSelectTempFilesWriteMode) {
+    MultiDownloadConfig config;
+    config.writeMode = MultiDownloadConfig::WriteMode::TempFiles;
+
+    EXPECT_EQ(config.writeMode, MultiDownloadConfig::TempFiles);
+}
+
 // ============================================================================
 // NetConfig tests
 // ============================================================================
@@ -200,6 +458,17 @@ TEST(NetConfigTest, CanSetAndGetProtocol) {
     EXPECT_EQ(config.getProtocol(), "https");
 }
 
+TEST(NetConfigTest, CanSetAndGetHttpVersion) {
+    config::NetConfig config;
+    EXPECT_EQ(config.getHttpVersion(), HttpVersion::Default);
+
+    config.setHttpVersion(HttpVersion::Http2Tls);
+    EXPECT_EQ(config.getHttpVersion(), HttpVersion::Http2Tls);
+
+    config.clear();
+    EXPECT_EQ(config.getHttpVersion(), HttpVersion::Default);
+}
+
 TEST(NetConfigTest, CanSetAndGetAvailableHostList) {
     config::NetConfig config;
     std::vector<std::string> hosts = {"host1.example.com", "host2.example.com"};
@@ -214,6 +483,27 @@ TEST(NetConfigTest, GetAvailableHostReturnsEmptyForEmptyList) {
     EXPECT_TRUE(config.getAvailableHost().empty());
 }
 
+TEST(NetConfigTest, VersionChangesOnEveryModification) {
+    config::NetConfig config;
+    auto version = config.getVersion();
+
+    config.setUserAgent("Test User Agent");
+    EXPECT_NE(config.getVersion(), version);
+    version = config.getVersion();
+
+    config.pushAvailableHost("host1.example.com");
+    EXPECT_NE(config.getVersion(), version);
+    version = config.getVersion();
+
+    config.clear();
+    EXPECT_NE(config.getVersion(), version);
+    version = config.getVersion();
+
+    // Reads do not change the version
+    config.getUserAgent();
+    EXPECT_EQ(config.getVersion(), version);
+}
+
 // ============================================================================
 // Network basic tests
 // ============================================================================
@@ -244,6 +534,892 @@ TEST_F(NetworkTest, ExecuteWithEmptyUrlReturnsError) {
     EXPECT_FALSE(result.isSuccess());
 }
 
+TEST_F(NetworkTest, HandlePoolCapacityCanBeConfigured) {
+    EXPECT_EQ(network->getMaxPooledHandles(), 16);
+
+    network->setMaxPooledHandles(4).setMaxPooledHandles(0);
+    EXPECT_EQ(network->getMaxPooledHandles(), 0);
+
+    // Requests still work without pooling
+    RequestConfig config;
+    config.url = "";
+    auto result = network->execute(config);
+    EXPECT_TRUE(result.hasError);
+}
+
+TEST_F(NetworkTest, ShareScopeCanBeSwitched) {
+    EXPECT_EQ(network->getShareScope(), ShareScope::None);
+
+    network->setShareScope(ShareScope::Instance, true);
+    EXPECT_EQ(network->getShareScope(), ShareScope::Instance);
+
+    // Concurrent requests through one share, then switch while nothing is running
+    std::vector<std::future<NetworkResult<std::string>>> futures;
+    for (int i = 0; i < 8; ++i) {
+        RequestConfig config;
+        config.url = "http://127.0.0.1:1/"; // Connection refused
+        futures.push_back(network->executeAsync(config));
+    }
+    for (auto &future : futures) {
+        EXPECT_TRUE(future.get().hasError);
+    }
+
+    network->setShareScope(ShareScope::Process);
+    EXPECT_EQ(network->getShareScope(), ShareScope::Process);
+    network->setShareScope(ShareScope::None);
+    EXPECT_EQ(network->getShareScope(), ShareScope::None);
+}
+
+TEST_F(NetworkTest, CachedDefaultsCanBeInvalidated) {
+    RequestConfig config;
+    config.url = "invalid-url";
+
+    // Requests keep working across a globalConfig change and an explicit invalidation
+    EXPECT_TRUE(network->execute(config).hasError);
+    auto userAgent = config::globalConfig.getUserAgent();
+    config::globalConfig.setUserAgent("NekoNet Cache Test");
+    EXPECT_TRUE(network->execute(config).hasError);
+    network->invalidateCachedDefaults();
+    EXPECT_TRUE(network->execute(config).hasError);
+    config::globalConfig.setUserAgent(userAgent);
+}
+
+TEST_F(NetworkTest, DiagnosticsModeControlsErrorDetails) {
+    EXPECT_EQ(network->getDiagnosticsMode(), DiagnosticsMode::OnError);
+
+    RequestConfig config;
+    config.url = "http://127.0.0.1:1/"; // Connection refused
+
+    // OnError keeps at most the budget worth of verbose text
+    network->setDiagnosticsMode(DiagnosticsMode::OnError, 32);
+    auto bounded = network->execute(config);
+    EXPECT_TRUE(bounded.hasError);
+    EXPECT_LT(bounded.detailedErrorMessage.size(), 128);
+
+    // Off does not capture anything
+    config.diagnostics = DiagnosticsMode::Off;
+    auto off = network->execute(config);
+    EXPECT_TRUE(off.hasError);
+    EXPECT_TRUE(off.detailedErrorMessage.empty());
+
+    // The per-request mode overrides the Network default
+    network->setDiagnosticsMode(DiagnosticsMode::Off);
+    config.diagnostics = DiagnosticsMode::Full;
+    auto full = network->execute(config);
+    EXPECT_TRUE(full.hasError);
+    EXPECT_NE(full.detailedErrorMessage.find("[Debug]"), std::string::npos);
+}
+
+TEST_F(NetworkTest, TimingsAreReportedForFailedTransfers) {
+    RequestConfig config;
+    config.url = "http://127.0.0.1:1/"; // Connection refused
+
+    auto result = network->execute(config);
+
+    EXPECT_TRUE(result.hasError);
+    ASSERT_TRUE(result.timings.has_value());
+    EXPECT_FALSE(result.timings->connectionReused);
+    EXPECT_EQ(result.timings->bytesDownloaded, 0);
+    EXPECT_LE(result.timings->nameLookup, result.timings->total);
+}
+
+TEST_F(NetworkTest, EveryHttpVersionPreferenceIsAccepted) {
+    for (auto version : {HttpVersion::Http1_1, HttpVersion::Http2, HttpVersion::Http2Tls,
+                         HttpVersion::Http2PriorKnowledge, HttpVersion::Http3}) {
+        RequestConfig config;
+        config.url = "http://127.0.0.1:1/"; // Connection refused
+        config.httpVersion = version;
+
+        auto result = network->execute(config);
+
+        // Fails on the connection, not on an unsupported option
+        EXPECT_TRUE(result.hasError);
+        ASSERT_TRUE(result.timings.has_value());
+        EXPECT_TRUE(result.timings->httpVersion.empty());
+    }
+}
+
+TEST_F(NetworkTest, MetricsCountRequestsByTypeAndHost) {
+    RequestConfig config;
+    config.url = "http://User@LocalHost:1/path?q=1"; // Connection refused
+
+    network->execute(config);
+    network->setAsyncEngine(AsyncEngine::Multi);
+    network->executeAsync(config).get();
+
+    auto snapshot = network->metrics();
+    EXPECT_EQ(snapshot.byType(RequestType::Get).inFlight, 0);
+    EXPECT_EQ(snapshot.byType(RequestType::Get).failed, 2);
+    EXPECT_EQ(snapshot.byType(RequestType::Get).completed, 0);
+    EXPECT_EQ(snapshot.byType(RequestType::Post).failed, 0);
+
+    ASSERT_EQ(snapshot.hosts.count("localhost:1"), 1);
+    const auto &host = snapshot.hosts.at("localhost:1");
+    EXPECT_EQ(host.requests, 2);
+    EXPECT_EQ(host.failures, 2);
+    EXPECT_EQ(host.latency.count, 2);
+
+    network->resetMetrics();
+    snapshot = network->metrics();
+    EXPECT_EQ(snapshot.byType(RequestType::Get).failed, 0);
+    EXPECT_EQ(snapshot.hosts.at("localhost:1").requests, 0);
+}
+
+TEST_F(NetworkTest, RetriesAreCounted) {
+    RetryConfig retryConfig;
+    retryConfig.config.url = "http://127.0.0.1:1/";
+    retryConfig.maxRetries = 3;
+    retryConfig.retryDelay = std::chrono::milliseconds(1);
+
+    network->executeWithRetry(retryConfig);
+
+    auto snapshot = network->metrics();
+    EXPECT_EQ(snapshot.retries, 2);
+    EXPECT_EQ(snapshot.byType(RequestType::Get).failed, 3);
+}
+
+TEST_F(NetworkTest, RetryBudgetLimitsRetries) {
+    // One token saved up, none earned afterwards
+    network->setRetryBudget(RetryBudget{0.0, 0.0, 1.0});
+    ASSERT_TRUE(network->getRetryBudget().has_value());
+
+    RetryConfig retryConfig;
+    retryConfig.config.url = "http://127.0.0.1:1/";
+    retryConfig.maxRetries = 3;
+    retryConfig.retryDelay = std::chrono::milliseconds(1);
+
+    network->executeWithRetry(retryConfig);
+    network->executeWithRetry(retryConfig);
+    EXPECT_EQ(network->metrics().retries, 1);
+
+    network->setRetryBudget(std::nullopt);
+    EXPECT_FALSE(network->getRetryBudget().has_value());
+}
+
+TEST_F(NetworkTest, ExecuteWithRetryAsyncRetriesWithoutBlocking) {
+    RetryConfig retryConfig;
+    retryConfig.config.url = "http://127.0.0.1:1/";
+    retryConfig.maxRetries = 3;
+    retryConfig.retryDelay = std::chrono::milliseconds(1);
+
+    auto result = network->executeWithRetryAsync(retryConfig).get();
+    EXPECT_TRUE(result.hasError);
+    EXPECT_EQ(result.errorMessage, "All retry attempts failed");
+    EXPECT_EQ(network->metrics().retries, 2);
+}
+
+TEST_F(NetworkTest, RetryAfterIsHonoredAndClientErrorsAreNotRetried) {
+    bench::LoopbackServer server(0);
+    RetryConfig retryConfig;
+    retryConfig.config.url = server.url("/status/503"); // Retry-After: 1
+    retryConfig.maxRetries = 2;
+    retryConfig.retryDelay = std::chrono::milliseconds(1);
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = network->executeWithRetry(retryConfig);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    EXPECT_EQ(result.statusCode, 503);
+    EXPECT_EQ(result.errorMessage, "All retry attempts failed");
+    EXPECT_EQ(server.requests(), 2u);
+
+    retryConfig.honorRetryAfter = false;
+    start = std::chrono::steady_clock::now();
+    network->executeWithRetry(retryConfig);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    EXPECT_EQ(server.requests(), 4u);
+
+    // Retry-After beyond maxDelay ends the retries
+    retryConfig.honorRetryAfter = true;
+    retryConfig.maxDelay = std::chrono::milliseconds(500);
+    network->executeWithRetry(retryConfig);
+    EXPECT_EQ(server.requests(), 5u);
+
+    retryConfig.config.url = server.url("/status/404");
+    retryConfig.maxRetries = 3;
+    result = network->executeWithRetry(retryConfig);
+    EXPECT_EQ(result.statusCode, 404);
+    EXPECT_EQ(server.requests(), 6u);
+    EXPECT_EQ(network->metrics().retries, 2u);
+}
+
+TEST_F(NetworkTest, HedgedRequestReturnsTheFasterCopy) {
+    bench::LoopbackServer server(0);
+    RetryConfig retryConfig;
+    retryConfig.config.url = server.url("/first-slow/5000");
+    retryConfig.maxRetries = 1;
+    retryConfig.hedge = true;
+    retryConfig.hedgeDelay = std::chrono::milliseconds(100);
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = network->executeWithRetry(retryConfig);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    EXPECT_EQ(result.statusCode, 200);
+    EXPECT_EQ(result.content, "response 2"); // The copy sent after 100ms
+
+    // The first copy is cancelled and hangs up long before its response is due
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (server.abandoned() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(server.abandoned(), 1u);
+    EXPECT_EQ(server.requests(), 2u);
+}
+
+TEST_F(NetworkTest, CircuitBreakerOpensForFailingHost) {
+    HostPolicy policy;
+    policy.minRequests = 3;
+    policy.openDuration = std::chrono::minutes(1);
+    network->setHostPolicy(policy);
+
+    RequestConfig config;
+    config.url = "http://127.0.0.1:1/"; // Connection refused
+    for (int i = 0; i < 10; ++i) {
+        network->execute(config);
+    }
+
+    auto health = network->hostHealth("127.0.0.1:1");
+    EXPECT_EQ(health.circuit, CircuitState::Open);
+    EXPECT_GT(health.errorRate, policy.failureThreshold);
+
+    auto result = network->executeAsync(config).get();
+    EXPECT_EQ(result.errorMessage, "Circuit breaker open");
+
+    // Disabling the policy closes every circuit
+    network->setHostPolicy(std::nullopt);
+    EXPECT_EQ(network->hostHealth("127.0.0.1:1").circuit, CircuitState::Closed);
+    EXPECT_NE(network->execute(config).errorMessage, "Circuit breaker open");
+}
+
+TEST_F(NetworkTest, SelectHostAvoidsOpenCircuits) {
+    EXPECT_TRUE(network->selectHost(std::vector<std::string>{}).empty());
+    EXPECT_EQ(network->selectHost({"only.example.com"}), "only.example.com");
+
+    HostPolicy policy;
+    policy.minRequests = 3;
+    policy.openDuration = std::chrono::minutes(1);
+    network->setHostPolicy(policy);
+
+    RequestConfig config;
+    config.url = "http://127.0.0.1:1/";
+    for (int i = 0; i < 5; ++i) {
+        network->execute(config);
+    }
+
+    std::vector<std::string> hosts = {"127.0.0.1:1", "mirror.invalid"};
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(network->selectHost(hosts), "mirror.invalid");
+    }
+}
+
+TEST_F(NetworkTest, ResponseCacheSkipsFailedResponses) {
+    EXPECT_TRUE(RequestConfig{}.useCache);
+    EXPECT_FALSE(NetworkResult<std::string>{}.fromCache);
+
+    ResponseCacheOptions options;
+    options.shards = 0; // Treated as one shard
+    network->setResponseCache(options);
+
+    RequestConfig config;
+    config.url = "http://127.0.0.1:1/";
+    for (int i = 0; i < 3; ++i) {
+        auto result = network->execute(config);
+        EXPECT_TRUE(result.hasError);
+        EXPECT_FALSE(result.fromCache);
+    }
+    EXPECT_FALSE(network->executeAsync(config).get().fromCache);
+
+    auto snapshot = network->metrics();
+    EXPECT_EQ(snapshot.cacheHits, 0);
+    EXPECT_EQ(snapshot.cacheMisses, 4);
+
+    // Requests that opt out or are not Get do not touch the cache
+    config.useCache = false;
+    network->execute(config);
+    config.useCache = true;
+    config.method = RequestType::Post;
+    network->execute(config);
+    EXPECT_EQ(network->metrics().cacheMisses, 4);
+
+    network->clearResponseCache();
+    network->setResponseCache(std::nullopt);
+    config.method = RequestType::Get;
+    network->execute(config);
+    EXPECT_EQ(network->metrics().cacheMisses, 4);
+}
+
+TEST_F(NetworkTest, ResponseCacheServesFreshResponsesAndRevalidates) {
+    bench::LoopbackServer server(0);
+    network->setResponseCache(ResponseCacheOptions{});
+
+    // Fresh for a minute: the second request never reaches the server
+    RequestConfig fresh;
+    fresh.url = server.url("/cached/60");
+    EXPECT_FALSE(network->execute(fresh).fromCache);
+    auto hit = network->execute(fresh);
+    EXPECT_TRUE(hit.fromCache);
+    EXPECT_EQ(hit.content, "cached body");
+    EXPECT_EQ(server.requests(), 1u);
+    EXPECT_EQ(network->metrics().cacheHits, 1u);
+
+    // Stale at once: revalidated with the ETag, the 304 replaces every stored Link and adds its fields
+    RequestConfig stale;
+    stale.url = server.url("/cached/0");
+    EXPECT_FALSE(network->execute(stale).fromCache);
+    auto revalidated = network->execute(stale);
+    EXPECT_EQ(server.requests(), 3u);
+    EXPECT_TRUE(revalidated.fromCache);
+    EXPECT_EQ(revalidated.statusCode, 200);
+    EXPECT_EQ(revalidated.content, "cached body");
+    EXPECT_EQ(revalidated.headers.getAll("Link"), (std::vector<std::string_view>{"</a>; rel=a", "</b>; rel=b"}));
+    EXPECT_EQ(revalidated.headers.get("X-Revalidated"), "yes");
+    EXPECT_EQ(revalidated.headers.get("Content-Length"), "11"); // Describes the stored body, kept
+    EXPECT_EQ(network->metrics().cacheRevalidated, 1u);
+
+    // Requests with other headers do not share an entry
+    RequestConfig alice = fresh;
+    alice.headers.set("Authorization", "Bearer alice");
+    RequestConfig bob = fresh;
+    bob.headers.set("Authorization", "Bearer bob");
+    EXPECT_FALSE(network->execute(alice).fromCache);
+    EXPECT_FALSE(network->execute(bob).fromCache);
+    EXPECT_TRUE(network->execute(alice).fromCache);
+    EXPECT_EQ(server.requests(), 5u);
+}
+
+TEST_F(NetworkTest, ResponseCacheEvictsLeastRecentlyUsed) {
+    bench::LoopbackServer server(0);
+    // Each entry holds its key, so the padding sets its size: two entries fit, three do not
+    const std::string padding(4000, 'x');
+    ResponseCacheOptions options;
+    options.shards = 1;
+    options.maxBytes = 2 * padding.size() + 3000;
+    network->setResponseCache(options);
+
+    auto fetch = [&](char name) {
+        RequestConfig config;
+        config.url = server.url("/cached/60?" + std::string(1, name) + padding);
+        return network->execute(config).fromCache;
+    };
+    EXPECT_FALSE(fetch('a'));
+    EXPECT_FALSE(fetch('b'));
+    EXPECT_TRUE(fetch('a')); // Now the most recently used
+    EXPECT_FALSE(fetch('c')); // Evicts b
+    EXPECT_TRUE(fetch('a'));
+    EXPECT_TRUE(fetch('c'));
+    EXPECT_FALSE(fetch('b'));
+    EXPECT_EQ(server.requests(), 4u);
+}
+
+TEST_F(NetworkTest, RequestCoalescingSharesConcurrentResults) {
+    EXPECT_FALSE(network->getRequestCoalescing());
+    network->setRequestCoalescing(true);
+    EXPECT_TRUE(network->getRequestCoalescing());
+
+    // The server holds the response long enough for every request to join the first one
+    bench::LoopbackServer server(0);
+    RequestConfig config;
+    config.url = server.url("/slow/300");
+    constexpr int requests = 8;
+    std::vector<std::future<NetworkResult<std::string>>> futures;
+    for (int i = 0; i < requests; ++i) {
+        futures.push_back(std::async(std::launch::async, [this, &config]() { return network->execute(config); }));
+    }
+    int followers = 0;
+    for (auto &future : futures) {
+        auto result = future.get();
+        EXPECT_EQ(result.statusCode, 200);
+        EXPECT_EQ(result.content, "response 1"); // The leader's body
+        followers += result.coalesced ? 1 : 0;
+    }
+    EXPECT_EQ(server.requests(), 1u);
+    EXPECT_EQ(followers, requests - 1);
+    EXPECT_EQ(network->metrics().coalesced, static_cast<neko::uint64>(requests - 1));
+
+    // A progress callback keeps the request on its own
+    config.progressCallback = [](neko::uint64) {};
+    EXPECT_FALSE(network->execute(config).coalesced);
+    EXPECT_EQ(server.requests(), 2u);
+}
+
+TEST_F(NetworkTest, HostRateLimitDelaysRequests) {
+    HostPolicy policy;
+    policy.requestsPerSecond = 20;
+    policy.burst = 1;
+    network->setHostPolicy(policy);
+
+    RequestConfig config;
+    config.url = "http://127.0.0.1:1/";
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 5; ++i) {
+        network->execute(config);
+    }
+    // The first request uses the burst, the other four wait 50ms each
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(180));
+}
+
+TEST_F(NetworkTest, AdaptiveDownloadFailsWithoutFileSize) {
+    MultiDownloadConfig config;
+    config.config.url = "http://127.0.0.1:1/file.bin"; // Connection refused
+    config.config.fileName = "adaptive_test_output.bin";
+    config.approach = MultiDownloadConfig::Adaptive;
+
+    EXPECT_FALSE(network->multiThreadedDownload(config));
+    EXPECT_FALSE(std::filesystem::exists(config.config.fileName));
+}
+
+TEST_F(NetworkTest, ResumableMultiDownloadFailsWithoutLeavingManifest) {
+    MultiDownloadConfig config;
+    config.config.url = "http://127.0.0.1:1/file.bin"; // Connection refused
+    config.config.fileName = "resumable_test_output.bin";
+    config.config.resumable = true;
+
+    EXPECT_FALSE(network->multiThreadedDownload(config));
+    EXPECT_FALSE(std::filesystem::exists(config.config.fileName + ".nekopart"));
+}
+
+namespace {
+    // The first size body bytes the loopback server sends for /bytes/<n> and /object
+    std::string loopbackBytes(std::size_t size) {
+        std::string data(size, '\0');
+        for (std::size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>(((i % (1024 * 1024)) * 31 + 7) & 0xff);
+        }
+        return data;
+    }
+
+    // Whether fileName holds the loopback server's object of the given size
+    bool matchesLoopbackObject(const std::string &fileName, neko::uint64 size) {
+        std::ifstream in(fileName, std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (data.size() != size)
+            return false;
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            if (data[i] != static_cast<char>(((i % (1024 * 1024)) * 31 + 7) & 0xff))
+                return false;
+        }
+        return true;
+    }
+
+    // Bytes recorded as written in a .nekopart manifest
+    neko::uint64 manifestDoneBytes(const std::string &path) {
+        std::ifstream in(path);
+        neko::uint64 done = 0;
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string key;
+            neko::uint64 begin = 0, end = 0;
+            if (fields >> key >> begin >> end && key == "done")
+                done += end - begin;
+        }
+        return done;
+    }
+} // namespace
+
+TEST_F(NetworkTest, AdaptiveDownloadStealsFromStragglers) {
+    // The range at byte 0 trickles; without stealing it alone would take about 6 seconds
+    constexpr neko::uint64 size = 4 * 1024 * 1024 + 12345;
+    bench::LoopbackServer server(size);
+    MultiDownloadConfig config;
+    config.config.url = server.url("/straggler");
+    config.config.fileName = (std::filesystem::temp_directory_path() / "neko_adaptive_test.bin").string();
+    config.approach = MultiDownloadConfig::Adaptive;
+    config.segmentParam = 4;
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(network->multiThreadedDownload(config));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(4));
+    EXPECT_TRUE(matchesLoopbackObject(config.config.fileName, size));
+    // The straggler's own bytes, past where it was cut, may have been sent as well
+    EXPECT_GE(server.bodyBytes(), size);
+    std::filesystem::remove(config.config.fileName);
+}
+
+TEST_F(NetworkTest, InterruptedDownloadResumesFromManifest) {
+    constexpr neko::uint64 size = 4 * 1024 * 1024;
+    for (auto approach : {MultiDownloadConfig::Adaptive, MultiDownloadConfig::Size}) {
+        SCOPED_TRACE(approach);
+        bench::LoopbackServer server(size);
+        // Two segments at a time, so some complete before the cancel
+        Network limited(std::make_shared<executor::ThreadPoolExecutor>(2));
+
+        MultiDownloadConfig config;
+        config.config.url = server.url("/object");
+        config.config.fileName = (std::filesystem::temp_directory_path() / "neko_resume_test.bin").string();
+        config.config.resumable = true;
+        config.approach = approach;
+        config.segmentParam = approach == MultiDownloadConfig::Adaptive ? 2 : 512 * 1024;
+        const std::string manifest = config.config.fileName + ".nekopart";
+        std::filesystem::remove(manifest);
+
+        // Interrupted at about half, the limiter keeps the transfer slow enough to cancel it midway
+        MultiDownloadConfig interrupted = config;
+        interrupted.config.bandwidthLimiter = std::make_shared<BandwidthLimiter>(2 * 1024 * 1024);
+        interrupted.config.cancellation = std::make_shared<CancellationToken>();
+        interrupted.config.progressCallback = [token = interrupted.config.cancellation](neko::uint64 bytes) {
+            if (bytes >= size / 2)
+                token->cancel();
+        };
+        EXPECT_FALSE(limited.multiThreadedDownload(interrupted));
+        ASSERT_TRUE(std::filesystem::exists(manifest));
+        neko::uint64 done = manifestDoneBytes(manifest);
+        EXPECT_GT(done, 0u);
+        EXPECT_LT(done, size);
+
+        // One worker or segment per missing range, so nothing is fetched twice
+        if (approach == MultiDownloadConfig::Adaptive)
+            config.segmentParam = 1;
+        neko::uint64 sentBefore = server.bodyBytes();
+        ASSERT_TRUE(limited.multiThreadedDownload(config));
+        EXPECT_EQ(server.bodyBytes() - sentBefore, size - done);
+        EXPECT_TRUE(matchesLoopbackObject(config.config.fileName, size));
+        EXPECT_FALSE(std::filesystem::exists(manifest));
+        std::filesystem::remove(config.config.fileName);
+    }
+}
+
+TEST_F(NetworkTest, AsyncEngineDefaultsToExecutor) {
+    EXPECT_EQ(network->getAsyncEngine(), AsyncEngine::Executor);
+
+    network->setAsyncEngine(AsyncEngine::Multi, 2);
+    EXPECT_EQ(network->getAsyncEngine(), AsyncEngine::Multi);
+
+    network->setAsyncEngine(AsyncEngine::Executor);
+    EXPECT_EQ(network->getAsyncEngine(), AsyncEngine::Executor);
+}
+
+TEST_F(NetworkTest, MultiEngineReportsErrorsThroughFuture) {
+    network->setAsyncEngine(AsyncEngine::Multi);
+
+    RequestConfig config;
+    config.url = "invalid-url";
+
+    std::vector<std::future<NetworkResult<std::string>>> futures;
+    for (int i = 0; i < 8; ++i) {
+        futures.push_back(network->executeAsync(config));
+    }
+
+    for (auto &future : futures) {
+        auto result = future.get();
+        EXPECT_TRUE(result.hasError);
+        EXPECT_FALSE(result.isSuccess());
+    }
+}
+
+TEST_F(NetworkTest, MultiEngineRunsPlainHttpRequestsConcurrently) {
+    // Plain http:// cannot multiplex, so no request may wait for another's connection
+    bench::LoopbackServer server(0);
+    network->setAsyncEngine(AsyncEngine::Multi, 1);
+
+    RequestConfig config;
+    config.url = server.url("/slow/1000");
+    config.httpVersion = HttpVersion::Http2;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<NetworkResult<std::string>>> futures;
+    for (int i = 0; i < 6; ++i) {
+        futures.push_back(network->executeAsync(config));
+    }
+    for (auto &future : futures) {
+        EXPECT_EQ(future.get().statusCode, 200);
+    }
+    // Waiting for the first response before opening more connections would take at least 2 seconds
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(1500));
+    EXPECT_EQ(server.connections(), 6u);
+}
+
+TEST_F(NetworkTest, ProbeOfUnreachableHostReturnsNothing) {
+    network->setProbeCacheTtl(std::chrono::seconds(5));
+    EXPECT_EQ(network->getProbeCacheTtl(), std::chrono::seconds(5));
+
+    EXPECT_FALSE(network->probe("http://127.0.0.1:1/file").has_value());
+    EXPECT_FALSE(network->getContentSize("http://127.0.0.1:1/file").has_value());
+    EXPECT_FALSE(network->getContentType("http://127.0.0.1:1/file").has_value());
+
+    network->setProbeCacheTtl(std::chrono::milliseconds(0));
+    EXPECT_EQ(network->getProbeCacheTtl().count(), 0);
+}
+
+TEST_F(NetworkTest, ProbeReadsMetadataAndCachesIt) {
+    constexpr neko::uint64 size = 123456;
+    bench::LoopbackServer server(size);
+    network->setProbeCacheTtl(std::chrono::seconds(5));
+
+    auto info = network->probe(server.url("/object"));
+    ASSERT_TRUE(info.has_value());
+    EXPECT_EQ(info->statusCode, 200);
+    EXPECT_EQ(info->contentLength, size);
+    EXPECT_EQ(info->etag, "\"loopback-123456\"");
+    EXPECT_EQ(info->contentType, "application/octet-stream");
+    EXPECT_TRUE(info->acceptsRanges);
+    EXPECT_EQ(server.requests(), 1u);
+
+    // Within the TTL nothing is sent
+    EXPECT_EQ(network->probe(server.url("/object"))->etag, info->etag);
+    EXPECT_EQ(network->getContentSize(server.url("/object")), size);
+    EXPECT_EQ(server.requests(), 1u);
+
+    network->clearProbeCache();
+    EXPECT_TRUE(network->probe(server.url("/object")).has_value());
+    EXPECT_EQ(server.requests(), 2u);
+}
+
+TEST_F(NetworkTest, ProbeFallsBackToARangeRequest) {
+    constexpr neko::uint64 size = 123456;
+    bench::LoopbackServer server(size);
+
+    // HEAD gets 405, then GET with Range: bytes=0-0 reads one byte
+    auto info = network->probe(server.url("/nohead"));
+    ASSERT_TRUE(info.has_value());
+    EXPECT_EQ(info->statusCode, 206);
+    EXPECT_EQ(info->contentLength, size);
+    EXPECT_EQ(info->headers.get("Content-Length"), std::to_string(size));
+    EXPECT_EQ(info->etag, "\"loopback-123456\"");
+    EXPECT_TRUE(info->acceptsRanges);
+    EXPECT_EQ(server.requests(), 2u);
+    EXPECT_EQ(server.bodyBytes(), 1u);
+}
+
+TEST_F(NetworkTest, UploadFileWithMissingFileReturnsError) {
+    RequestConfig config;
+    config.url = "http://127.0.0.1:1/upload";
+    config.method = RequestType::UploadFile;
+    config.fileName = "upload_test_does_not_exist.bin";
+
+    auto result = network->execute(config);
+
+    EXPECT_TRUE(result.hasError);
+    EXPECT_NE(result.detailedErrorMessage.find("Failed to open file for uploading"), std::string::npos);
+}
+
+TEST_F(NetworkTest, RequestBodySourcesAreAccepted) {
+    RequestConfig config;
+    config.url = "http://127.0.0.1:1/post"; // Connection refused
+    config.method = RequestType::Post;
+    config.body = std::make_shared<const std::string>("shared body");
+
+    auto result = network->execute(config);
+    EXPECT_TRUE(result.hasError);
+    ASSERT_TRUE(result.timings.has_value());
+
+    bool readerCalled = false;
+    config.bodyReader = [&readerCalled](neko::uint64, char *, std::size_t) {
+        readerCalled = true;
+        return std::size_t{0};
+    };
+    config.bodySize = 0;
+    result = network->execute(config);
+    EXPECT_TRUE(result.hasError);
+    EXPECT_FALSE(readerCalled); // Never connected, so nothing was read
+}
+
+TEST_F(NetworkTest, RequestBodiesReachTheServer) {
+    bench::LoopbackServer server(0);
+    constexpr std::size_t size = 300 * 1024;
+    RequestConfig config;
+    config.url = server.url("/echo");
+    config.method = RequestType::Post;
+
+    // A shared body, sent in place
+    config.body = std::make_shared<const std::string>(size, 'b');
+    EXPECT_EQ(network->execute(config).statusCode, 200);
+    EXPECT_EQ(server.requestBodyBytes(), size);
+
+    // A streamed body, with and without a known size (chunked)
+    for (bool sized : {true, false}) {
+        SCOPED_TRACE(sized);
+        std::vector<neko::uint64> offsets;
+        config.body = nullptr;
+        config.bodyReader = [&offsets](neko::uint64 offset, char *buffer, std::size_t capacity) {
+            offsets.push_back(offset);
+            std::size_t count = static_cast<std::size_t>(std::min<neko::uint64>(capacity, size - offset));
+            std::memset(buffer, 'r', count);
+            return count;
+        };
+        config.bodySize = sized ? std::optional<neko::uint64>(size) : std::nullopt;
+        neko::uint64 before = server.requestBodyBytes();
+        EXPECT_EQ(network->execute(config).statusCode, 200);
+        EXPECT_EQ(server.requestBodyBytes() - before, size);
+        ASSERT_GT(offsets.size(), 1u);
+        EXPECT_EQ(offsets.front(), 0u);
+        EXPECT_TRUE(std::is_sorted(offsets.begin(), offsets.end(), std::less_equal<>()));
+    }
+
+    // A PUT of a file, reporting the bytes sent
+    const std::string fileName = (std::filesystem::temp_directory_path() / "neko_upload_test.bin").string();
+    std::ofstream(fileName, std::ios::binary) << std::string(size, 'f');
+    RequestConfig upload;
+    upload.url = server.url("/echo");
+    upload.method = RequestType::UploadFile;
+    upload.fileName = fileName;
+    neko::uint64 reported = 0;
+    upload.progressCallback = [&reported](neko::uint64 bytes) { reported = bytes; };
+    neko::uint64 before = server.requestBodyBytes();
+    EXPECT_EQ(network->execute(upload).statusCode, 200);
+    EXPECT_EQ(server.requestBodyBytes() - before, size);
+    EXPECT_EQ(reported, size);
+    std::filesystem::remove(fileName);
+
+    // A throwing reader fails the request instead of unwinding through libcurl
+    config.bodyReader = [](neko::uint64, char *, std::size_t) -> std::size_t { throw std::runtime_error("read failed"); };
+    config.bodySize = size;
+    EXPECT_TRUE(network->execute(config).hasError);
+}
+
+TEST_F(NetworkTest, RequestHeadersReachTheServerAsSeparateFields) {
+    bench::LoopbackServer server(0);
+    RequestConfig config;
+    config.url = server.url("/echo");
+    config.header = "X-First: 1\nX-Second: 2\r\n  X-Third: 3  \n\n";
+    config.headers.add("X-Fourth", "4").add("X-Injected", "a\r\nX-Evil: 1");
+
+    auto result = network->execute(config);
+    ASSERT_EQ(result.statusCode, 200);
+    auto received = HeaderMap::parse(result.content);
+    EXPECT_EQ(received.get("X-First"), "1");
+    EXPECT_EQ(received.get("X-Second"), "2");
+    EXPECT_EQ(received.get("X-Third"), "3");
+    EXPECT_EQ(received.get("X-Fourth"), "4");
+    EXPECT_FALSE(received.contains("X-Injected"));
+    EXPECT_FALSE(received.contains("X-Evil"));
+}
+
+TEST_F(NetworkTest, ExecuteAsyncCallbackIsInvokedOnce) {
+    RequestConfig config;
+    config.url = "invalid-url";
+
+    std::promise<NetworkResult<std::string>> promise;
+    auto future = promise.get_future();
+    network->executeAsync(config, [&promise](NetworkResult<std::string> result) {
+        promise.set_value(std::move(result));
+    });
+
+    auto result = future.get();
+    EXPECT_TRUE(result.hasError);
+}
+
+TEST(NetworkLifetimeTest, DestructorWaitsForAsyncRequests) {
+    std::atomic<int> completed{0};
+    {
+        Network network(std::make_shared<executor::StdAsyncExecutor>());
+        RequestConfig config;
+        config.url = "http://127.0.0.1:1/"; // Connection refused
+        for (int i = 0; i < 4; ++i) {
+            network.executeAsync(config, [&completed](NetworkResult<std::string>) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                completed.fetch_add(1);
+            });
+        }
+        network.executeAsync(config); // Future discarded, does not block
+    }
+    EXPECT_EQ(completed.load(), 4);
+}
+
+TEST_F(NetworkTest, ExecuteAsyncTakesConfigByMove) {
+    auto body = std::make_shared<const std::string>("moved body");
+
+    RequestConfig config;
+    config.url = "http://127.0.0.1:1/post"; // Connection refused
+    config.method = RequestType::Post;
+    config.body = body;
+
+    auto future = network->executeAsync(std::move(config));
+    EXPECT_EQ(config.body, nullptr); // Taken over by the request rather than copied
+    EXPECT_TRUE(future.get().hasError);
+
+    network->setAsyncEngine(AsyncEngine::Multi, 1);
+    RequestConfig multiConfig;
+    multiConfig.url = "http://127.0.0.1:1/";
+    EXPECT_TRUE(network->executeAsync(std::move(multiConfig)).get().hasError);
+}
+
+TEST_F(NetworkTest, ExecuteBatchReturnsResultsInOrder) {
+    std::vector<RequestConfig> requests(10);
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        // Alternate between two hosts, both fail quickly
+        requests[i].url = (i % 2 == 0 ? "http://127.0.0.1:1/" : "http://127.0.0.1:2/") + std::to_string(i);
+        requests[i].requestId = std::to_string(i);
+    }
+
+    BatchOptions options;
+    options.maxConcurrency = 3;
+    options.maxPerHost = 1;
+    auto results = network->executeBatch(requests, options);
+
+    ASSERT_EQ(results.size(), requests.size());
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        EXPECT_TRUE(results[i].hasError);
+        EXPECT_NE((results[i].errorMessage + results[i].detailedErrorMessage).find("ID: " + std::to_string(i) + ","), std::string::npos);
+    }
+
+    EXPECT_TRUE(network->executeBatch(std::vector<RequestConfig>{}).empty());
+}
+
+TEST_F(NetworkTest, ExecuteBatchCallbackSeesEveryIndexOnce) {
+    network->setAsyncEngine(AsyncEngine::Multi, 2);
+
+    std::vector<RequestConfig> requests(20);
+    for (auto &request : requests) {
+        request.url = "http://127.0.0.1:1/"; // Connection refused
+    }
+
+    std::mutex mutex;
+    std::vector<int> seen(requests.size(), 0);
+    network->executeBatch<std::string>(requests, BatchOptions{4, 2}, [&](std::size_t index, NetworkResult<std::string> result) {
+        EXPECT_TRUE(result.hasError);
+        std::lock_guard<std::mutex> lock(mutex);
+        ++seen[index];
+    });
+
+    for (int count : seen) {
+        EXPECT_EQ(count, 1);
+    }
+}
+
+TEST_F(NetworkTest, CancelledOrExpiredRequestsFailBeforeStarting) {
+    RequestConfig cancelled;
+    cancelled.url = "http://127.0.0.1:1/";
+    cancelled.cancellation = std::make_shared<CancellationToken>();
+    cancelled.cancellation->cancel();
+
+    RequestConfig expired;
+    expired.url = "http://127.0.0.1:1/";
+    expired.deadline = std::chrono::steady_clock::now() - std::chrono::milliseconds(1);
+
+    EXPECT_EQ(network->execute(cancelled).errorMessage, "Request cancelled");
+    EXPECT_EQ(network->execute(expired).errorMessage, "Deadline exceeded");
+
+    network->setAsyncEngine(AsyncEngine::Multi, 1);
+    EXPECT_EQ(network->executeAsync(cancelled).get().errorMessage, "Request cancelled");
+
+    // Neither is retried
+    RetryConfig retryConfig;
+    retryConfig.config = expired;
+    retryConfig.maxRetries = 5;
+    retryConfig.retryDelay = std::chrono::milliseconds(1);
+    EXPECT_EQ(network->executeWithRetry(retryConfig).errorMessage, "Deadline exceeded");
+    EXPECT_EQ(network->metrics().retries, 0);
+}
+
+TEST_F(NetworkTest, ExecuteBatchCancelOnErrorStopsTheRest) {
+    std::vector<RequestConfig> requests(5);
+    for (auto &request : requests) {
+        request.url = "http://127.0.0.1:1/"; // Connection refused
+    }
+
+    BatchOptions options;
+    options.maxConcurrency = 1;
+    options.cancelOnError = true;
+    auto results = network->executeBatch(requests, options);
+
+    ASSERT_EQ(results.size(), requests.size());
+    EXPECT_TRUE(results[0].hasError);
+    EXPECT_NE(results[0].errorMessage, "Request cancelled");
+    for (std::size_t i = 1; i < results.size(); ++i) {
+        EXPECT_EQ(results[i].errorMessage, "Request cancelled");
+    }
+}
+
 // ============================================================================
 // Network request tests (require actual network connection)
 // ============================================================================
@@ -437,6 +1613,11 @@ public:
     std::vector<std::string> infoMessages;
     std::vector<std::string> warnMessages;
     std::vector<std::string> debugMessages;
+    log::Level minLevel = log::Level::Debug;
+
+    bool enabled(log::Level level) const override {
+        return level >= minLevel;
+    }
 
     void error(const std::string &msg) override {
         errorMessages.push_back(msg);
@@ -506,6 +1687,40 @@ TEST(CustomLoggerTest, NetworkCanUseCustomLoggerInstance) {
     EXPECT_NE(testLogger, nullptr);
 }
 
+TEST(CustomLoggerTest, DisabledLevelsAreNotLogged) {
+    auto testLogger = std::make_shared<TestLogger>();
+    testLogger->minLevel = log::Level::Error;
+    Network network(executor::createExecutor(), testLogger);
+
+    RequestConfig config;
+    config.url = "invalid-url";
+    auto result = network.execute(config);
+
+    EXPECT_TRUE(result.hasError);
+    EXPECT_FALSE(testLogger->errorMessages.empty());
+    EXPECT_TRUE(testLogger->infoMessages.empty());
+    EXPECT_TRUE(testLogger->warnMessages.empty());
+    EXPECT_TRUE(testLogger->debugMessages.empty());
+
+    // Enabled levels are still delivered
+    testLogger->clear();
+    testLogger->minLevel = log::Level::Debug;
+    network.execute(config);
+    EXPECT_FALSE(testLogger->infoMessages.empty());
+}
+
+TEST(CustomLoggerTest, DefaultLoggerFiltersByLevel) {
+    log::DefaultLogger logger(log::Level::Warn);
+
+    EXPECT_FALSE(logger.enabled(log::Level::Debug));
+    EXPECT_FALSE(logger.enabled(log::Level::Info));
+    EXPECT_TRUE(logger.enabled(log::Level::Warn));
+    EXPECT_TRUE(logger.enabled(log::Level::Error));
+
+    logger.setLevel(log::Level::Off);
+    EXPECT_FALSE(logger.enabled(log::Level::Error));
+}
+
 TEST(CustomLoggerTest, LoggerFactoryCanBeReset) {
     // Save original factory
     auto originalFactory = log::getLoggerFactory();
@@ -535,12 +1750,10 @@ class TestExecutor : public executor::IAsyncExecutor {
 public:
     std::atomic<int> taskCount{0};
 
-    // Override the submit method (non-template version)
-    template <typename F>
-    auto submit(F &&f) -> std::future<decltype(f())> {
+    // Override the type-erased submission hook, submit() builds on top of it
+    void post(std::function<void()> task) override {
         taskCount++;
-        // Use std::async for testing purposes
-        return std::async(std::launch::async, std::forward<F>(f));
+        std::thread(std::move(task)).detach();
     }
 };
 
@@ -622,6 +1835,58 @@ TEST(CustomExecutorTest, ExecutorCanSubmitMultipleTasks) {
     EXPECT_GE(testExecutor->taskCount.load(), 10);
 }
 
+TEST(CustomExecutorTest, NetworkDispatchesAsyncRequestsThroughCustomExecutor) {
+    auto testExecutor = std::make_shared<TestExecutor>();
+    Network network(testExecutor, log::createLogger());
+
+    RequestConfig config;
+    config.url = "";
+    auto result = network.executeAsync(config).get();
+
+    EXPECT_TRUE(result.hasError);
+    EXPECT_EQ(testExecutor->taskCount.load(), 1);
+}
+
+TEST(ThreadPoolExecutorTest, RunsAllTasksOnBoundedWorkers) {
+    auto pool = std::make_shared<executor::ThreadPoolExecutor>(4);
+    EXPECT_EQ(pool->threadCount(), 4);
+
+    std::mutex idsMutex;
+    std::set<std::thread::id> threadIds;
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 100; ++i) {
+        futures.push_back(pool->submit([i, &idsMutex, &threadIds]() {
+            std::lock_guard<std::mutex> lock(idsMutex);
+            threadIds.insert(std::this_thread::get_id());
+            return i;
+        }));
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(futures[i].get(), i);
+    }
+    EXPECT_LE(threadIds.size(), 4);
+}
+
+TEST(ThreadPoolExecutorTest, PropagatesExceptionsThroughFuture) {
+    executor::ThreadPoolExecutor pool(1);
+
+    auto future = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+
+    EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+TEST(ThreadPoolExecutorTest, DrainsQueuedTasksOnDestruction) {
+    std::atomic<int> completed{0};
+    {
+        executor::ThreadPoolExecutor pool(1);
+        for (int i = 0; i < 10; ++i) {
+            pool.post([&completed]() { completed++; });
+        }
+    }
+    EXPECT_EQ(completed.load(), 10);
+}
+
 // ============================================================================
 // Global Configuration tests
 // ============================================================================
@@ -929,6 +2194,409 @@ TEST(CustomResponseTypeTest, SuccessStateIndependentOfType) {
     EXPECT_FALSE(binaryResult.isSuccess());
 }
 
+namespace {
+    // Records what the library does with it
+    struct RecordingSink {
+        neko::uint64 reserved = 0;
+        std::string data;
+        bool finalized = false;
+    };
+} // namespace
+
+template <>
+struct neko::network::ResponseSink<RecordingSink> {
+    static void reserve(RecordingSink &sink, neko::uint64 size) { sink.reserved = size; }
+    static bool append(RecordingSink &sink, const char *data, neko::uint64 size) {
+        sink.data.append(data, size);
+        return true;
+    }
+    static void finalize(RecordingSink &sink) { sink.finalized = true; }
+};
+
+TEST(CustomResponseTypeTest, BuiltInTypesAreResponseSinks) {
+    static_assert(ResponseSinkType<std::string> && ResponseSinkType<std::vector<char>> && ResponseSinkType<std::fstream>);
+    static_assert(ResponseSinkType<RecordingSink> && !ResponseSinkType<int>);
+
+    std::vector<char> buffer;
+    ResponseSink<std::vector<char>>::reserve(buffer, 64);
+    EXPECT_TRUE(ResponseSink<std::vector<char>>::append(buffer, "abc", 3));
+    EXPECT_GE(buffer.capacity(), 64u);
+    EXPECT_EQ(std::string(buffer.begin(), buffer.end()), "abc");
+}
+
+TEST_F(NetworkTest, ExecuteIntoReportsErrorsWithoutFinalizing) {
+    RequestConfig config;
+    config.url = "http://127.0.0.1:1/"; // Connection refused
+
+    auto result = network->executeInto<RecordingSink>(config);
+    EXPECT_TRUE(result.hasError);
+    EXPECT_FALSE(result.content.finalized);
+
+    std::promise<NetworkResult<RecordingSink>> promise;
+    network->executeIntoAsync<RecordingSink>(config, [&promise](NetworkResult<RecordingSink> result) {
+        promise.set_value(std::move(result));
+    });
+    auto asyncResult = promise.get_future().get();
+    EXPECT_TRUE(asyncResult.hasError);
+    EXPECT_TRUE(asyncResult.content.data.empty());
+}
+
+TEST_F(NetworkTest, ExecuteIntoReservesAppendsAndFinalizes) {
+    bench::LoopbackServer server(0);
+    constexpr std::size_t size = 300 * 1024;
+    RequestConfig config;
+    config.url = server.url("/bytes/" + std::to_string(size));
+
+    auto result = network->executeInto<RecordingSink>(config);
+    ASSERT_EQ(result.statusCode, 200);
+    EXPECT_EQ(result.content.reserved, size); // From Content-Length, before the first append
+    EXPECT_TRUE(result.content.finalized);
+    EXPECT_EQ(result.content.data, loopbackBytes(size));
+}
+
+TEST(BufferPoolTest, ReleasedBlocksAreReusedAndTrimmed) {
+    auto pool = std::make_shared<BufferPool>();
+
+    auto small = pool->acquire(5000);
+    EXPECT_EQ(small.capacity(), 8u * 1024); // Rounded up to its size class
+    small.append("abc", 3);
+    small.append("def", 3);
+    EXPECT_EQ(small.view(), "abcdef");
+
+    // Above the thread caches, so the free lists show in the stats
+    constexpr std::size_t largeSize = 1024 * 1024;
+    {
+        auto large = pool->acquire(largeSize);
+        EXPECT_EQ(large.capacity(), largeSize);
+    }
+    auto stats = pool->stats();
+    EXPECT_EQ(stats.cachedBytes, largeSize);
+
+    auto again = pool->acquire(largeSize - 1);
+    EXPECT_EQ(pool->stats().reuses, stats.reuses + 1);
+    EXPECT_EQ(pool->stats().cachedBytes, 0u);
+
+    again = PooledBuffer(); // Moving over a buffer releases its block
+    EXPECT_EQ(pool->stats().cachedBytes, largeSize);
+    pool->trim();
+    EXPECT_EQ(pool->stats().cachedBytes, 0u);
+}
+
+TEST(BufferPoolTest, CachedBytesStayWithinTheLimit) {
+    constexpr std::size_t largeSize = 1024 * 1024;
+    auto pool = std::make_shared<BufferPool>(largeSize);
+    {
+        auto first = pool->acquire(largeSize);
+        auto second = pool->acquire(largeSize);
+    }
+    EXPECT_EQ(pool->stats().cachedBytes, largeSize);
+    EXPECT_EQ(pool->stats().allocations, 2u);
+
+    // A buffer without a pool allocates its storage on its own
+    PooledBuffer unpooled;
+    unpooled.append("xyz", 3);
+    EXPECT_EQ(unpooled.view(), "xyz");
+}
+
+TEST_F(NetworkTest, PooledBufferResultsUseTheBufferPool) {
+    ASSERT_NE(network->getBufferPool(), nullptr);
+    auto pool = std::make_shared<BufferPool>();
+    network->setBufferPool(pool);
+    EXPECT_EQ(network->getBufferPool(), pool);
+
+    RequestConfig config;
+    config.url = "http://127.0.0.1:1/"; // Connection refused
+    auto result = network->execute<PooledBuffer>(config);
+    EXPECT_TRUE(result.hasError);
+    EXPECT_FALSE(result.hasContent());
+
+    network->setBufferPool(nullptr);
+    auto future = network->executeAsync<PooledBuffer>(config);
+    EXPECT_TRUE(future.get().hasError);
+}
+
+TEST_F(NetworkTest, PooledBufferResultsReuseTheirStorage) {
+    bench::LoopbackServer server(0);
+    constexpr std::size_t size = 100 * 1024;
+    auto pool = std::make_shared<BufferPool>();
+    network->setBufferPool(pool);
+
+    RequestConfig config;
+    config.url = server.url("/bytes/" + std::to_string(size));
+    {
+        auto result = network->execute<PooledBuffer>(config);
+        ASSERT_EQ(result.statusCode, 200);
+        EXPECT_EQ(result.content.view(), loopbackBytes(size));
+    } // Storage goes back to the pool
+    auto reusesBefore = pool->stats().reuses;
+    auto allocationsBefore = pool->stats().allocations;
+
+    auto result = network->execute<PooledBuffer>(config);
+    ASSERT_EQ(result.statusCode, 200);
+    EXPECT_EQ(result.content.view(), loopbackBytes(size));
+    EXPECT_GT(pool->stats().reuses, reusesBefore);
+    EXPECT_EQ(pool->stats().allocations, allocationsBefore);
+}
+
+// ============================================================================
+// Download manager tests
+// ============================================================================
+
+TEST(BandwidthLimiterTest, WaitsOnceTheRateIsExceeded) {
+    auto global = std::make_shared<BandwidthLimiter>(1024 * 1024);
+    BandwidthLimiter job(0, global);
+
+    // Nothing saved up at the start, a full second worth of data must wait about a second
+    auto wait = job.consume(1024 * 1024);
+    EXPECT_GT(wait, std::chrono::milliseconds(800));
+    EXPECT_LE(wait, std::chrono::milliseconds(1000));
+
+    global->setRate(0);
+    EXPECT_EQ(job.consume(1024 * 1024), std::chrono::steady_clock::duration::zero());
+}
+
+TEST_F(NetworkTest, DownloadManagerFinishesEveryJob) {
+    DownloadManagerOptions options;
+    options.maxConcurrentJobs = 1;
+    options.bandwidthLimit = 512 * 1024;
+    DownloadManager manager(*network, options);
+    EXPECT_EQ(manager.getConcurrency(), 1u);
+    EXPECT_EQ(manager.getBandwidthLimit(), 512u * 1024);
+
+    MultiDownloadConfig failing;
+    failing.config.url = "http://127.0.0.1:1/file"; // Connection refused
+    failing.config.fileName = (std::filesystem::temp_directory_path() / "neko_manager_test.bin").string();
+
+    MultiDownloadConfig cancelled = failing;
+    cancelled.config.cancellation = std::make_shared<CancellationToken>();
+    cancelled.config.cancellation->cancel();
+
+    auto first = manager.enqueue(failing, 0, 64 * 1024);
+    auto second = manager.enqueue(cancelled, 10);
+    EXPECT_EQ(first->getBandwidthLimit(), 64u * 1024);
+    EXPECT_FALSE(first->wait());
+    EXPECT_FALSE(second->wait());
+    EXPECT_EQ(first->getState(), DownloadState::Failed);
+    EXPECT_EQ(second->getState(), DownloadState::Cancelled);
+
+    manager.waitIdle();
+    EXPECT_EQ(manager.queuedJobs(), 0u);
+    EXPECT_EQ(manager.runningJobs(), 0u);
+}
+
+TEST_F(NetworkTest, DownloadManagerStartsJobsByPriorityThenOrder) {
+    bench::LoopbackServer server(256 * 1024);
+    DownloadManagerOptions options;
+    options.maxConcurrentJobs = 1;
+    DownloadManager manager(*network, options);
+
+    std::mutex mutex;
+    std::vector<std::string> started;
+    auto download = [&](const std::string &name) {
+        MultiDownloadConfig config;
+        config.config.url = server.url("/object");
+        config.config.fileName = (std::filesystem::temp_directory_path() / ("neko_manager_" + name + ".bin")).string();
+        config.config.progressCallback = [&mutex, &started, name](neko::uint64) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (std::find(started.begin(), started.end(), name) == started.end())
+                started.push_back(name);
+        };
+        return config;
+    };
+
+    // A slow job holds the only slot until the others are queued
+    auto gate = manager.enqueue(download("gate"), 100, 16 * 1024);
+    while (gate->getState() == DownloadState::Queued) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::vector<std::shared_ptr<DownloadJob>> jobs = {
+        manager.enqueue(download("a"), 0), manager.enqueue(download("b"), 5),
+        manager.enqueue(download("c"), 0), manager.enqueue(download("d"), 5)};
+    EXPECT_EQ(manager.queuedJobs(), 4u);
+    gate->cancel();
+
+    EXPECT_FALSE(gate->wait());
+    EXPECT_EQ(gate->getState(), DownloadState::Cancelled);
+    for (const auto &job : jobs) {
+        EXPECT_TRUE(job->wait());
+    }
+    std::erase(started, "gate");
+    EXPECT_EQ(started, (std::vector<std::string>{"b", "d", "a", "c"}));
+    for (const auto &name : {"gate", "a", "b", "c", "d"}) {
+        std::filesystem::remove(std::filesystem::temp_directory_path() / ("neko_manager_" + std::string(name) + ".bin"));
+    }
+}
+
+TEST_F(NetworkTest, DownloadManagerJobKeepsToItsCap) {
+    constexpr neko::uint64 size = 2 * 1024 * 1024;
+    bench::LoopbackServer server(size);
+    DownloadManager manager(*network);
+
+    MultiDownloadConfig config;
+    config.config.url = server.url("/object");
+    config.config.fileName = (std::filesystem::temp_directory_path() / "neko_manager_capped.bin").string();
+    auto start = std::chrono::steady_clock::now();
+    auto job = manager.enqueue(config, 0, 1024 * 1024);
+    ASSERT_TRUE(job->wait());
+
+    // size / rate is 2 seconds, less the burst the bucket allows
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GT(elapsed, std::chrono::milliseconds(1700));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(3000));
+    EXPECT_TRUE(matchesLoopbackObject(config.config.fileName, size));
+    std::filesystem::remove(config.config.fileName);
+}
+
+TEST_F(NetworkTest, DownloadManagerProgressEndsAtTheFileSize) {
+    constexpr neko::uint64 size = 8 * 1024 * 1024 + 123;
+    bench::LoopbackServer server(size);
+    DownloadManager manager(*network);
+
+    for (auto approach : {MultiDownloadConfig::Size, MultiDownloadConfig::Adaptive}) {
+        SCOPED_TRACE(approach);
+        std::mutex mutex;
+        std::vector<neko::uint64> reports;
+        MultiDownloadConfig config;
+        config.config.url = server.url("/object");
+        config.config.fileName = (std::filesystem::temp_directory_path() / "neko_manager_progress.bin").string();
+        config.approach = approach;
+        config.segmentParam = approach == MultiDownloadConfig::Size ? 1024 * 1024 : 4;
+        config.config.progressCallback = [&mutex, &reports](neko::uint64 bytes) {
+            std::lock_guard<std::mutex> lock(mutex);
+            reports.push_back(bytes);
+        };
+
+        auto job = manager.enqueue(config);
+        ASSERT_TRUE(job->wait());
+        EXPECT_EQ(job->getState(), DownloadState::Completed);
+        EXPECT_EQ(job->getDownloadedBytes(), size);
+        ASSERT_FALSE(reports.empty());
+        EXPECT_EQ(reports.back(), size);
+        EXPECT_TRUE(std::is_sorted(reports.begin(), reports.end()));
+        std::filesystem::remove(config.config.fileName);
+    }
+}
+
+TEST_F(NetworkTest, DownloadManagerSlowsRunningJobsWhileRequestsAreSlow) {
+    constexpr neko::uint64 rate = 4 * 1024 * 1024;
+    bench::LoopbackServer server(64 * 1024 * 1024);
+    DownloadManagerOptions options;
+    options.bandwidthLimit = rate;
+    options.latencyTarget = std::chrono::milliseconds(1);
+    options.adjustInterval = std::chrono::milliseconds(100);
+    DownloadManager manager(*network, options);
+
+    MultiDownloadConfig config;
+    config.config.url = server.url("/object");
+    config.config.fileName = (std::filesystem::temp_directory_path() / "neko_manager_backoff.bin").string();
+    config.approach = MultiDownloadConfig::Thread;
+    config.segmentParam = 2;
+    auto job = manager.enqueue(config);
+
+    // Interactive requests of 20ms are over the target, the running job must give way
+    std::atomic<bool> slowRequests{true};
+    std::thread interactive([&]() {
+        RequestConfig request;
+        request.url = server.url("/slow/20");
+        while (slowRequests.load()) {
+            network->execute(request);
+        }
+    });
+    auto waitFor = [](auto condition) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!condition() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return condition();
+    };
+    EXPECT_TRUE(waitFor([&]() { return manager.getBackoffRate() > 0; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_LT(manager.getBackoffRate(), rate / 8);
+    EXPECT_EQ(manager.getBandwidthLimit(), rate);
+    neko::uint64 before = job->getDownloadedBytes();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    EXPECT_LT(job->getDownloadedBytes() - before, rate / 2); // Half of what the cap alone allows
+
+    // Once requests are fast again, the rate recovers and the backoff ends
+    slowRequests = false;
+    interactive.join();
+    EXPECT_TRUE(waitFor([&]() { return manager.getBackoffRate() == 0; }));
+    job->cancel();
+    job->wait();
+    std::filesystem::remove(config.config.fileName);
+    std::filesystem::remove(config.config.fileName + ".nekopart");
+}
+
+#if defined(NEKO_NETWORK_USE_COROUTINES)
+// ============================================================================
+// Coroutine tests
+// ============================================================================
+
+namespace {
+    Task<int> valueTask(int value) {
+        co_return value;
+    }
+
+    Task<int> throwingTask() {
+        throw std::runtime_error("task failed");
+        co_return 0;
+    }
+
+    Task<int> sumTask() {
+        std::vector<Task<int>> tasks;
+        for (int i = 1; i <= 3; ++i) {
+            tasks.push_back(valueTask(i));
+        }
+        auto values = co_await whenAll(std::move(tasks));
+        co_return values[0] + values[1] + values[2];
+    }
+} // namespace
+
+TEST(TaskTest, CombinatorsDeliverResultsAndExceptions) {
+    EXPECT_EQ(syncWait(valueTask(42)), 42);
+    EXPECT_EQ(syncWait(sumTask()), 6);
+    EXPECT_TRUE(syncWait(whenAll(std::vector<Task<int>>{})).empty());
+
+    std::vector<Task<int>> tasks;
+    tasks.push_back(valueTask(7));
+    tasks.push_back(valueTask(8));
+    auto first = syncWait(whenAny(std::move(tasks)));
+    EXPECT_EQ(first.index, 0);
+    EXPECT_EQ(first.value, 7);
+
+    EXPECT_THROW(syncWait(throwingTask()), std::runtime_error);
+    EXPECT_THROW(syncWait(whenAny(std::vector<Task<int>>{})), std::invalid_argument);
+
+    std::vector<Task<int>> failing;
+    failing.push_back(valueTask(1));
+    failing.push_back(throwingTask());
+    EXPECT_THROW(syncWait(whenAll(std::move(failing))), std::runtime_error);
+}
+
+TEST_F(NetworkTest, RequestCoroutineResumesWithResults) {
+    RequestConfig config;
+    config.url = "http://127.0.0.1:1/";
+
+    auto result = syncWait(network->request(config));
+    EXPECT_TRUE(result.hasError);
+
+    std::vector<Task<NetworkResult<std::string>>> requests;
+    for (int i = 0; i < 4; ++i) {
+        requests.push_back(network->request(config));
+    }
+    for (auto &each : syncWait(whenAll(std::move(requests)))) {
+        EXPECT_TRUE(each.hasError);
+    }
+
+    RetryConfig retryConfig;
+    retryConfig.config = config;
+    retryConfig.maxRetries = 2;
+    retryConfig.retryDelay = std::chrono::milliseconds(1);
+    EXPECT_EQ(syncWait(network->requestWithRetry(retryConfig)).errorMessage, "All retry attempts failed");
+}
+
+#endif // NEKO_NETWORK_USE_COROUTINES
+
 // ============================================================================
 // Main function to run all tests
 // ============================================================================